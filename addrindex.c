@@ -0,0 +1,246 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    GElf_Addr start;
+    GElf_Addr end;
+    const char *name;
+    size_t order;
+} addr_symbol;
+
+static void * alloc_addr_array(const size_t count, const size_t item_size)
+{
+    void *array = malloc((count > 0 ? count : 1) * item_size);
+
+    if (array == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the address index for %zu items.", count);
+    }
+
+    return array;
+}
+
+// Symbols which cover bytes of the image: functions and data objects with a size
+static bool is_addr_symbol(const GElf_Sym *sym)
+{
+    int sym_type = GELF_ST_TYPE(sym->st_info);
+
+    if ((sym_type != STT_FUNC) && (sym_type != STT_OBJECT) && (sym_type != STT_GNU_IFUNC))
+    {
+        return false;
+    }
+
+    return (sym->st_shndx != SHN_UNDEF) && (sym->st_shndx != SHN_ABS) && (sym->st_size > 0) && (sym->st_value + sym->st_size > sym->st_value);
+}
+
+static size_t collect_symbols(const efb_file *file, const GElf_Word sect_type, addr_symbol *symbols)
+{
+    const efb_sect_table *sections = &file->sections;
+    size_t symbol_count = 0;
+
+    for (size_t sect_idx = 1; sect_idx < sections->count; sect_idx++)
+    {
+        if ((sections->type[sect_idx] != sect_type) || (sections->entsize[sect_idx] == 0))
+        {
+            continue;
+        }
+
+        Elf_Data *sym_data = efb_elf_getdata(sections->scn[sect_idx], NULL);
+        Elf_Data *str_data = NULL;
+
+        if (sections->link[sect_idx] < sections->count)
+        {
+            str_data = efb_elf_getdata(sections->scn[sections->link[sect_idx]], NULL);
+        }
+
+        if (sym_data == NULL)
+        {
+            continue;
+        }
+
+        size_t sym_count = sym_data->d_size / sections->entsize[sect_idx];
+        for (size_t sym_idx = 1; sym_idx < sym_count; sym_idx++)
+        {
+            GElf_Sym sym;
+            if ((gelf_getsym(sym_data, sym_idx, &sym) != &sym) || (is_addr_symbol(&sym) == false))
+            {
+                continue;
+            }
+
+            if (symbols != NULL)
+            {
+                symbols[symbol_count] = (addr_symbol) { sym.st_value, sym.st_value + sym.st_size, efb_get_sym_name(str_data, sym.st_name), symbol_count };
+            }
+
+            symbol_count++;
+        }
+    }
+
+    return symbol_count;
+}
+
+// By start address; an enclosing symbol comes before the symbols nested in it
+static int compare_symbols(const void *left, const void *right)
+{
+    const addr_symbol *left_sym = left;
+    const addr_symbol *right_sym = right;
+
+    if (left_sym->start != right_sym->start)
+    {
+        return (left_sym->start < right_sym->start) ? -1 : 1;
+    }
+
+    if (left_sym->end != right_sym->end)
+    {
+        return (left_sym->end > right_sym->end) ? -1 : 1;
+    }
+
+    return (left_sym->order < right_sym->order) ? -1 : (left_sym->order > right_sym->order);
+}
+
+static void add_interval(efb_addr_index *index, const GElf_Addr start, const GElf_Addr end, const addr_symbol *symbol)
+{
+    if (start >= end)
+    {
+        return;
+    }
+
+    // The rest of a symbol after a nested symbol continues its previous interval if nothing lies between them
+    size_t last_idx = index->count - 1;
+    if ((index->count > 0) && (index->end[last_idx] == start) && (index->sym_addr[last_idx] == symbol->start)
+        && (index->name[last_idx] == symbol->name))
+    {
+        index->end[last_idx] = end;
+        return;
+    }
+
+    index->start[index->count] = start;
+    index->end[index->count] = end;
+    index->sym_addr[index->count] = symbol->start;
+    index->name[index->count] = symbol->name;
+    index->count++;
+}
+
+// Emits the intervals up to limit, closing the symbols which end before it
+static void flush_open_symbols(efb_addr_index *index, const addr_symbol **open_symbols, size_t *open_count,
+    GElf_Addr *cursor, const GElf_Addr limit)
+{
+    while ((*open_count > 0) && (open_symbols[*open_count - 1]->end <= limit))
+    {
+        const addr_symbol *symbol = open_symbols[--(*open_count)];
+
+        if (symbol->end > *cursor)
+        {
+            add_interval(index, *cursor, symbol->end, symbol);
+            *cursor = symbol->end;
+        }
+    }
+
+    if ((*open_count > 0) && (*cursor < limit))
+    {
+        add_interval(index, *cursor, limit, open_symbols[*open_count - 1]);
+        *cursor = limit;
+    }
+}
+
+// Flattens the symbols of the symbol tables into sorted, disjoint address intervals.
+// Where symbols overlap, the innermost one (the one which starts last) names the bytes.
+void efb_addr_index_build(const efb_file *file, efb_addr_index *index)
+{
+    // .dynsym is a subset of .symtab, so it is only used when the file is stripped
+    GElf_Word sect_type = SHT_SYMTAB;
+    size_t symbol_count = collect_symbols(file, sect_type, NULL);
+
+    if (symbol_count == 0)
+    {
+        sect_type = SHT_DYNSYM;
+        symbol_count = collect_symbols(file, sect_type, NULL);
+    }
+
+    addr_symbol *symbols = alloc_addr_array(symbol_count, sizeof(addr_symbol));
+    const addr_symbol **open_symbols = alloc_addr_array(symbol_count, sizeof(addr_symbol *));
+
+    collect_symbols(file, sect_type, symbols);
+    qsort(symbols, symbol_count, sizeof(addr_symbol), compare_symbols);
+
+    // Every symbol adds at most two intervals: its start and the rest after a nested symbol
+    size_t capacity = 2 * symbol_count + 1;
+    index->count = 0;
+    index->start = alloc_addr_array(capacity, sizeof(GElf_Addr));
+    index->end = alloc_addr_array(capacity, sizeof(GElf_Addr));
+    index->sym_addr = alloc_addr_array(capacity, sizeof(GElf_Addr));
+    index->name = alloc_addr_array(capacity, sizeof(char *));
+
+    size_t open_count = 0;
+    GElf_Addr cursor = 0;
+
+    for (size_t sym_idx = 0; sym_idx < symbol_count; sym_idx++)
+    {
+        const addr_symbol *symbol = &symbols[sym_idx];
+
+        // Aliases of the same range keep the first name
+        if ((open_count > 0) && (open_symbols[open_count - 1]->start == symbol->start)
+            && (open_symbols[open_count - 1]->end == symbol->end))
+        {
+            continue;
+        }
+
+        flush_open_symbols(index, open_symbols, &open_count, &cursor, symbol->start);
+        cursor = symbol->start;
+        open_symbols[open_count++] = symbol;
+    }
+
+    flush_open_symbols(index, open_symbols, &open_count, &cursor, UINT64_MAX);
+
+    free(open_symbols);
+    free(symbols);
+}
+
+void efb_addr_index_free(efb_addr_index *index)
+{
+    free(index->start);
+    free(index->end);
+    free(index->sym_addr);
+    free(index->name);
+    memset(index, 0, sizeof(efb_addr_index));
+}
+
+// Finds the interval which contains addr or, failing that, the first one which starts below limit
+bool efb_addr_index_lookup(const efb_addr_index *index, const GElf_Addr addr, const GElf_Addr limit, size_t *interval_idx)
+{
+    size_t low = 0;
+    size_t high = index->count;
+
+    // The first interval which starts above addr
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (index->start[middle] <= addr)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if ((low > 0) && (addr < index->end[low - 1]))
+    {
+        *interval_idx = low - 1;
+        return true;
+    }
+
+    if ((low < index->count) && (index->start[low] < limit))
+    {
+        *interval_idx = low;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,244 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VIEW_WRITE_ROWS 4096
+
+static void * grow_array(void *array, size_t *capacity, const size_t required, const size_t item_size)
+{
+    if (required <= *capacity)
+    {
+        return array;
+    }
+
+    size_t new_capacity = (*capacity == 0) ? 16 : *capacity * 2;
+    if (new_capacity < required)
+    {
+        new_capacity = required;
+    }
+
+    void *new_array = realloc(array, new_capacity * item_size);
+    if (new_array == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot grow the content view to %zu items.", new_capacity);
+    }
+
+    *capacity = new_capacity;
+    return new_array;
+}
+
+static void add_block(efb_view *view, const efb_view_block *block)
+{
+    view->blocks = grow_array(view->blocks, &view->block_capacity, view->block_count + 1, sizeof(efb_view_block));
+    view->blocks[view->block_count++] = *block;
+    view->row_count += block->row_count;
+}
+
+// Turns the lines of the text appended since the last call into a text block; the lines are indexed
+// as the text is written. A trailing line without '\n' is only taken when the view is being finished.
+static void close_text_block(efb_view *view, const bool take_partial_line)
+{
+    size_t first_line = view->text_line_count;
+    size_t text_scanned = (view->text.line_count > 0) ? view->text.line_ends[view->text.line_count - 1] : 0;
+
+    view->text_line_count = view->text.line_count;
+    if (take_partial_line && (text_scanned < view->text.length))
+    {
+        view->text_line_count++;
+    }
+
+    if (view->text_line_count > first_line)
+    {
+        add_block(view, &(efb_view_block) {
+            .first_row = view->row_count,
+            .row_count = view->text_line_count - first_line,
+            .first_text_line = first_line,
+        });
+    }
+}
+
+static size_t get_text_line_start(const efb_view *view, const size_t line)
+{
+    return (line > 0) ? view->text.line_ends[line - 1] : 0;
+}
+
+void efb_view_init(efb_view *view)
+{
+    memset(view, 0, sizeof(efb_view));
+    efb_buf_init(&view->text);
+    efb_buf_index_lines(&view->text);
+}
+
+void efb_view_reset(efb_view *view)
+{
+    for (size_t idx = 0; idx < view->block_count; idx++)
+    {
+        efb_row_source *source = &view->blocks[idx].source;
+        if ((source->render_rows != NULL) && (source->release != NULL))
+        {
+            source->release(source->rows_data);
+        }
+    }
+
+    efb_buf_reset(&view->text);
+    view->text_line_count = 0;
+    view->block_count = 0;
+    view->row_count = 0;
+    view->rows_data_size = 0;
+}
+
+void efb_view_free(efb_view *view)
+{
+    efb_view_reset(view);
+    efb_buf_free(&view->text);
+    free(view->blocks);
+    memset(view, 0, sizeof(efb_view));
+}
+
+void efb_view_add_rows(efb_view *view, const efb_row_source *source)
+{
+    close_text_block(view, false);
+
+    if (source->row_count > 0)
+    {
+        view->rows_data_size += source->rows_data_size;
+        add_block(view, &(efb_view_block) {
+            .first_row = view->row_count,
+            .row_count = source->row_count,
+            .source = *source,
+        });
+    }
+    else if (source->release != NULL)
+    {
+        source->release(source->rows_data);
+    }
+}
+
+void efb_view_finish(efb_view *view)
+{
+    close_text_block(view, true);
+}
+
+static const efb_view_block * find_block(const efb_view *view, const size_t row)
+{
+    size_t low = 0;
+    size_t high = view->block_count;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (view->blocks[mid].first_row + view->blocks[mid].row_count <= row)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return (low < view->block_count) ? &view->blocks[low] : NULL;
+}
+
+void efb_view_render_rows(const efb_view *view, const size_t first_row, const size_t row_count, efb_buffer *out_buffer)
+{
+    size_t row = first_row;
+    size_t last_row = first_row + row_count;
+
+    if (last_row > view->row_count)
+    {
+        last_row = view->row_count;
+    }
+
+    while (row < last_row)
+    {
+        const efb_view_block *block = find_block(view, row);
+        size_t block_row = row - block->first_row;
+        size_t block_rows = block->row_count - block_row;
+
+        if (block_rows > last_row - row)
+        {
+            block_rows = last_row - row;
+        }
+
+        if (block->source.render_rows != NULL)
+        {
+            block->source.render_rows(block->source.rows_data, block_row, block_rows, out_buffer);
+        }
+        else
+        {
+            size_t first_line = block->first_text_line + block_row;
+            size_t text_start = get_text_line_start(view, first_line);
+            size_t text_end = (first_line + block_rows <= view->text.line_count) ?
+                get_text_line_start(view, first_line + block_rows) : view->text.length;
+
+            efb_buf_append(out_buffer, &view->text.data[text_start], text_end - text_start);
+            if ((text_end == view->text.length) && ((text_end == text_start) || (view->text.data[text_end - 1] != '\n')))
+            {
+                efb_buf_putc(out_buffer, '\n');
+            }
+        }
+
+        row += block_rows;
+    }
+}
+
+// Writes all rows of the view in chunks of VIEW_WRITE_ROWS, so only one chunk is formatted at a time;
+// returns false on a write error
+bool efb_view_write(const efb_view *view, FILE *stream)
+{
+    efb_buffer chunk;
+    bool written = true;
+
+    efb_buf_init(&chunk);
+
+    for (size_t row = 0; (row < view->row_count) && written; row += VIEW_WRITE_ROWS)
+    {
+        efb_buf_reset(&chunk);
+        efb_view_render_rows(view, row, VIEW_WRITE_ROWS, &chunk);
+        written = (fwrite(chunk.data, 1, chunk.length, stream) == chunk.length);
+    }
+
+    efb_buf_free(&chunk);
+    return written;
+}
+
+// Switches the sortable rows of the view to their next sort order; returns false if the view has none
+bool efb_view_sort(efb_view *view)
+{
+    for (size_t idx = 0; idx < view->block_count; idx++)
+    {
+        efb_row_source *source = &view->blocks[idx].source;
+        if (source->sort_rows != NULL)
+        {
+            size_t order_size = source->sort_rows(source->rows_data);
+
+            source->rows_data_size += order_size;
+            view->rows_data_size += order_size;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Finds the row showing the symbol / file offset / address; returns false if no rows of the view show it
+bool efb_view_locate(const efb_view *view, const efb_locate_kind kind, const uint64_t value, size_t *row)
+{
+    for (size_t idx = 0; idx < view->block_count; idx++)
+    {
+        const efb_view_block *block = &view->blocks[idx];
+        size_t block_row;
+
+        if ((block->source.locate_row != NULL) && block->source.locate_row(block->source.rows_data, kind, value, &block_row))
+        {
+            *row = block->first_row + block_row;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -1,9 +1,13 @@
 #include "elfibia.h"
 
+#include <ctype.h>
 #include <curses.h>
-#include <menu.h>
+#include <err.h>
+#include <poll.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define STATUS_LINE_HEIGHT 1
 
@@ -13,6 +17,9 @@
 #define MENU_FIRST_COLUMN 0
 
 #define FIRST_MENU_INDEX 0
+#define MENU_ROWS (MENU_HEIGHT - 2)
+#define MENU_MARK " > "
+#define MENU_NAME_WIDTH 23
 
 #define CONTENT_BOX_FIRST_ROW (MENU_FIRST_ROW)
 #define CONTENT_BOX_FIRST_COLUMN (MENU_WIDTH)
@@ -25,254 +32,1061 @@
 #define CONTENT_WIDTH (CONTENT_BOX_WIDTH - 2 * CONTENT_INDENT)
 #define CONTENT_HEIGHT (CONTENT_BOX_HEIGHT - 2 * CONTENT_INDENT)
 
+#define RENDER_POLL_DELAY_MS 50
+#define PREFETCH_IDLE_DELAY_MS 300
+#define PROGRESS_BAR_WIDTH 40
+
+#define KEY_ESCAPE 27
+// Returned by read_key() when the viewed file has been written
+#define KEY_FILE_CHANGED (KEY_MAX + 1)
+#define ESCAPE_DELAY_MS 25
+#define SEARCH_QUERY_SIZE 256
+#define GOTO_QUERY_SIZE 32
+#define NO_MARK_ROW SIZE_MAX
+
+// What the goto prompt asks for
+typedef enum
+{
+    GOTO_NONE,
+    GOTO_LINE,
+    GOTO_OFFSET,
+    GOTO_ADDRESS
+} goto_kind;
+
 typedef struct
 {
     int menu_items_count;
-    int content_top_row;
-    int content_row_count;
-    item_data *it_data;
+    size_t content_top_row;
+    size_t content_row_count;
+    int content_item_idx;
+    bool content_prefetched;
+    size_t content_mark_row;
+    bool locate_pending;
+    efb_locate_kind locate_kind;
+    uint64_t locate_value;
+    bool position_pending;
+    size_t pending_top_row;
+    size_t pending_mark_row;
+    efb_view *content;
+    bool search_mode;
+    bool search_bytes;
+    bool search_pending;
+    bool search_running;
+    bool search_truncated;
+    char search_query[SEARCH_QUERY_SIZE];
+    size_t search_match_count;
+    size_t search_cursor;
+    size_t search_top_row;
+    efb_view *search_view;
+    goto_kind goto_mode;
+    bool goto_failed;
+    char goto_query[GOTO_QUERY_SIZE];
+    efb_buffer content_rows;
+    chtype *content_line;
     WINDOW *wnd_menu;
-    ITEM **menu_items;
-    MENU *main_menu;
+    int menu_selected_idx;
+    int menu_top_idx;
     WINDOW *wnd_content_box;
     WINDOW *wnd_content;
+    bool content_damaged;
+    const efb_view *drawn_view;
+    size_t drawn_top_row;
+    size_t drawn_mark_row;
 } efb_draw_context;
 
-static void init_view(efb_draw_context *draw_ctx, item_data *it_data, const int menu_items_count)
+static void init_view(efb_draw_context *draw_ctx, const int menu_items_count)
 {
-    draw_ctx->it_data = it_data;
     draw_ctx->menu_items_count = menu_items_count;
     initscr();
     cbreak();
     noecho();
     keypad(stdscr, TRUE);
+    set_escdelay(ESCAPE_DELAY_MS);
 
     start_color();
     init_pair(1, COLOR_WHITE, COLOR_GREEN);
     init_pair(2, COLOR_WHITE, COLOR_RED);
 
     draw_ctx->wnd_menu = NULL;
-    draw_ctx->menu_items = NULL;
+    draw_ctx->menu_selected_idx = FIRST_MENU_INDEX;
+    draw_ctx->menu_top_idx = FIRST_MENU_INDEX;
     draw_ctx->wnd_content_box = NULL;
     draw_ctx->wnd_content = NULL;
+    draw_ctx->content_damaged = true;
+    draw_ctx->drawn_view = NULL;
+    draw_ctx->content = NULL;
+    draw_ctx->content_mark_row = NO_MARK_ROW;
+    draw_ctx->locate_pending = false;
+    draw_ctx->position_pending = false;
+    draw_ctx->search_mode = false;
+    draw_ctx->search_running = false;
+    draw_ctx->search_view = NULL;
+    draw_ctx->goto_mode = GOTO_NONE;
+    draw_ctx->content_line = NULL;
+    efb_buf_init(&draw_ctx->content_rows);
+    efb_buf_index_lines(&draw_ctx->content_rows);
 }
 
 static void destroy_menu(efb_draw_context *draw_ctx)
 {
     if (draw_ctx->wnd_menu != NULL)
     {
-        for (int idx = 0; idx < draw_ctx->menu_items_count; idx++)
+        delwin(draw_ctx->wnd_menu);
+        draw_ctx->wnd_menu = NULL;
+    }
+}
+
+// Only the visible items are drawn; their names and types are read when they are drawn
+static void draw_menu(efb_draw_context *draw_ctx)
+{
+    int text_width = MENU_WIDTH - 2 - (int) strlen(MENU_MARK);
+
+    for (int row_idx = 0; row_idx < MENU_ROWS; row_idx++)
+    {
+        int item_idx = draw_ctx->menu_top_idx + row_idx;
+        bool selected = (item_idx == draw_ctx->menu_selected_idx);
+
+        wmove(draw_ctx->wnd_menu, row_idx + 1, 1);
+        if (item_idx >= draw_ctx->menu_items_count)
         {
-            free_item(draw_ctx->menu_items[idx]);
+            wprintw(draw_ctx->wnd_menu, "%*s", MENU_WIDTH - 2, "");
+            continue;
         }
 
-        unpost_menu(draw_ctx->main_menu);
-        free_menu(draw_ctx->main_menu);
+        item_data it_data;
+        efb_get_menu_item_data(item_idx, &it_data);
 
-        delwin(draw_ctx->wnd_menu);
-        free(draw_ctx->menu_items);
-        draw_ctx->wnd_menu = NULL;
-        draw_ctx->menu_items = NULL;
+        wprintw(draw_ctx->wnd_menu, "%s", selected ? MENU_MARK : "   ");
+        wattrset(draw_ctx->wnd_menu, selected ? A_REVERSE : A_NORMAL);
+        wprintw(draw_ctx->wnd_menu, "%-*.*s %-*.*s", MENU_NAME_WIDTH, MENU_NAME_WIDTH,
+            (it_data.item_name != NULL) ? it_data.item_name : "NULL", text_width - MENU_NAME_WIDTH - 1, text_width - MENU_NAME_WIDTH - 1,
+            (it_data.item_descr != NULL) ? it_data.item_descr : "NULL");
+        wattrset(draw_ctx->wnd_menu, A_NORMAL);
     }
 }
 
 static void create_menu(efb_draw_context *draw_ctx)
 {
-    int idx;
+    draw_ctx->wnd_menu = newwin(MENU_HEIGHT, MENU_WIDTH, MENU_FIRST_ROW, MENU_FIRST_COLUMN);
+    box(draw_ctx->wnd_menu, 0, 0);
+    draw_menu(draw_ctx);
+}
+
+// Selects any item at once and scrolls the menu as little as needed to show it
+static void select_menu_item(efb_draw_context *draw_ctx, const int item_idx)
+{
+    int menu_rows = (MENU_ROWS > 0) ? MENU_ROWS : 1;
 
-    draw_ctx->menu_items = (ITEM **)calloc(draw_ctx->menu_items_count + 1, sizeof(ITEM *));
-    for (idx = 0; idx < draw_ctx->menu_items_count; idx++)
+    draw_ctx->menu_selected_idx = (item_idx < draw_ctx->menu_items_count) ? item_idx : draw_ctx->menu_items_count - 1;
+    draw_ctx->menu_selected_idx = (draw_ctx->menu_selected_idx > 0) ? draw_ctx->menu_selected_idx : 0;
+
+    if (draw_ctx->menu_selected_idx < draw_ctx->menu_top_idx)
     {
-        char * str_name = "NULL";
-        char * str_descr = "NULL";
-        if (draw_ctx->it_data[idx].item_name != NULL)
+        draw_ctx->menu_top_idx = draw_ctx->menu_selected_idx;
+    }
+    else if (draw_ctx->menu_selected_idx >= draw_ctx->menu_top_idx + menu_rows)
+    {
+        draw_ctx->menu_top_idx = draw_ctx->menu_selected_idx - menu_rows + 1;
+    }
+
+    if (draw_ctx->wnd_menu != NULL)
+    {
+        draw_menu(draw_ctx);
+    }
+}
+
+// Placeholder shown while the content is being rendered or the bytes are searched in the background
+static void draw_render_progress(efb_draw_context *draw_ctx, const char *message, const int percent)
+{
+    mvwprintw(draw_ctx->wnd_content, 0, 0, "%s", message);
+
+    if (percent >= 0)
+    {
+        int bar_width = (CONTENT_WIDTH - 8 < PROGRESS_BAR_WIDTH) ? CONTENT_WIDTH - 8 : PROGRESS_BAR_WIDTH;
+        int done_width = bar_width * percent / 100;
+
+        wmove(draw_ctx->wnd_content, 2, 0);
+        waddch(draw_ctx->wnd_content, '[');
+        for (int col_idx = 0; col_idx < bar_width; col_idx++)
         {
-            str_name = draw_ctx->it_data[idx].item_name;
+            waddch(draw_ctx->wnd_content, (col_idx < done_width) ? '#' : '-');
         }
+        wprintw(draw_ctx->wnd_content, "] %3d%%", percent);
+    }
+}
+
+// Draws the rows which are shown in the window lines [first_line, first_line + line_count). Each row is
+// one line of the rendered text, found by the line index of the buffer, and is put as a single run of
+// characters with the attributes of the row.
+static void draw_content_lines(efb_draw_context *draw_ctx, const efb_view *view, const size_t top_row, const size_t mark_row,
+    const int first_line, const int line_count)
+{
+    const efb_buffer *rows = &draw_ctx->content_rows;
 
-        if (draw_ctx->it_data[idx].item_descr != NULL)
+    efb_buf_reset(&draw_ctx->content_rows);
+    efb_view_render_rows(view, top_row + first_line, line_count, &draw_ctx->content_rows);
+
+    for (int row_idx = 0; row_idx < line_count; row_idx++)
+    {
+        // The line index holds only the rows of this render; the lines below the last row are cleared
+        size_t row_start = (row_idx == 0) ? 0 : ((size_t) row_idx <= rows->line_count) ? rows->line_ends[row_idx - 1] : rows->length;
+        size_t row_end = ((size_t) row_idx < rows->line_count) ? rows->line_ends[row_idx] - 1 : rows->length;
+        size_t row_length = (row_start < row_end) ? row_end - row_start : 0;
+        chtype row_attrs = COLOR_PAIR(1) | ((top_row + first_line + row_idx == mark_row) ? A_REVERSE : A_NORMAL);
+        int col_count = (row_length < (size_t) CONTENT_WIDTH) ? (int) row_length : CONTENT_WIDTH;
+
+        // Control and 8-bit characters would take more than one cell
+        for (int col_idx = 0; col_idx < col_count; col_idx++)
         {
-            str_descr = draw_ctx->it_data[idx].item_descr;
+            unsigned char ch = (unsigned char) rows->data[row_start + col_idx];
+            draw_ctx->content_line[col_idx] = (isprint(ch) ? ch : '.') | row_attrs;
         }
 
-        draw_ctx->menu_items[idx] = new_item(str_name, str_descr);
+        wmove(draw_ctx->wnd_content, first_line + row_idx, 0);
+        waddchnstr(draw_ctx->wnd_content, draw_ctx->content_line, col_count);
+
+        if (col_count < CONTENT_WIDTH)
+        {
+            wmove(draw_ctx->wnd_content, first_line + row_idx, col_count);
+            wclrtoeol(draw_ctx->wnd_content);
+        }
     }
+}
 
-    draw_ctx->menu_items[idx] = NULL;
+// Renders only the rows which are visible in the content window. Unless the window is damaged, a scroll shifts
+// the drawn lines and draws only the rows which scrolled in, and a moved mark redraws only its old and new lines.
+static void fill_content_view(efb_draw_context *draw_ctx)
+{
+    // The search results replace the content while a search is being typed
+    efb_view *view = draw_ctx->search_mode ? draw_ctx->search_view : draw_ctx->content;
+    size_t top_row = draw_ctx->search_mode ? draw_ctx->search_top_row : draw_ctx->content_top_row;
+    size_t mark_row = draw_ctx->search_mode ? draw_ctx->search_cursor : draw_ctx->content_mark_row;
+    long scroll = (long) top_row - (long) draw_ctx->drawn_top_row;
 
-    draw_ctx->main_menu = new_menu((ITEM **)draw_ctx->menu_items);
-    draw_ctx->wnd_menu = newwin(MENU_HEIGHT, MENU_WIDTH, MENU_FIRST_ROW, MENU_FIRST_COLUMN);
-    set_menu_win(draw_ctx->main_menu, draw_ctx->wnd_menu);
+    if (view == NULL)
+    {
+        werase(draw_ctx->wnd_content);
+        if (draw_ctx->search_mode == false)
+        {
+            draw_render_progress(draw_ctx, "Rendering...", efb_get_menu_item_progress(draw_ctx->content_item_idx));
+        }
+        else if (draw_ctx->search_running)
+        {
+            draw_render_progress(draw_ctx, "Searching...", efb_get_byte_search_progress());
+        }
+        draw_ctx->content_damaged = true;
+        return;
+    }
 
-    // TODO Do not use magic numbers
-    set_menu_sub(draw_ctx->main_menu, derwin(draw_ctx->wnd_menu, MENU_HEIGHT - 1, MENU_WIDTH - 2, MENU_FIRST_ROW + 1, MENU_FIRST_COLUMN + 1));
-    set_menu_format(draw_ctx->main_menu, MENU_HEIGHT - 2, 1);
-    set_menu_mark(draw_ctx->main_menu, " > ");
-    box(draw_ctx->wnd_menu, 0, 0);
-    post_menu(draw_ctx->main_menu);
+    if (draw_ctx->content_damaged || (view != draw_ctx->drawn_view) || (labs(scroll) >= CONTENT_HEIGHT))
+    {
+        draw_content_lines(draw_ctx, view, top_row, mark_row, 0, CONTENT_HEIGHT);
+    }
+    else
+    {
+        if (scroll != 0)
+        {
+            // Scrolling stays off otherwise, so a row which fills the last line does not scroll the window
+            scrollok(draw_ctx->wnd_content, TRUE);
+            wscrl(draw_ctx->wnd_content, (int) scroll);
+            scrollok(draw_ctx->wnd_content, FALSE);
+            draw_content_lines(draw_ctx, view, top_row, mark_row, (scroll > 0) ? CONTENT_HEIGHT - (int) scroll : 0, (int) labs(scroll));
+        }
+
+        if (mark_row != draw_ctx->drawn_mark_row)
+        {
+            if ((draw_ctx->drawn_mark_row >= top_row) && (draw_ctx->drawn_mark_row < top_row + CONTENT_HEIGHT))
+            {
+                draw_content_lines(draw_ctx, view, top_row, mark_row, (int) (draw_ctx->drawn_mark_row - top_row), 1);
+            }
+
+            if ((mark_row >= top_row) && (mark_row < top_row + CONTENT_HEIGHT))
+            {
+                draw_content_lines(draw_ctx, view, top_row, mark_row, (int) (mark_row - top_row), 1);
+            }
+        }
+    }
+
+    draw_ctx->content_damaged = false;
+    draw_ctx->drawn_view = view;
+    draw_ctx->drawn_top_row = top_row;
+    draw_ctx->drawn_mark_row = mark_row;
 }
 
+// The windows stay alive between updates; the screen is written once for all the keys typed ahead, see read_key()
+static void update_content_view(efb_draw_context *draw_ctx)
+{
+    if (draw_ctx->wnd_content == NULL)
+    {
+        return;
+    }
+
+    fill_content_view(draw_ctx);
+    wnoutrefresh(draw_ctx->wnd_content);
+}
+
+// Redraws all rows, e.g. when the content or the search results have changed
 static void redraw_content_view(efb_draw_context *draw_ctx)
+{
+    draw_ctx->content_damaged = true;
+    update_content_view(draw_ctx);
+}
+
+static void destroy_content_windows(efb_draw_context *draw_ctx)
 {
     if (draw_ctx->wnd_content_box != NULL)
     {
-        wclear(draw_ctx->wnd_content_box);
-        wrefresh(draw_ctx->wnd_content_box);
         delwin(draw_ctx->wnd_content_box);
+        draw_ctx->wnd_content_box = NULL;
     }
 
+    if (draw_ctx->wnd_content != NULL)
+    {
+        delwin(draw_ctx->wnd_content);
+        draw_ctx->wnd_content = NULL;
+    }
+}
+
+static void create_content_windows(efb_draw_context *draw_ctx)
+{
     draw_ctx->wnd_content_box = newwin(CONTENT_BOX_HEIGHT, CONTENT_BOX_WIDTH, CONTENT_BOX_FIRST_ROW, CONTENT_BOX_FIRST_COLUMN);
     box(draw_ctx->wnd_content_box, 0, 0);
-    wrefresh(draw_ctx->wnd_content_box);
+    wnoutrefresh(draw_ctx->wnd_content_box);
 
-    if (draw_ctx->wnd_content != NULL)
+    draw_ctx->wnd_content = newwin(CONTENT_HEIGHT, CONTENT_WIDTH, CONTENT_FIRST_ROW, CONTENT_FIRST_COLUMN);
+    draw_ctx->content_line = realloc(draw_ctx->content_line, ((CONTENT_WIDTH > 0) ? CONTENT_WIDTH : 1) * sizeof(chtype));
+    if (draw_ctx->content_line == NULL)
     {
-        wattrset(draw_ctx->wnd_content, COLOR_PAIR(1));
-        wnoutrefresh(stdscr);
-        pnoutrefresh(draw_ctx->wnd_content, draw_ctx->content_top_row, 0, CONTENT_FIRST_ROW, CONTENT_FIRST_COLUMN, CONTENT_FIRST_ROW + CONTENT_HEIGHT - 1, CONTENT_FIRST_COLUMN + CONTENT_WIDTH - 1);
-        doupdate();
+        errx(EXIT_FAILURE, "Cannot allocate a line of the content window.");
     }
+
+    wattrset(draw_ctx->wnd_content, COLOR_PAIR(1));
+    wbkgd(draw_ctx->wnd_content, (chtype) (' ' | COLOR_PAIR(1)));
+    idlok(draw_ctx->wnd_content, TRUE);
 }
 
-static void display_menu_item_content(efb_draw_context *draw_ctx, const int item_idx)
+static size_t get_content_max_top_row(efb_draw_context *draw_ctx)
+{
+    size_t content_height = (CONTENT_HEIGHT > 0) ? CONTENT_HEIGHT : 0;
+
+    return (draw_ctx->content_row_count > content_height) ? draw_ctx->content_row_count - content_height : 0;
+}
+
+// Scrolls the content by a number of rows; the rows in between are never rendered
+static void scroll_content(efb_draw_context *draw_ctx, const long delta)
 {
-    char *ptr_content = efb_get_menu_item_content(item_idx);
-    char *ptr_tmp_content = ptr_content;
+    long top_row = (long) draw_ctx->content_top_row + delta;
+    long max_top_row = (long) get_content_max_top_row(draw_ctx);
 
-    draw_ctx->content_row_count = 0;
+    top_row = (top_row < max_top_row) ? top_row : max_top_row;
+    draw_ctx->content_top_row = (top_row > 0) ? (size_t) top_row : 0;
 
-    while (*ptr_tmp_content != '\0')
+    update_content_view(draw_ctx);
+}
+
+static void show_content_row(efb_draw_context *draw_ctx, const size_t row)
+{
+    draw_ctx->content_mark_row = row;
+    draw_ctx->content_top_row = (row < get_content_max_top_row(draw_ctx)) ? row : get_content_max_top_row(draw_ctx);
+}
+
+// Scrolls to and marks the row requested by a jump (e.g. from the symbol search)
+static void apply_pending_locate(efb_draw_context *draw_ctx)
+{
+    size_t row;
+
+    if ((draw_ctx->content == NULL) || (draw_ctx->locate_pending == false))
     {
-        while ((*ptr_tmp_content != '\n') && (*ptr_tmp_content != '\0'))
-        {
-            ptr_tmp_content++;
-        }
+        return;
+    }
 
-        if (*ptr_tmp_content == '\n')
-        {
-            draw_ctx->content_row_count++;
-            ptr_tmp_content++;
-        }
+    draw_ctx->locate_pending = false;
+
+    if (efb_view_locate(draw_ctx->content, draw_ctx->locate_kind, draw_ctx->locate_value, &row))
+    {
+        show_content_row(draw_ctx, row);
+    }
+}
+
+// Restores the scroll position which was kept when the file was reloaded
+static void apply_pending_position(efb_draw_context *draw_ctx)
+{
+    if ((draw_ctx->content == NULL) || (draw_ctx->position_pending == false))
+    {
+        return;
     }
 
-    draw_ctx->content_row_count++;
+    draw_ctx->position_pending = false;
 
-    if (draw_ctx->wnd_content != NULL)
+    size_t max_top_row = get_content_max_top_row(draw_ctx);
+    draw_ctx->content_top_row = (draw_ctx->pending_top_row < max_top_row) ? draw_ctx->pending_top_row : max_top_row;
+    draw_ctx->content_mark_row = (draw_ctx->pending_mark_row < draw_ctx->content_row_count) ? draw_ctx->pending_mark_row : NO_MARK_ROW;
+}
+
+static void display_menu_item_content(efb_draw_context *draw_ctx, const int item_idx)
+{
+    draw_ctx->content_item_idx = item_idx;
+    draw_ctx->content_prefetched = false;
+    draw_ctx->content = efb_get_menu_item_content(item_idx);
+    draw_ctx->content_row_count = (draw_ctx->content != NULL) ? draw_ctx->content->row_count : 0;
+    draw_ctx->content_top_row = 0;
+    draw_ctx->content_mark_row = NO_MARK_ROW;
+
+    apply_pending_locate(draw_ctx);
+    apply_pending_position(draw_ctx);
+    redraw_content_view(draw_ctx);
+}
+
+// Called when no key has been pressed for a while: shows the content once its render has finished,
+// or renders the neighbours of the selected item in advance
+static void process_idle(efb_draw_context *draw_ctx)
+{
+    if (draw_ctx->content == NULL)
     {
-        wclear(draw_ctx->wnd_content);
-        wrefresh(draw_ctx->wnd_content);
-        delwin(draw_ctx->wnd_content);
-        draw_ctx->content_top_row = 0;
+        display_menu_item_content(draw_ctx, draw_ctx->content_item_idx);
+    }
+    else if (draw_ctx->content_prefetched == false)
+    {
+        efb_prefetch_menu_items(draw_ctx->content_item_idx);
+        draw_ctx->content_prefetched = true;
     }
+}
 
-    draw_ctx->wnd_content = newpad(draw_ctx->content_row_count, COLS - MENU_WIDTH);
-    wattrset(draw_ctx->wnd_content, COLOR_PAIR(1));
-    wbkgd(draw_ctx->wnd_content, (chtype) (' ' | COLOR_PAIR(1)));
+static int get_key_timeout(efb_draw_context *draw_ctx)
+{
+    if ((draw_ctx->content == NULL) || draw_ctx->search_running)
+    {
+        return RENDER_POLL_DELAY_MS;
+    }
+
+    return (draw_ctx->content_prefetched == false) ? PREFETCH_IDLE_DELAY_MS : -1;
+}
+
+static void draw_status_line(efb_draw_context *draw_ctx)
+{
+    move(LINES - 1, 0);
+    clrtoeol();
+    attron(COLOR_PAIR(2));
 
-    int row_idx = 0;
-    while (*ptr_content != '\0')
+    if (draw_ctx->search_mode)
     {
-        wmove(draw_ctx->wnd_content, row_idx, 0);
+        const char *prompt = draw_ctx->search_bytes ? "Byte search (hex or \"text): " : "Symbol search (^prefix or substring): ";
 
-        while ((*ptr_content != '\n') && (*ptr_content != '\0'))
+        printw("%s%s", prompt, draw_ctx->search_query);
+        if (draw_ctx->search_pending)
         {
-            waddch(draw_ctx->wnd_content, *ptr_content & 0xff);
-            ptr_content++;
+            printw("    [Enter: search; Esc: cancel]");
         }
-
-        if (*ptr_content == '\n')
+        else if (draw_ctx->search_running)
+        {
+            printw("    [searching; Esc: cancel]");
+        }
+        else if (draw_ctx->search_view == NULL)
+        {
+            printw("    [invalid pattern; Esc: cancel]");
+        }
+        else
         {
-            row_idx++;
-            ptr_content++;
+            printw("    [%zu%s matches; KeyUp / KeyDown / Enter: go to; Esc: cancel]", draw_ctx->search_match_count,
+                draw_ctx->search_truncated ? "+" : "");
         }
+        move(LINES - 1, (int) strlen(prompt) + (int) strlen(draw_ctx->search_query));
     }
+    else if (draw_ctx->goto_mode != GOTO_NONE)
+    {
+        const char *prompt = (draw_ctx->goto_mode == GOTO_LINE) ? "Go to line: "
+            : (draw_ctx->goto_mode == GOTO_OFFSET) ? "Go to file offset (hex): " : "Go to virtual address (hex): ";
 
-    redraw_content_view(draw_ctx);
+        printw("%s%s    [%s; Esc: cancel]", prompt, draw_ctx->goto_query, draw_ctx->goto_failed ? "not found" : "Enter: go to");
+        move(LINES - 1, (int) strlen(prompt) + (int) strlen(draw_ctx->goto_query));
+    }
+    else
+    {
+        printw("Menu: Up / Down / PgUp / PgDn / Home / End; Content: j / k / J / K / d / u / g / G, "
+            ": (line), o (offset), a (vaddr), s (sort), / (search), f (find); Exit: q");
+    }
+
+    attroff(COLOR_PAIR(2));
 }
 
+// The selection is kept; the menu is scrolled to show it in the resized window
 static void redraw_view(efb_draw_context *draw_ctx)
 {
     destroy_menu(draw_ctx);
-    create_menu(draw_ctx);
+    destroy_content_windows(draw_ctx);
+
+    if (draw_ctx->content_top_row > get_content_max_top_row(draw_ctx))
+    {
+        draw_ctx->content_top_row = get_content_max_top_row(draw_ctx);
+    }
 
     clear();
+    draw_status_line(draw_ctx);
+    wnoutrefresh(stdscr);
+
+    select_menu_item(draw_ctx, draw_ctx->menu_selected_idx);
+    create_menu(draw_ctx);
+    wnoutrefresh(draw_ctx->wnd_menu);
+
+    create_content_windows(draw_ctx);
+    redraw_content_view(draw_ctx);
+}
+
+static void process_key_press(efb_draw_context *draw_ctx, const int item_idx)
+{
+    draw_ctx->locate_pending = false;
+    draw_ctx->position_pending = false;
+    select_menu_item(draw_ctx, item_idx);
+    display_menu_item_content(draw_ctx, draw_ctx->menu_selected_idx);
+    wnoutrefresh(draw_ctx->wnd_menu);
+}
+
+static void draw_search_busy(const char *message)
+{
+    move(LINES - 1, 0);
+    clrtoeol();
     attron(COLOR_PAIR(2));
-    mvprintw(LINES - 1, 0, "Menu: KeyUp / KeyDown / PgUp / PgDown / Home / End; Content: k (UP) / j (DOWN); Exit: q");
+    printw("%s", message);
     attroff(COLOR_PAIR(2));
-
     refresh();
-    wrefresh(draw_ctx->wnd_menu);
+}
+
+static void cancel_byte_search(efb_draw_context *draw_ctx)
+{
+    if (draw_ctx->search_running)
+    {
+        efb_cancel_byte_search();
+        draw_ctx->search_running = false;
+        redraw_content_view(draw_ctx);
+    }
+}
+
+// Symbols are searched on every keystroke; a byte search scans the whole file, so it waits for Enter
+static void update_search(efb_draw_context *draw_ctx)
+{
+    if (draw_ctx->search_bytes)
+    {
+        cancel_byte_search(draw_ctx);
+        draw_ctx->search_pending = true;
+        draw_status_line(draw_ctx);
+        return;
+    }
+
+    draw_ctx->search_view = efb_search_symbols(draw_ctx->search_query, &draw_ctx->search_match_count);
+    draw_ctx->search_cursor = 0;
+    draw_ctx->search_top_row = 0;
 
+    draw_status_line(draw_ctx);
     redraw_content_view(draw_ctx);
 }
 
-static void process_key_press(efb_draw_context *draw_ctx, const int pressed_key)
+// The search runs on the render threads, see update_byte_search(); the keys are still handled meanwhile
+static void run_byte_search(efb_draw_context *draw_ctx)
 {
-    menu_driver(draw_ctx->main_menu, pressed_key);
-    display_menu_item_content(draw_ctx, item_index(current_item(draw_ctx->main_menu)));
-    wrefresh(draw_ctx->wnd_menu);
+    draw_ctx->search_running = efb_start_byte_search(draw_ctx->search_query);
+    draw_ctx->search_view = NULL;
+    draw_ctx->search_match_count = 0;
+    draw_ctx->search_truncated = false;
+    draw_ctx->search_pending = false;
+    draw_ctx->search_cursor = 0;
+    draw_ctx->search_top_row = 0;
+
+    draw_status_line(draw_ctx);
+    redraw_content_view(draw_ctx);
+}
+
+// Shows the results once the byte search has finished, and its progress until then
+static void update_byte_search(efb_draw_context *draw_ctx)
+{
+    if (draw_ctx->search_running == false)
+    {
+        return;
+    }
+
+    draw_ctx->search_view = efb_get_byte_search_result(&draw_ctx->search_match_count, &draw_ctx->search_truncated);
+    draw_ctx->search_running = (draw_ctx->search_view == NULL);
+
+    if (draw_ctx->search_running == false)
+    {
+        draw_status_line(draw_ctx);
+    }
+
+    redraw_content_view(draw_ctx);
 }
 
-void efb_draw_view(item_data *it_data, const int menu_items_count)
+static void start_search(efb_draw_context *draw_ctx, const bool search_bytes)
+{
+    draw_ctx->search_mode = true;
+    draw_ctx->search_bytes = search_bytes;
+    draw_ctx->search_truncated = false;
+    draw_ctx->search_query[0] = '\0';
+    draw_ctx->search_match_count = 0;
+
+    if (search_bytes)
+    {
+        draw_ctx->search_view = NULL;
+        draw_ctx->search_pending = true;
+        draw_status_line(draw_ctx);
+        redraw_content_view(draw_ctx);
+        return;
+    }
+
+    // The index is built by the first search, which takes a moment on large files
+    draw_ctx->search_pending = false;
+    draw_search_busy("Indexing symbols...");
+
+    update_search(draw_ctx);
+}
+
+static void stop_search(efb_draw_context *draw_ctx)
+{
+    cancel_byte_search(draw_ctx);
+    draw_ctx->search_mode = false;
+    draw_status_line(draw_ctx);
+    redraw_content_view(draw_ctx);
+}
+
+static void move_search_cursor(efb_draw_context *draw_ctx, const long delta)
+{
+    long cursor = (long) draw_ctx->search_cursor + delta;
+
+    if (cursor >= (long) draw_ctx->search_match_count)
+    {
+        cursor = (long) draw_ctx->search_match_count - 1;
+    }
+
+    draw_ctx->search_cursor = (cursor > 0) ? (size_t) cursor : 0;
+
+    if (draw_ctx->search_cursor < draw_ctx->search_top_row)
+    {
+        draw_ctx->search_top_row = draw_ctx->search_cursor;
+    }
+    else if (draw_ctx->search_cursor >= draw_ctx->search_top_row + CONTENT_HEIGHT)
+    {
+        draw_ctx->search_top_row = draw_ctx->search_cursor - CONTENT_HEIGHT + 1;
+    }
+
+    update_content_view(draw_ctx);
+}
+
+// Selects the section of the match under the search cursor and scrolls its view to the symbol or the bytes
+static void go_to_search_match(efb_draw_context *draw_ctx)
+{
+    int menu_item_idx;
+    size_t sym_idx;
+    uint64_t offset;
+
+    if (draw_ctx->search_bytes)
+    {
+        if (efb_get_byte_match(draw_ctx->search_cursor, &menu_item_idx, &offset) == false)
+        {
+            return;
+        }
+
+        draw_ctx->locate_kind = EFB_LOCATE_OFFSET;
+        draw_ctx->locate_value = offset;
+    }
+    else
+    {
+        if (efb_get_symbol_match(draw_ctx->search_cursor, &menu_item_idx, &sym_idx) == false)
+        {
+            return;
+        }
+
+        draw_ctx->locate_kind = EFB_LOCATE_SYMBOL;
+        draw_ctx->locate_value = sym_idx;
+    }
+
+    draw_ctx->search_mode = false;
+    draw_status_line(draw_ctx);
+
+    select_menu_item(draw_ctx, menu_item_idx);
+    wnoutrefresh(draw_ctx->wnd_menu);
+
+    draw_ctx->locate_pending = true;
+    display_menu_item_content(draw_ctx, menu_item_idx);
+}
+
+static void process_search_key(efb_draw_context *draw_ctx, const int pressed_key)
+{
+    size_t query_len = strlen(draw_ctx->search_query);
+
+    switch (pressed_key)
+    {
+        case KEY_ESCAPE:
+            stop_search(draw_ctx);
+            break;
+        case '\n':
+        case KEY_ENTER:
+            if (draw_ctx->search_pending)
+            {
+                run_byte_search(draw_ctx);
+            }
+            else
+            {
+                go_to_search_match(draw_ctx);
+            }
+            break;
+        case KEY_DOWN:
+            move_search_cursor(draw_ctx, 1);
+            break;
+        case KEY_UP:
+            move_search_cursor(draw_ctx, -1);
+            break;
+        case KEY_NPAGE:
+            move_search_cursor(draw_ctx, CONTENT_HEIGHT);
+            break;
+        case KEY_PPAGE:
+            move_search_cursor(draw_ctx, -CONTENT_HEIGHT);
+            break;
+        case KEY_BACKSPACE:
+        case 127:
+        case '\b':
+            if (query_len > 0)
+            {
+                draw_ctx->search_query[query_len - 1] = '\0';
+                update_search(draw_ctx);
+            }
+            break;
+        default:
+            if ((pressed_key < 256) && isprint(pressed_key) && (query_len + 1 < SEARCH_QUERY_SIZE))
+            {
+                draw_ctx->search_query[query_len] = (char) pressed_key;
+                draw_ctx->search_query[query_len + 1] = '\0';
+                update_search(draw_ctx);
+            }
+            break;
+    }
+}
+
+static void start_goto(efb_draw_context *draw_ctx, const goto_kind kind)
+{
+    draw_ctx->goto_mode = kind;
+    draw_ctx->goto_failed = false;
+    draw_ctx->goto_query[0] = '\0';
+    draw_status_line(draw_ctx);
+}
+
+static void stop_goto(efb_draw_context *draw_ctx)
+{
+    draw_ctx->goto_mode = GOTO_NONE;
+    draw_status_line(draw_ctx);
+}
+
+// A line is a row of the content; an offset or an address selects the section which contains it and is located
+// by the row source of its view, so no rendered text is scanned
+static bool run_goto(efb_draw_context *draw_ctx)
+{
+    char *query_end;
+    size_t row;
+    int menu_item_idx;
+    uint64_t offset;
+
+    uint64_t value = strtoull(draw_ctx->goto_query, &query_end, (draw_ctx->goto_mode == GOTO_LINE) ? 10 : 16);
+    if ((draw_ctx->goto_query[0] == '\0') || (*query_end != '\0'))
+    {
+        return false;
+    }
+
+    if (draw_ctx->goto_mode == GOTO_LINE)
+    {
+        if ((draw_ctx->content == NULL) || (value == 0) || (value > draw_ctx->content_row_count))
+        {
+            return false;
+        }
+
+        show_content_row(draw_ctx, value - 1);
+        update_content_view(draw_ctx);
+        return true;
+    }
+
+    if (efb_get_file_location(draw_ctx->goto_mode == GOTO_ADDRESS, value, draw_ctx->content_item_idx, &menu_item_idx, &offset) == false)
+    {
+        return false;
+    }
+
+    if ((menu_item_idx == draw_ctx->content_item_idx) && (draw_ctx->content != NULL))
+    {
+        if (efb_view_locate(draw_ctx->content, EFB_LOCATE_OFFSET, offset, &row) == false)
+        {
+            return false;
+        }
+
+        show_content_row(draw_ctx, row);
+        update_content_view(draw_ctx);
+        return true;
+    }
+
+    // The section is shown once it is rendered
+    select_menu_item(draw_ctx, menu_item_idx);
+    wnoutrefresh(draw_ctx->wnd_menu);
+
+    draw_ctx->locate_kind = EFB_LOCATE_OFFSET;
+    draw_ctx->locate_value = offset;
+    draw_ctx->locate_pending = true;
+    display_menu_item_content(draw_ctx, menu_item_idx);
+    return true;
+}
+
+static void process_goto_key(efb_draw_context *draw_ctx, const int pressed_key)
+{
+    size_t query_len = strlen(draw_ctx->goto_query);
+    // A line is decimal; an offset or an address is hex, with or without 0x
+    bool is_valid = (pressed_key < 256) && ((draw_ctx->goto_mode == GOTO_LINE) ? isdigit(pressed_key)
+        : (isxdigit(pressed_key) || (pressed_key == 'x')));
+
+    switch (pressed_key)
+    {
+        case KEY_ESCAPE:
+            stop_goto(draw_ctx);
+            break;
+        case '\n':
+        case KEY_ENTER:
+            if (run_goto(draw_ctx))
+            {
+                stop_goto(draw_ctx);
+            }
+            else
+            {
+                draw_ctx->goto_failed = true;
+                draw_status_line(draw_ctx);
+            }
+            break;
+        case KEY_BACKSPACE:
+        case 127:
+        case '\b':
+            if (query_len > 0)
+            {
+                draw_ctx->goto_query[query_len - 1] = '\0';
+                draw_ctx->goto_failed = false;
+                draw_status_line(draw_ctx);
+            }
+            break;
+        default:
+            if (is_valid && (query_len + 1 < GOTO_QUERY_SIZE))
+            {
+                draw_ctx->goto_query[query_len] = (char) pressed_key;
+                draw_ctx->goto_query[query_len + 1] = '\0';
+                draw_ctx->goto_failed = false;
+                draw_status_line(draw_ctx);
+            }
+            break;
+    }
+}
+
+static bool is_menu_item_named(const efb_draw_context *draw_ctx, const int item_idx, const char *name)
+{
+    item_data it_data;
+
+    if (item_idx >= draw_ctx->menu_items_count)
+    {
+        return false;
+    }
+
+    efb_get_menu_item_data(item_idx, &it_data);
+    return (it_data.item_name != NULL) && (strcmp(it_data.item_name, name) == 0);
+}
+
+// The item with the name of the selected one stays selected, at the same place in the menu if it is there;
+// its content keeps the scroll position
+static void reload_file(efb_draw_context *draw_ctx)
+{
+    item_data it_data;
+    size_t menu_items_count;
+
+    efb_get_menu_item_data(draw_ctx->menu_selected_idx, &it_data);
+    char *selected_name = strdup((it_data.item_name != NULL) ? it_data.item_name : "");
+    if (selected_name == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the name of the selected menu item.");
+    }
+
+    if (efb_reload_file(&menu_items_count) == false)
+    {
+        free(selected_name);
+        return;
+    }
+
+    draw_ctx->menu_items_count = (int) menu_items_count;
+
+    int item_idx = draw_ctx->menu_selected_idx;
+    if (is_menu_item_named(draw_ctx, item_idx, selected_name) == false)
+    {
+        item_idx = -1;
+        for (int name_idx = 0; (name_idx < draw_ctx->menu_items_count) && (item_idx < 0); name_idx++)
+        {
+            item_idx = is_menu_item_named(draw_ctx, name_idx, selected_name) ? name_idx : -1;
+        }
+    }
+
+    if (item_idx >= 0)
+    {
+        draw_ctx->position_pending = true;
+        draw_ctx->pending_top_row = draw_ctx->content_top_row;
+        draw_ctx->pending_mark_row = draw_ctx->content_mark_row;
+    }
+    else
+    {
+        item_idx = draw_ctx->menu_selected_idx;
+        draw_ctx->position_pending = false;
+    }
+
+    free(selected_name);
+
+    // The cached view shown so far may have been dropped
+    draw_ctx->content = NULL;
+    draw_ctx->locate_pending = false;
+
+    select_menu_item(draw_ctx, item_idx);
+    wnoutrefresh(draw_ctx->wnd_menu);
+    display_menu_item_content(draw_ctx, draw_ctx->menu_selected_idx);
+}
+
+// Keys typed ahead, e.g. a held 'j', are all handled before the screen is written once
+static int read_key(efb_draw_context *draw_ctx)
+{
+    // wgetch() refreshes a modified stdscr itself, which would write the screen on every key
+    wnoutrefresh(stdscr);
+    wtimeout(stdscr, 0);
+
+    int ch_key = wgetch(stdscr);
+    if (ch_key != ERR)
+    {
+        return ch_key;
+    }
+
+    doupdate();
+
+    // The file is reloaded only while no search or goto prompt is open
+    struct pollfd poll_fds[2] = {
+        { .fd = STDIN_FILENO, .events = POLLIN },
+        { .fd = (draw_ctx->search_mode || (draw_ctx->goto_mode != GOTO_NONE)) ? -1 : efb_get_watch_fd(), .events = POLLIN },
+    };
+
+    int ready_count = poll(poll_fds, 2, get_key_timeout(draw_ctx));
+    if (ready_count == 0)
+    {
+        return ERR;
+    }
+
+    if ((ready_count > 0) && ((poll_fds[0].revents & POLLIN) == 0) && ((poll_fds[1].revents & POLLIN) != 0))
+    {
+        return KEY_FILE_CHANGED;
+    }
+
+    // A key, or a signal such as SIGWINCH which wgetch() turns into KEY_RESIZE
+    wtimeout(stdscr, ((ready_count > 0) && ((poll_fds[0].revents & POLLIN) != 0)) ? get_key_timeout(draw_ctx) : 0);
+    return wgetch(stdscr);
+}
+
+void efb_draw_view(const int menu_items_count)
 {
     efb_draw_context efb_draw_ctx;
-    init_view(&efb_draw_ctx, it_data, menu_items_count);
+    init_view(&efb_draw_ctx, menu_items_count);
     display_menu_item_content(&efb_draw_ctx, FIRST_MENU_INDEX);
     redraw_view(&efb_draw_ctx);
 
     int ch_key;
 
-    while((ch_key = wgetch(stdscr)) != 'q')
+    while(((ch_key = read_key(&efb_draw_ctx)) != 'q') || efb_draw_ctx.search_mode || (efb_draw_ctx.goto_mode != GOTO_NONE))
     {
+        efb_poll_menu_item_content();
+        update_byte_search(&efb_draw_ctx);
+
+        if (efb_draw_ctx.search_mode && (ch_key != ERR))
+        {
+            process_search_key(&efb_draw_ctx, ch_key);
+            ch_key = ERR;
+        }
+        else if ((efb_draw_ctx.goto_mode != GOTO_NONE) && (ch_key != ERR))
+        {
+            process_goto_key(&efb_draw_ctx, ch_key);
+            ch_key = ERR;
+        }
+
         switch(ch_key)
         {
+            case ERR: // no key pressed before the timeout
+                process_idle(&efb_draw_ctx);
+                break;
+            case '/': // search for symbols
+                start_search(&efb_draw_ctx, false);
+                break;
+            case 'f': // find bytes in the section data
+                start_search(&efb_draw_ctx, true);
+                break;
             case 'k': // scroll the menu item content
-                if (efb_draw_ctx.content_top_row > 0)
-                {
-                    efb_draw_ctx.content_top_row--;
-                }
-                redraw_content_view(&efb_draw_ctx);
+                scroll_content(&efb_draw_ctx, -1);
                 break;
             case 'j': // scroll the menu item content
-                if (efb_draw_ctx.content_top_row < (efb_draw_ctx.content_row_count - LINES + STATUS_LINE_HEIGHT + 1))
+                scroll_content(&efb_draw_ctx, 1);
+                break;
+            case 'K': // page through the menu item content
+                scroll_content(&efb_draw_ctx, -CONTENT_HEIGHT);
+                break;
+            case 'J': // page through the menu item content
+                scroll_content(&efb_draw_ctx, CONTENT_HEIGHT);
+                break;
+            case 'u': // half a page up
+                scroll_content(&efb_draw_ctx, -(CONTENT_HEIGHT / 2));
+                break;
+            case 'd': // half a page down
+                scroll_content(&efb_draw_ctx, CONTENT_HEIGHT / 2);
+                break;
+            case 'g': // the top of the menu item content
+                scroll_content(&efb_draw_ctx, -(long) efb_draw_ctx.content_top_row);
+                break;
+            case 'G': // the bottom of the menu item content
+                scroll_content(&efb_draw_ctx, (long) (get_content_max_top_row(&efb_draw_ctx) - efb_draw_ctx.content_top_row));
+                break;
+            case ':': // go to a line of the menu item content
+                start_goto(&efb_draw_ctx, GOTO_LINE);
+                break;
+            case 'o': // go to a file offset
+                start_goto(&efb_draw_ctx, GOTO_OFFSET);
+                break;
+            case 'a': // go to a virtual address
+                start_goto(&efb_draw_ctx, GOTO_ADDRESS);
+                break;
+            case 's': // sort the menu item content
+                if ((efb_draw_ctx.content != NULL) && efb_sort_menu_item_content(efb_draw_ctx.content_item_idx))
                 {
-                    efb_draw_ctx.content_top_row++;
+                    redraw_content_view(&efb_draw_ctx);
                 }
-                redraw_content_view(&efb_draw_ctx);
                 break;
             case KEY_DOWN:
-                process_key_press(&efb_draw_ctx, REQ_DOWN_ITEM);
+                process_key_press(&efb_draw_ctx, efb_draw_ctx.menu_selected_idx + 1);
                 break;
             case KEY_UP:
-                process_key_press(&efb_draw_ctx, REQ_UP_ITEM);
+                process_key_press(&efb_draw_ctx, efb_draw_ctx.menu_selected_idx - 1);
                 break;
             case KEY_NPAGE:
-                process_key_press(&efb_draw_ctx, REQ_SCR_DPAGE);
+                process_key_press(&efb_draw_ctx, efb_draw_ctx.menu_selected_idx + MENU_ROWS);
                 break;
             case KEY_PPAGE:
-                process_key_press(&efb_draw_ctx, REQ_SCR_UPAGE);
+                process_key_press(&efb_draw_ctx, efb_draw_ctx.menu_selected_idx - MENU_ROWS);
                 break;
             case KEY_HOME:
-                process_key_press(&efb_draw_ctx, REQ_FIRST_ITEM);
+                process_key_press(&efb_draw_ctx, FIRST_MENU_INDEX);
                 break;
             case KEY_END:
-                process_key_press(&efb_draw_ctx, REQ_LAST_ITEM);
+                process_key_press(&efb_draw_ctx, efb_draw_ctx.menu_items_count - 1);
                 break;
             case KEY_RESIZE:
-                // TODO Should I keep the current menu element selected?
                 redraw_view(&efb_draw_ctx);
                 break;
+            case KEY_FILE_CHANGED:
+                reload_file(&efb_draw_ctx);
+                break;
 		}
-
-        refresh();
 	}
 
     destroy_menu(&efb_draw_ctx);
 
-	if (efb_draw_ctx.wnd_content != NULL)
-    {
-        delwin(efb_draw_ctx.wnd_content);
-    }
+    destroy_content_windows(&efb_draw_ctx);
+
+    efb_buf_free(&efb_draw_ctx.content_rows);
+    free(efb_draw_ctx.content_line);
 
 	endwin();
 }
@@ -0,0 +1,451 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#ifdef EFB_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifndef ELFCOMPRESS_ZSTD
+#define ELFCOMPRESS_ZSTD 2
+#endif
+
+// The decompressed data is cached in pages, the least recently used page is replaced
+#define ZPAGE_SIZE (64 * 1024)
+#define ZCACHE_PAGES 64
+// A zlib stream is saved every this many pages, so going back restarts from the nearest saved state;
+// a zstd frame has no such cheap restart points and going back restarts from the beginning
+#define ZLIB_CHECKPOINT_PAGES 64
+// inflateCopy() copies the inflate state and its 32 KB window
+#define ZLIB_CHECKPOINT_SIZE (48 * 1024)
+
+#define NO_PAGE SIZE_MAX
+
+typedef struct
+{
+    size_t page_idx;
+    uint64_t last_use;
+    unsigned char *data;
+} zcache_page;
+
+typedef struct
+{
+    size_t position;
+    z_stream stream;
+} zlib_checkpoint;
+
+// One stream decompresses the section front to back, page by page: reading on from where it stopped
+// costs only the new pages. position is how much it has decompressed.
+typedef struct
+{
+    GElf_Word type;
+    const unsigned char *input;
+    size_t input_size;
+    size_t size;
+    GElf_Addr addr;
+    int addr_width;
+    bool stream_active;
+    size_t position;
+    z_stream zlib_stream;
+#ifdef EFB_HAVE_ZSTD
+    ZSTD_DStream *zstd_stream;
+    ZSTD_inBuffer zstd_input;
+#endif
+    zlib_checkpoint *checkpoints;
+    size_t checkpoint_count;
+    size_t checkpoint_capacity;
+    zcache_page pages[ZCACHE_PAGES];
+    uint64_t use_clock;
+    unsigned char *skipped_page;
+    const char *error;
+} zsect_rows_data;
+
+static const char * get_compression_type(const GElf_Word ch_type)
+{
+    switch (ch_type)
+    {
+        case ELFCOMPRESS_ZLIB:
+            return "ZLIB";
+        case ELFCOMPRESS_ZSTD:
+            return "ZSTD";
+        default:
+            return "<unknown>";
+    }
+}
+
+static bool is_supported(const GElf_Word ch_type)
+{
+#ifdef EFB_HAVE_ZSTD
+    return (ch_type == ELFCOMPRESS_ZLIB) || (ch_type == ELFCOMPRESS_ZSTD);
+#else
+    return (ch_type == ELFCOMPRESS_ZLIB);
+#endif
+}
+
+static void end_stream(zsect_rows_data *zsect)
+{
+    if (zsect->stream_active && (zsect->type == ELFCOMPRESS_ZLIB))
+    {
+        inflateEnd(&zsect->zlib_stream);
+    }
+
+    zsect->stream_active = false;
+}
+
+static bool start_stream(zsect_rows_data *zsect)
+{
+    end_stream(zsect);
+    zsect->position = 0;
+
+    if (zsect->type == ELFCOMPRESS_ZLIB)
+    {
+        memset(&zsect->zlib_stream, 0, sizeof(z_stream));
+        zsect->zlib_stream.next_in = (Bytef *) zsect->input;
+        if (inflateInit(&zsect->zlib_stream) != Z_OK)
+        {
+            zsect->error = "inflateInit() failed";
+            return false;
+        }
+    }
+#ifdef EFB_HAVE_ZSTD
+    else
+    {
+        if ((zsect->zstd_stream == NULL) && ((zsect->zstd_stream = ZSTD_createDStream()) == NULL))
+        {
+            zsect->error = "ZSTD_createDStream() failed";
+            return false;
+        }
+
+        ZSTD_DCtx_reset(zsect->zstd_stream, ZSTD_reset_session_only);
+        zsect->zstd_input = (ZSTD_inBuffer) { zsect->input, zsect->input_size, 0 };
+    }
+#endif
+
+    zsect->stream_active = true;
+    return true;
+}
+
+// Moves the stream to the last saved state before the offset, unless reading on gets there sooner
+static bool seek_stream(zsect_rows_data *zsect, const size_t offset)
+{
+    const zlib_checkpoint *checkpoint = NULL;
+
+    for (size_t checkpoint_idx = zsect->checkpoint_count; checkpoint_idx > 0; checkpoint_idx--)
+    {
+        if (zsect->checkpoints[checkpoint_idx - 1].position <= offset)
+        {
+            checkpoint = &zsect->checkpoints[checkpoint_idx - 1];
+            break;
+        }
+    }
+
+    if (zsect->stream_active && (zsect->position <= offset) && ((checkpoint == NULL) || (checkpoint->position <= zsect->position)))
+    {
+        return true;
+    }
+
+    if (checkpoint == NULL)
+    {
+        return start_stream(zsect);
+    }
+
+    end_stream(zsect);
+    if (inflateCopy(&zsect->zlib_stream, (z_stream *) &checkpoint->stream) != Z_OK)
+    {
+        zsect->error = "inflateCopy() failed";
+        return false;
+    }
+
+    zsect->position = checkpoint->position;
+    zsect->stream_active = true;
+    return true;
+}
+
+static void save_checkpoint(zsect_rows_data *zsect)
+{
+    if ((zsect->type != ELFCOMPRESS_ZLIB) || (zsect->position != (zsect->checkpoint_count + 1) * ZLIB_CHECKPOINT_PAGES * ZPAGE_SIZE))
+    {
+        return;
+    }
+
+    if (zsect->checkpoint_count == zsect->checkpoint_capacity)
+    {
+        zsect->checkpoint_capacity = (zsect->checkpoint_capacity > 0) ? zsect->checkpoint_capacity * 2 : 16;
+        zsect->checkpoints = realloc(zsect->checkpoints, zsect->checkpoint_capacity * sizeof(zlib_checkpoint));
+        if (zsect->checkpoints == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot allocate the decompression checkpoints.");
+        }
+    }
+
+    zlib_checkpoint *checkpoint = &zsect->checkpoints[zsect->checkpoint_count];
+    if (inflateCopy(&checkpoint->stream, &zsect->zlib_stream) == Z_OK)
+    {
+        checkpoint->position = zsect->position;
+        zsect->checkpoint_count++;
+    }
+}
+
+static bool inflate_page(zsect_rows_data *zsect, unsigned char *out, const size_t length)
+{
+    z_stream *stream = &zsect->zlib_stream;
+
+    stream->next_out = out;
+    stream->avail_out = length;
+
+    while (stream->avail_out > 0)
+    {
+        size_t remaining = zsect->input + zsect->input_size - stream->next_in;
+        if (stream->avail_in == 0)
+        {
+            stream->avail_in = (remaining < UINT_MAX) ? remaining : UINT_MAX;
+        }
+
+        int result = inflate(stream, Z_NO_FLUSH);
+        if ((result == Z_STREAM_END) && (stream->avail_out > 0))
+        {
+            zsect->error = "the data ends before ch_size bytes";
+            return false;
+        }
+
+        if ((result != Z_OK) && (result != Z_STREAM_END))
+        {
+            zsect->error = (stream->msg != NULL) ? stream->msg : "inflate() failed";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#ifdef EFB_HAVE_ZSTD
+static bool zstd_decompress_page(zsect_rows_data *zsect, unsigned char *out, const size_t length)
+{
+    ZSTD_outBuffer output = { out, length, 0 };
+
+    while (output.pos < output.size)
+    {
+        size_t input_pos = zsect->zstd_input.pos;
+        size_t output_pos = output.pos;
+        size_t result = ZSTD_decompressStream(zsect->zstd_stream, &output, &zsect->zstd_input);
+
+        if (ZSTD_isError(result))
+        {
+            zsect->error = ZSTD_getErrorName(result);
+            return false;
+        }
+
+        if ((zsect->zstd_input.pos == input_pos) && (output.pos == output_pos))
+        {
+            zsect->error = "the data ends before ch_size bytes";
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+// Decompresses the next page of the stream
+static bool decompress_page(zsect_rows_data *zsect, unsigned char *out)
+{
+    size_t length = (zsect->size - zsect->position < ZPAGE_SIZE) ? zsect->size - zsect->position : ZPAGE_SIZE;
+    bool decompressed;
+
+#ifdef EFB_HAVE_ZSTD
+    decompressed = (zsect->type == ELFCOMPRESS_ZLIB) ? inflate_page(zsect, out, length) : zstd_decompress_page(zsect, out, length);
+#else
+    decompressed = inflate_page(zsect, out, length);
+#endif
+
+    if (decompressed == false)
+    {
+        end_stream(zsect);
+        return false;
+    }
+
+    zsect->position += length;
+    save_checkpoint(zsect);
+    return true;
+}
+
+static const unsigned char * get_page(zsect_rows_data *zsect, const size_t page_idx)
+{
+    zcache_page *page = &zsect->pages[0];
+
+    for (size_t slot = 0; slot < ZCACHE_PAGES; slot++)
+    {
+        if (zsect->pages[slot].page_idx == page_idx)
+        {
+            zsect->pages[slot].last_use = ++zsect->use_clock;
+            return zsect->pages[slot].data;
+        }
+
+        page = (zsect->pages[slot].last_use < page->last_use) ? &zsect->pages[slot] : page;
+    }
+
+    if ((zsect->error != NULL) || (seek_stream(zsect, page_idx * ZPAGE_SIZE) == false))
+    {
+        return NULL;
+    }
+
+    // The pages before the wanted one are decompressed, but not cached
+    while (zsect->position < page_idx * ZPAGE_SIZE)
+    {
+        if (decompress_page(zsect, zsect->skipped_page) == false)
+        {
+            return NULL;
+        }
+    }
+
+    page->page_idx = NO_PAGE;
+    if ((page->data == NULL) && ((page->data = malloc(ZPAGE_SIZE)) == NULL))
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the decompressed page.");
+    }
+
+    if (decompress_page(zsect, page->data) == false)
+    {
+        return NULL;
+    }
+
+    page->page_idx = page_idx;
+    page->last_use = ++zsect->use_clock;
+    return page->data;
+}
+
+// The rows are dumped from the cached pages; rendering changes the cache and the stream
+static void render_zsect_rows(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer * out_buffer)
+{
+    zsect_rows_data *zsect = (zsect_rows_data *) rows_data;
+    size_t start = first_row * EFB_DUMP_ROW_WIDTH;
+    size_t end = (first_row + row_count) * EFB_DUMP_ROW_WIDTH;
+    size_t offset = start;
+
+    end = (end < zsect->size) ? end : zsect->size;
+
+    unsigned char *rows = malloc((end > start) ? end - start : 1);
+    if (rows == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the decompressed rows.");
+    }
+
+    while (offset < end)
+    {
+        const unsigned char *page = get_page(zsect, offset / ZPAGE_SIZE);
+        size_t page_offset = offset % ZPAGE_SIZE;
+        size_t length = (ZPAGE_SIZE - page_offset < end - offset) ? ZPAGE_SIZE - page_offset : end - offset;
+
+        if (page == NULL)
+        {
+            break;
+        }
+
+        memcpy(&rows[offset - start], &page[page_offset], length);
+        offset += length;
+    }
+
+    // Only whole rows are dumped; the rest could not be decompressed
+    size_t dumped_rows = (offset < end) ? (offset - start) / EFB_DUMP_ROW_WIDTH : row_count;
+    efb_hex_dump_rows(rows, (offset < end) ? dumped_rows * EFB_DUMP_ROW_WIDTH : end - start, zsect->addr + start,
+        zsect->addr_width, 0, dumped_rows, out_buffer);
+
+    for (size_t row_idx = dumped_rows; row_idx < row_count; row_idx++)
+    {
+        efb_buf_printf(out_buffer, "Cannot decompress the section: %s\n", zsect->error);
+    }
+
+    free(rows);
+}
+
+static void release_zsect_rows(void *rows_data)
+{
+    zsect_rows_data *zsect = rows_data;
+
+    end_stream(zsect);
+
+    for (size_t checkpoint_idx = 0; checkpoint_idx < zsect->checkpoint_count; checkpoint_idx++)
+    {
+        inflateEnd(&zsect->checkpoints[checkpoint_idx].stream);
+    }
+
+    for (size_t slot = 0; slot < ZCACHE_PAGES; slot++)
+    {
+        free(zsect->pages[slot].data);
+    }
+
+#ifdef EFB_HAVE_ZSTD
+    ZSTD_freeDStream(zsect->zstd_stream);
+#endif
+
+    free(zsect->checkpoints);
+    free(zsect->skipped_page);
+    free(zsect);
+}
+
+// SHF_COMPRESSED sections are shown decompressed; returns false if the compression is not supported
+bool efb_info_sect_compressed(Elf *sElf, Elf_Scn *sect, GElf_Shdr *sect_header, efb_view * view)
+{
+    efb_buffer *out_buffer = &view->text;
+    GElf_Chdr chdr;
+    Elf_Data *raw_data = efb_elf_rawdata(sect, NULL);
+    size_t chdr_size = (gelf_getclass(sElf) == ELFCLASS32) ? sizeof(Elf32_Chdr) : sizeof(Elf64_Chdr);
+
+    if ((efb_gelf_getchdr(sect, &chdr) == NULL) || (raw_data == NULL) || (raw_data->d_size < chdr_size))
+    {
+        efb_buf_printf(out_buffer, "Invalid compression header: %s\n\n", elf_errmsg(-1));
+        return false;
+    }
+
+    if (is_supported(chdr.ch_type) == false)
+    {
+        efb_buf_printf(out_buffer, "%s compressed sections are not supported, the compressed data follows\n\n",
+            get_compression_type(chdr.ch_type));
+        return false;
+    }
+
+    size_t input_size = raw_data->d_size - chdr_size;
+
+    efb_get_secthdr_struct(sect_header, out_buffer);
+    efb_buf_printf(out_buffer,
+        "ch_type      = %s\n"
+        "ch_size      = %ld\n"
+        "ch_addralign = %ld\n"
+        "compression  = %zu -> %lu bytes, ratio %.2f:1\n\n",
+        get_compression_type(chdr.ch_type), chdr.ch_size, chdr.ch_addralign,
+        input_size, chdr.ch_size, (input_size > 0) ? (double) chdr.ch_size / input_size : 0.0);
+
+    zsect_rows_data *zsect = calloc(1, sizeof(zsect_rows_data));
+    if ((zsect == NULL) || ((zsect->skipped_page = malloc(ZPAGE_SIZE)) == NULL))
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the decompressed section view.");
+    }
+
+    zsect->type = chdr.ch_type;
+    zsect->input = (const unsigned char *) raw_data->d_buf + chdr_size;
+    zsect->input_size = input_size;
+    zsect->size = chdr.ch_size;
+    zsect->addr = sect_header->sh_addr;
+    zsect->addr_width = (gelf_getclass(sElf) == ELFCLASS32) ? 8 : 16;
+
+    for (size_t slot = 0; slot < ZCACHE_PAGES; slot++)
+    {
+        zsect->pages[slot].page_idx = NO_PAGE;
+    }
+
+    size_t checkpoint_count = chdr.ch_size / (ZLIB_CHECKPOINT_PAGES * ZPAGE_SIZE);
+
+    efb_view_add_rows(view, &(efb_row_source) {
+        .row_count = (chdr.ch_size + EFB_DUMP_ROW_WIDTH - 1) / EFB_DUMP_ROW_WIDTH,
+        .rows_data_size = sizeof(zsect_rows_data) + (ZCACHE_PAGES + 1) * ZPAGE_SIZE
+            + ((chdr.ch_type == ELFCOMPRESS_ZLIB) ? checkpoint_count * ZLIB_CHECKPOINT_SIZE : 0),
+        .render_rows = render_zsect_rows,
+        .release = release_zsect_rows,
+        .rows_data = zsect,
+    });
+
+    return true;
+}
@@ -0,0 +1,650 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DIFF_LABEL_WIDTH 36
+#define DIFF_VALUE_WIDTH 40
+#define DIFF_VALUE_SIZE 64
+#define DIFF_MAX_RANGES 16
+// Differing bytes closer than this are reported as one range
+#define DIFF_RANGE_GAP 16
+#define DIFF_PREVIEW_BYTES 8
+
+#define NO_SECTION SIZE_MAX
+
+typedef struct
+{
+    size_t old_idx;
+    size_t new_idx;
+} sect_pair;
+
+typedef struct
+{
+    const efb_sect_table *sections;
+    size_t *order;
+} name_order;
+
+typedef struct
+{
+    GElf_Sxword tag;
+    GElf_Xword value;
+    const char *name;
+} dyn_entry;
+
+typedef struct
+{
+    size_t changed;
+    size_t added;
+    size_t removed;
+} diff_counts;
+
+// One line of the split view: what is compared, the old value and the new value
+static void diff_row(efb_buffer *out, const char *label, const char *old_value, const char *new_value)
+{
+    efb_buf_printf(out, "%-*.*s %-*.*s | %s\n", DIFF_LABEL_WIDTH, DIFF_LABEL_WIDTH, label,
+        DIFF_VALUE_WIDTH, DIFF_VALUE_WIDTH, old_value, new_value);
+}
+
+static void diff_heading(efb_buffer *out, const char *heading)
+{
+    efb_buf_printf(out, "\n%s\n", heading);
+}
+
+static bool diff_field(efb_buffer *out, const char *label, const uint64_t old_value, const uint64_t new_value, const bool hex)
+{
+    char old_str[DIFF_VALUE_SIZE];
+    char new_str[DIFF_VALUE_SIZE];
+
+    if (old_value == new_value)
+    {
+        return false;
+    }
+
+    snprintf(old_str, sizeof(old_str), hex ? "0x%lx" : "%lu", old_value);
+    snprintf(new_str, sizeof(new_str), hex ? "0x%lx" : "%lu", new_value);
+    diff_row(out, label, old_str, new_str);
+
+    return true;
+}
+
+static void diff_elf_headers(const efb_file *old_file, const efb_file *new_file, efb_buffer *out)
+{
+    GElf_Ehdr old_hdr;
+    GElf_Ehdr new_hdr;
+    bool changed = false;
+
+    if ((gelf_getehdr(old_file->sElf, &old_hdr) == NULL) || (gelf_getehdr(new_file->sElf, &new_hdr) == NULL))
+    {
+        errx(EXIT_FAILURE, "gelf_getehdr() failed: %s.", elf_errmsg(-1));
+    }
+
+    diff_heading(out, "ELF header");
+    changed |= diff_field(out, "  class", gelf_getclass(old_file->sElf), gelf_getclass(new_file->sElf), false);
+    changed |= diff_field(out, "  type", old_hdr.e_type, new_hdr.e_type, false);
+    changed |= diff_field(out, "  machine", old_hdr.e_machine, new_hdr.e_machine, false);
+    changed |= diff_field(out, "  version", old_hdr.e_version, new_hdr.e_version, false);
+    changed |= diff_field(out, "  entry", old_hdr.e_entry, new_hdr.e_entry, true);
+    changed |= diff_field(out, "  phoff", old_hdr.e_phoff, new_hdr.e_phoff, false);
+    changed |= diff_field(out, "  shoff", old_hdr.e_shoff, new_hdr.e_shoff, false);
+    changed |= diff_field(out, "  flags", old_hdr.e_flags, new_hdr.e_flags, true);
+    changed |= diff_field(out, "  phnum", old_hdr.e_phnum, new_hdr.e_phnum, false);
+    changed |= diff_field(out, "  shnum", old_hdr.e_shnum, new_hdr.e_shnum, false);
+    changed |= diff_field(out, "  shstrndx", old_hdr.e_shstrndx, new_hdr.e_shstrndx, false);
+
+    if (changed == false)
+    {
+        efb_buf_printf(out, "  (unchanged)\n");
+    }
+}
+
+static size_t get_segment_count(Elf *sElf)
+{
+    size_t seg_count;
+
+    return (elf_getphdrnum(sElf, &seg_count) == 0) ? seg_count : 0;
+}
+
+// Segments are lined up by index
+static void diff_segments(const efb_file *old_file, const efb_file *new_file, efb_buffer *out)
+{
+    size_t old_count = get_segment_count(old_file->sElf);
+    size_t new_count = get_segment_count(new_file->sElf);
+    size_t max_count = (old_count > new_count) ? old_count : new_count;
+    bool changed = false;
+
+    diff_heading(out, "Segments");
+
+    for (size_t seg_idx = 0; seg_idx < max_count; seg_idx++)
+    {
+        GElf_Phdr old_phdr;
+        GElf_Phdr new_phdr;
+        bool has_old = (seg_idx < old_count) && (efb_gelf_getphdr(old_file->sElf, seg_idx, &old_phdr) == &old_phdr);
+        bool has_new = (seg_idx < new_count) && (efb_gelf_getphdr(new_file->sElf, seg_idx, &new_phdr) == &new_phdr);
+        char label[DIFF_VALUE_SIZE];
+
+        if (has_old != has_new)
+        {
+            snprintf(label, sizeof(label), "  segment %zu", seg_idx);
+            diff_row(out, label, has_old ? "present" : "-", has_new ? "present" : "-");
+            changed = true;
+            continue;
+        }
+
+        if (has_old == false)
+        {
+            continue;
+        }
+
+        snprintf(label, sizeof(label), "  segment %zu p_type", seg_idx);
+        changed |= diff_field(out, label, old_phdr.p_type, new_phdr.p_type, true);
+        snprintf(label, sizeof(label), "  segment %zu p_flags", seg_idx);
+        changed |= diff_field(out, label, old_phdr.p_flags, new_phdr.p_flags, true);
+        snprintf(label, sizeof(label), "  segment %zu p_offset", seg_idx);
+        changed |= diff_field(out, label, old_phdr.p_offset, new_phdr.p_offset, true);
+        snprintf(label, sizeof(label), "  segment %zu p_vaddr", seg_idx);
+        changed |= diff_field(out, label, old_phdr.p_vaddr, new_phdr.p_vaddr, true);
+        snprintf(label, sizeof(label), "  segment %zu p_filesz", seg_idx);
+        changed |= diff_field(out, label, old_phdr.p_filesz, new_phdr.p_filesz, false);
+        snprintf(label, sizeof(label), "  segment %zu p_memsz", seg_idx);
+        changed |= diff_field(out, label, old_phdr.p_memsz, new_phdr.p_memsz, false);
+        snprintf(label, sizeof(label), "  segment %zu p_align", seg_idx);
+        changed |= diff_field(out, label, old_phdr.p_align, new_phdr.p_align, false);
+    }
+
+    if (changed == false)
+    {
+        efb_buf_printf(out, "  (unchanged)\n");
+    }
+}
+
+static bool has_string_value(const GElf_Sxword tag)
+{
+    return (tag == DT_NEEDED) || (tag == DT_SONAME) || (tag == DT_RPATH) || (tag == DT_RUNPATH);
+}
+
+static size_t collect_dyn_entries(const efb_file *file, dyn_entry **entries)
+{
+    const efb_sect_table *sections = &file->sections;
+    size_t entry_count = 0;
+
+    *entries = NULL;
+
+    for (size_t sect_idx = 1; sect_idx < sections->count; sect_idx++)
+    {
+        if ((sections->type[sect_idx] != SHT_DYNAMIC) || (sections->entsize[sect_idx] == 0))
+        {
+            continue;
+        }
+
+        Elf_Data *dyn_data = efb_elf_getdata(sections->scn[sect_idx], NULL);
+        size_t dyn_count = (dyn_data != NULL) ? dyn_data->d_size / sections->entsize[sect_idx] : 0;
+
+        *entries = malloc((dyn_count > 0 ? dyn_count : 1) * sizeof(dyn_entry));
+        if (*entries == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot allocate the dynamic entries.");
+        }
+
+        for (size_t dyn_idx = 0; dyn_idx < dyn_count; dyn_idx++)
+        {
+            GElf_Dyn dyn;
+            if ((gelf_getdyn(dyn_data, dyn_idx, &dyn) != &dyn) || (dyn.d_tag == DT_NULL))
+            {
+                break;
+            }
+
+            const char *name = has_string_value(dyn.d_tag) ? efb_elf_strptr(file->sElf, sections->link[sect_idx], dyn.d_un.d_val) : NULL;
+            (*entries)[entry_count++] = (dyn_entry) { dyn.d_tag, dyn.d_un.d_val, name };
+        }
+
+        break;
+    }
+
+    return entry_count;
+}
+
+static void format_dyn_value(const dyn_entry *entry, char *value, const size_t value_size)
+{
+    if (entry == NULL)
+    {
+        snprintf(value, value_size, "-");
+    }
+    else if (entry->name != NULL)
+    {
+        snprintf(value, value_size, "%s", entry->name);
+    }
+    else
+    {
+        snprintf(value, value_size, "0x%lx", entry->value);
+    }
+}
+
+// The n-th entry with a tag in one file is compared to the n-th entry with that tag in the other
+static void diff_dynamic(const efb_file *old_file, const efb_file *new_file, efb_buffer *out)
+{
+    dyn_entry *old_entries;
+    dyn_entry *new_entries;
+    size_t old_count = collect_dyn_entries(old_file, &old_entries);
+    size_t new_count = collect_dyn_entries(new_file, &new_entries);
+    bool *new_matched = calloc((new_count > 0) ? new_count : 1, sizeof(bool));
+    bool changed = false;
+
+    if (new_matched == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the dynamic entries.");
+    }
+
+    diff_heading(out, "Dynamic entries");
+
+    for (size_t old_idx = 0; old_idx < old_count; old_idx++)
+    {
+        const dyn_entry *old_entry = &old_entries[old_idx];
+        const dyn_entry *new_entry = NULL;
+
+        for (size_t new_idx = 0; new_idx < new_count; new_idx++)
+        {
+            if ((new_matched[new_idx] == false) && (new_entries[new_idx].tag == old_entry->tag))
+            {
+                new_matched[new_idx] = true;
+                new_entry = &new_entries[new_idx];
+                break;
+            }
+        }
+
+        bool same = (new_entry != NULL) && ((old_entry->name != NULL) && (new_entry->name != NULL) ?
+            (strcmp(old_entry->name, new_entry->name) == 0) : (old_entry->value == new_entry->value));
+
+        if (same == false)
+        {
+            char label[DIFF_VALUE_SIZE];
+            char old_value[DIFF_VALUE_SIZE];
+            char new_value[DIFF_VALUE_SIZE];
+
+            snprintf(label, sizeof(label), "  %s", efb_get_dynamic_type(old_entry->tag));
+            format_dyn_value(old_entry, old_value, sizeof(old_value));
+            format_dyn_value(new_entry, new_value, sizeof(new_value));
+            diff_row(out, label, old_value, new_value);
+            changed = true;
+        }
+    }
+
+    for (size_t new_idx = 0; new_idx < new_count; new_idx++)
+    {
+        if (new_matched[new_idx] == false)
+        {
+            char label[DIFF_VALUE_SIZE];
+            char new_value[DIFF_VALUE_SIZE];
+
+            snprintf(label, sizeof(label), "  %s", efb_get_dynamic_type(new_entries[new_idx].tag));
+            format_dyn_value(&new_entries[new_idx], new_value, sizeof(new_value));
+            diff_row(out, label, "-", new_value);
+            changed = true;
+        }
+    }
+
+    if (changed == false)
+    {
+        efb_buf_printf(out, "  (unchanged)\n");
+    }
+
+    free(new_matched);
+    free(old_entries);
+    free(new_entries);
+}
+
+static const efb_sect_table *sort_sections;
+
+static int compare_sect_names(const void *left, const void *right)
+{
+    size_t left_idx = *(const size_t *) left;
+    size_t right_idx = *(const size_t *) right;
+    int result = strcmp(sort_sections->name[left_idx], sort_sections->name[right_idx]);
+
+    return (result != 0) ? result : (left_idx < right_idx) ? -1 : (left_idx > right_idx);
+}
+
+static size_t * sort_by_name(const efb_sect_table *sections)
+{
+    size_t *order = malloc((sections->count > 0 ? sections->count : 1) * sizeof(size_t));
+
+    if (order == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the section order.");
+    }
+
+    for (size_t sect_idx = 0; sect_idx < sections->count; sect_idx++)
+    {
+        order[sect_idx] = sect_idx;
+    }
+
+    sort_sections = sections;
+    qsort(order, sections->count, sizeof(size_t), compare_sect_names);
+
+    return order;
+}
+
+static int compare_pairs(const void *left, const void *right)
+{
+    const sect_pair *left_pair = left;
+    const sect_pair *right_pair = right;
+    size_t left_key = (left_pair->new_idx != NO_SECTION) ? left_pair->new_idx : left_pair->old_idx;
+    size_t right_key = (right_pair->new_idx != NO_SECTION) ? right_pair->new_idx : right_pair->old_idx;
+
+    // Sections which are only in the old file follow the others
+    if ((left_pair->new_idx == NO_SECTION) != (right_pair->new_idx == NO_SECTION))
+    {
+        return (left_pair->new_idx == NO_SECTION) ? 1 : -1;
+    }
+
+    return (left_key < right_key) ? -1 : (left_key > right_key);
+}
+
+// Sections are lined up by name; sections with the same name are paired in their order in the file
+static size_t pair_sections(const efb_sect_table *old_sections, const efb_sect_table *new_sections, sect_pair *pairs)
+{
+    size_t *old_order = sort_by_name(old_sections);
+    size_t *new_order = sort_by_name(new_sections);
+    size_t old_pos = 0;
+    size_t new_pos = 0;
+    size_t pair_count = 0;
+
+    // Index 0 is the null section of both files
+    while ((old_pos < old_sections->count) || (new_pos < new_sections->count))
+    {
+        if ((old_pos < old_sections->count) && (old_order[old_pos] == 0))
+        {
+            old_pos++;
+            continue;
+        }
+
+        if ((new_pos < new_sections->count) && (new_order[new_pos] == 0))
+        {
+            new_pos++;
+            continue;
+        }
+
+        int result = (old_pos == old_sections->count) ? 1 : (new_pos == new_sections->count) ? -1
+            : strcmp(old_sections->name[old_order[old_pos]], new_sections->name[new_order[new_pos]]);
+
+        pairs[pair_count++] = (sect_pair) { (result <= 0) ? old_order[old_pos] : NO_SECTION,
+            (result >= 0) ? new_order[new_pos] : NO_SECTION };
+        old_pos += (result <= 0) ? 1 : 0;
+        new_pos += (result >= 0) ? 1 : 0;
+    }
+
+    free(old_order);
+    free(new_order);
+
+    qsort(pairs, pair_count, sizeof(sect_pair), compare_pairs);
+    return pair_count;
+}
+
+static void get_section_region(const efb_file *file, const size_t sect_idx, efb_hash_region *region)
+{
+    const efb_sect_table *sections = &file->sections;
+    Elf_Data *elf_data = NULL;
+
+    *region = (efb_hash_region) { NULL, 0, NULL };
+
+    if ((sections->type[sect_idx] == SHT_NOBITS) || ((elf_data = efb_elf_getdata(sections->scn[sect_idx], NULL)) == NULL)
+        || (elf_data->d_buf == NULL))
+    {
+        return;
+    }
+
+    region->data = elf_data->d_buf;
+    region->size = elf_data->d_size;
+    region->block_hashes = malloc((efb_hash_block_count(region->size) + 1) * sizeof(uint64_t));
+    if (region->block_hashes == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the section hashes.");
+    }
+
+    efb_advise_sequential(file->sElf, region->data, region->size);
+}
+
+static void format_preview(const efb_hash_region *region, const size_t offset, char *preview, const size_t preview_size)
+{
+    size_t length = 0;
+
+    if (offset >= region->size)
+    {
+        snprintf(preview, preview_size, "-");
+        return;
+    }
+
+    for (size_t byte_idx = offset; (byte_idx < region->size) && (byte_idx < offset + DIFF_PREVIEW_BYTES); byte_idx++)
+    {
+        length += snprintf(&preview[length], preview_size - length, "%02x ", region->data[byte_idx]);
+    }
+}
+
+static void report_range(efb_buffer *out, const efb_hash_region *old_region, const efb_hash_region *new_region,
+    const size_t range_start, const size_t range_end)
+{
+    char label[DIFF_VALUE_SIZE];
+    char old_preview[DIFF_VALUE_SIZE];
+    char new_preview[DIFF_VALUE_SIZE];
+
+    snprintf(label, sizeof(label), "    bytes 0x%zx-0x%zx (%zu)", range_start, range_end - 1, range_end - range_start);
+    format_preview(old_region, range_start, old_preview, sizeof(old_preview));
+    format_preview(new_region, range_start, new_preview, sizeof(new_preview));
+    diff_row(out, label, old_preview, new_preview);
+}
+
+// Only the blocks whose hashes differ are compared byte by byte
+static void diff_section_data(efb_buffer *out, const efb_hash_region *old_region, const efb_hash_region *new_region)
+{
+    size_t common_size = (old_region->size < new_region->size) ? old_region->size : new_region->size;
+    size_t block_count = efb_hash_block_count(common_size);
+    size_t range_count = 0;
+    size_t range_start = SIZE_MAX;
+    size_t range_end = 0;
+
+    for (size_t block = 0; block < block_count; block++)
+    {
+        size_t block_start = block * EFB_HASH_BLOCK_SIZE;
+        size_t block_end = (block_start + EFB_HASH_BLOCK_SIZE < common_size) ? block_start + EFB_HASH_BLOCK_SIZE : common_size;
+        bool whole_blocks = (block_start + EFB_HASH_BLOCK_SIZE <= old_region->size) && (block_start + EFB_HASH_BLOCK_SIZE <= new_region->size);
+
+        if (whole_blocks && (old_region->block_hashes[block] == new_region->block_hashes[block]))
+        {
+            continue;
+        }
+
+        for (size_t offset = block_start; offset < block_end; offset++)
+        {
+            if (old_region->data[offset] == new_region->data[offset])
+            {
+                continue;
+            }
+
+            if ((range_start != SIZE_MAX) && (offset > range_end + DIFF_RANGE_GAP))
+            {
+                range_count++;
+                if (range_count <= DIFF_MAX_RANGES)
+                {
+                    report_range(out, old_region, new_region, range_start, range_end);
+                }
+                range_start = SIZE_MAX;
+            }
+
+            range_start = (range_start == SIZE_MAX) ? offset : range_start;
+            range_end = offset + 1;
+        }
+    }
+
+    if (range_start != SIZE_MAX)
+    {
+        range_count++;
+        if (range_count <= DIFF_MAX_RANGES)
+        {
+            report_range(out, old_region, new_region, range_start, range_end);
+        }
+    }
+
+    if (old_region->size != new_region->size)
+    {
+        range_count++;
+        if (range_count <= DIFF_MAX_RANGES)
+        {
+            char label[DIFF_VALUE_SIZE];
+            snprintf(label, sizeof(label), "    bytes 0x%zx- (%s)", common_size, (old_region->size > new_region->size) ? "removed" : "added");
+            diff_row(out, label, (old_region->size > common_size) ? "..." : "-", (new_region->size > common_size) ? "..." : "-");
+        }
+    }
+
+    if (range_count > DIFF_MAX_RANGES)
+    {
+        efb_buf_printf(out, "    ... %zu more changed ranges\n", range_count - DIFF_MAX_RANGES);
+    }
+}
+
+static bool regions_equal(const efb_hash_region *old_region, const efb_hash_region *new_region)
+{
+    if (old_region->size != new_region->size)
+    {
+        return false;
+    }
+
+    for (size_t block = 0; block < efb_hash_block_count(old_region->size); block++)
+    {
+        if (old_region->block_hashes[block] != new_region->block_hashes[block])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool diff_section_pair(const efb_file *old_file, const efb_file *new_file, const sect_pair *pair,
+    const efb_hash_region *old_region, const efb_hash_region *new_region, efb_buffer *out)
+{
+    const efb_sect_table *old_sections = &old_file->sections;
+    const efb_sect_table *new_sections = &new_file->sections;
+    char label[DIFF_VALUE_SIZE];
+    char value[DIFF_VALUE_SIZE];
+    efb_buffer changes;
+
+    if ((pair->old_idx == NO_SECTION) || (pair->new_idx == NO_SECTION))
+    {
+        size_t sect_idx = (pair->old_idx != NO_SECTION) ? pair->old_idx : pair->new_idx;
+        const efb_sect_table *sections = (pair->old_idx != NO_SECTION) ? old_sections : new_sections;
+
+        snprintf(label, sizeof(label), "  %s", sections->name[sect_idx]);
+        snprintf(value, sizeof(value), "[%zu] size %lu", sect_idx, sections->size[sect_idx]);
+        diff_row(out, label, (pair->old_idx != NO_SECTION) ? value : "-", (pair->new_idx != NO_SECTION) ? value : "-");
+        return true;
+    }
+
+    size_t old_idx = pair->old_idx;
+    size_t new_idx = pair->new_idx;
+    bool changed = false;
+
+    efb_buf_init(&changes);
+
+    changed |= diff_field(&changes, "    sh_type", old_sections->type[old_idx], new_sections->type[new_idx], true);
+    changed |= diff_field(&changes, "    sh_flags", old_sections->flags[old_idx], new_sections->flags[new_idx], true);
+    changed |= diff_field(&changes, "    sh_addr", old_sections->addr[old_idx], new_sections->addr[new_idx], true);
+    changed |= diff_field(&changes, "    sh_offset", old_sections->offset[old_idx], new_sections->offset[new_idx], true);
+    changed |= diff_field(&changes, "    sh_size", old_sections->size[old_idx], new_sections->size[new_idx], false);
+    changed |= diff_field(&changes, "    sh_entsize", old_sections->entsize[old_idx], new_sections->entsize[new_idx], false);
+
+    bool data_changed = (regions_equal(old_region, new_region) == false);
+    if (data_changed)
+    {
+        diff_section_data(&changes, old_region, new_region);
+    }
+
+    if (changed || data_changed)
+    {
+        snprintf(label, sizeof(label), "  %s", new_sections->name[new_idx]);
+        diff_row(out, label, data_changed ? "content changed" : "", "");
+        efb_buf_append(out, changes.data, changes.length);
+    }
+
+    efb_buf_free(&changes);
+    return changed || data_changed;
+}
+
+static void diff_sections(const efb_file *old_file, const efb_file *new_file, efb_buffer *out, diff_counts *counts)
+{
+    const efb_sect_table *old_sections = &old_file->sections;
+    const efb_sect_table *new_sections = &new_file->sections;
+    sect_pair *pairs = malloc((old_sections->count + new_sections->count + 1) * sizeof(sect_pair));
+    efb_hash_region *regions = malloc((old_sections->count + new_sections->count + 1) * sizeof(efb_hash_region));
+
+    if ((pairs == NULL) || (regions == NULL))
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the section diff.");
+    }
+
+    // The data of all sections of both files is hashed in one parallel pass
+    efb_hash_region *old_regions = regions;
+    efb_hash_region *new_regions = &regions[old_sections->count];
+    for (size_t sect_idx = 0; sect_idx < old_sections->count; sect_idx++)
+    {
+        get_section_region(old_file, sect_idx, &old_regions[sect_idx]);
+    }
+    for (size_t sect_idx = 0; sect_idx < new_sections->count; sect_idx++)
+    {
+        get_section_region(new_file, sect_idx, &new_regions[sect_idx]);
+    }
+
+    efb_hash_regions(regions, old_sections->count + new_sections->count);
+
+    size_t pair_count = pair_sections(old_sections, new_sections, pairs);
+
+    diff_heading(out, "Sections");
+
+    for (size_t pair_idx = 0; pair_idx < pair_count; pair_idx++)
+    {
+        const sect_pair *pair = &pairs[pair_idx];
+        static const efb_hash_region no_region = { NULL, 0, NULL };
+
+        if (diff_section_pair(old_file, new_file, pair, (pair->old_idx != NO_SECTION) ? &old_regions[pair->old_idx] : &no_region,
+            (pair->new_idx != NO_SECTION) ? &new_regions[pair->new_idx] : &no_region, out))
+        {
+            counts->changed += ((pair->old_idx != NO_SECTION) && (pair->new_idx != NO_SECTION)) ? 1 : 0;
+            counts->added += (pair->old_idx == NO_SECTION) ? 1 : 0;
+            counts->removed += (pair->new_idx == NO_SECTION) ? 1 : 0;
+        }
+    }
+
+    if (counts->changed + counts->added + counts->removed == 0)
+    {
+        efb_buf_printf(out, "  (unchanged)\n");
+    }
+
+    for (size_t region_idx = 0; region_idx < old_sections->count + new_sections->count; region_idx++)
+    {
+        free(regions[region_idx].block_hashes);
+    }
+
+    free(regions);
+    free(pairs);
+}
+
+// Compares two ELF files: the headers, the segments (by index), the dynamic entries and the sections (by name).
+// The output is two columns, the old and the new value of everything which changed.
+void efb_diff_files(const efb_file *old_file, const efb_file *new_file, efb_buffer *out)
+{
+    diff_counts counts = { 0, 0, 0 };
+    efb_buffer details;
+
+    efb_buf_init(&details);
+
+    diff_elf_headers(old_file, new_file, &details);
+    diff_segments(old_file, new_file, &details);
+    diff_dynamic(old_file, new_file, &details);
+    diff_sections(old_file, new_file, &details, &counts);
+
+    diff_row(out, "", old_file->path, new_file->path);
+    efb_buf_printf(out, "Sections: %zu changed, %zu added, %zu removed\n", counts.changed, counts.added, counts.removed);
+    efb_buf_append(out, details.data, details.length);
+
+    efb_buf_free(&details);
+}
@@ -0,0 +1,715 @@
+#include "elfibia.h"
+
+#ifdef EFB_HAVE_LLVM
+
+#include <err.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <llvm-c/Disassembler.h>
+#include <llvm-c/Target.h>
+
+// The position of every DISASM_CHECKPOINT_ROWS-th row is saved; a row is found by walking from the one before it
+#define DISASM_CHECKPOINT_ROWS 256
+#define DISASM_STEP_BYTES (1 << 20)
+// Longer instructions show their first bytes followed by ".."
+#define DISASM_ROW_BYTES 8
+
+#define X86_MAX_INSN_LENGTH 15
+// Decoding reads at most this many bytes, so shorter tails are copied into a zero filled buffer
+#define X86_PADDED_LENGTH 32
+
+#define X86_MODRM 0x01
+#define X86_IMM8 0x02
+#define X86_IMM16 0x04
+#define X86_IMM32 0x08
+// 16 or 32 bits, by the operand size
+#define X86_IMMZ 0x10
+// 16, 32 or 64 bits, by the operand size
+#define X86_IMMV 0x20
+// A 32 or 64-bit address, by the address size
+#define X86_MOFFS 0x40
+#define X86_BAD 0x80
+
+#define M X86_MODRM
+#define B X86_IMM8
+#define Z X86_IMMZ
+#define X X86_BAD
+
+// Prefixes, REX and the 0F / VEX / EVEX / XOP escapes are decoded before the tables are used
+static const unsigned char x86_map0_flags[256] =
+{
+    M,   M,   M,   M,   B,   Z,   X,   X,   M,   M,   M,   M,   B,   Z,   X,   X,      // 00
+    M,   M,   M,   M,   B,   Z,   X,   X,   M,   M,   M,   M,   B,   Z,   X,   X,      // 10
+    M,   M,   M,   M,   B,   Z,   0,   X,   M,   M,   M,   M,   B,   Z,   0,   X,      // 20
+    M,   M,   M,   M,   B,   Z,   0,   X,   M,   M,   M,   M,   B,   Z,   0,   X,      // 30
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,      // 40
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,      // 50
+    X,   X,   X,   M,   0,   0,   0,   0,   Z,   M|Z, B,   M|B, 0,   0,   0,   0,      // 60
+    B,   B,   B,   B,   B,   B,   B,   B,   B,   B,   B,   B,   B,   B,   B,   B,      // 70
+    M|B, M|Z, X,   M|B, M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // 80
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   X,   0,   0,   0,   0,   0,      // 90
+    X86_MOFFS, X86_MOFFS, X86_MOFFS, X86_MOFFS, 0, 0, 0, 0, B, Z, 0, 0, 0, 0, 0, 0,     // a0
+    B,   B,   B,   B,   B,   B,   B,   B,   X86_IMMV, X86_IMMV, X86_IMMV, X86_IMMV,
+    X86_IMMV, X86_IMMV, X86_IMMV, X86_IMMV,                                             // b0
+    M|B, M|B, X86_IMM16, 0, X, X, M|B, M|Z, X86_IMM16|B, 0, X86_IMM16, 0, 0, B, X, 0,   // c0
+    M,   M,   M,   M,   X,   X,   X,   0,   M,   M,   M,   M,   M,   M,   M,   M,      // d0
+    B,   B,   B,   B,   B,   B,   B,   B,   Z,   Z,   X,   B,   0,   0,   0,   0,      // e0
+    0,   0,   0,   0,   0,   0,   M,   M,   0,   0,   0,   0,   0,   0,   M,   M,      // f0
+};
+
+static const unsigned char x86_map1_flags[256] =
+{
+    M,   M,   M,   M,   X,   0,   0,   0,   0,   0,   X,   0,   X,   M,   0,   M|B,    // 00
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // 10
+    M,   M,   M,   M,   X,   X,   X,   X,   M,   M,   M,   M,   M,   M,   M,   M,      // 20
+    0,   0,   0,   0,   0,   0,   X,   0,   X,   X,   X,   X,   X,   X,   X,   X,      // 30
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // 40
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // 50
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // 60
+    M|B, M|B, M|B, M|B, M,   M,   M,   0,   M,   M,   X,   X,   M,   M,   M,   M,      // 70
+    Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,   Z,      // 80
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // 90
+    0,   0,   0,   M,   M|B, M,   X,   X,   0,   0,   0,   M,   M|B, M,   M,   M,      // a0
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M|B, M,   M,   M,   M,   M,      // b0
+    M,   M,   M|B, M,   M|B, M|B, M|B, M,   0,   0,   0,   0,   0,   0,   0,   0,      // c0
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // d0
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // e0
+    M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,      // f0
+};
+
+#undef M
+#undef B
+#undef Z
+#undef X
+
+typedef size_t (*insn_length_fn)(const unsigned char *code, const size_t size);
+
+// Where a row starts: its section offset and the next symbol label
+typedef struct
+{
+    uint64_t offset;
+    uint32_t label_idx;
+} disasm_position;
+
+typedef struct
+{
+    const unsigned char *data;
+    size_t size;
+    GElf_Addr addr;
+    int addr_width;
+    insn_length_fn insn_length;
+    const efb_addr_index *symbols;
+    uint32_t *labels;
+    size_t label_count;
+    disasm_position *checkpoints;
+    size_t checkpoint_count;
+    size_t row_count;
+    LLVMDisasmContextRef disasm;
+    uint64_t branch_target;
+    bool has_branch_target;
+} disasm_rows_data;
+
+static pthread_once_t llvm_init_once = PTHREAD_ONCE_INIT;
+
+static void init_llvm_targets(void)
+{
+    LLVMInitializeAllTargetInfos();
+    LLVMInitializeAllTargetMCs();
+    LLVMInitializeAllDisassemblers();
+}
+
+static size_t get_x86_modrm_length(const unsigned char *modrm)
+{
+    unsigned int mod = modrm[0] >> 6;
+    unsigned int rm = modrm[0] & 0x07;
+    size_t length = 1;
+
+    if (mod == 3)
+    {
+        return length;
+    }
+
+    // A SIB byte; its base 5 without a displacement means a 32-bit displacement
+    if (rm == 4)
+    {
+        length++;
+        rm = modrm[1] & 0x07;
+    }
+
+    if (mod == 1)
+    {
+        length += 1;
+    }
+    else if ((mod == 2) || (rm == 5))
+    {
+        length += 4;
+    }
+
+    return length;
+}
+
+static unsigned char get_x86_vex_flags(const unsigned char escape, const unsigned int map, const unsigned char opcode)
+{
+    if (escape == 0x8f)
+    {
+        return (map == 8) ? X86_MODRM | X86_IMM8 : (map == 9) ? X86_MODRM : (map == 10) ? X86_MODRM | X86_IMM32 : X86_BAD;
+    }
+
+    switch (map)
+    {
+        case 1:
+            if ((opcode == 0x77) && (escape != 0x62))
+            {
+                return 0;
+            }
+            return (((opcode >= 0x70) && (opcode <= 0x73)) || (opcode == 0xc2) || ((opcode >= 0xc4) && (opcode <= 0xc6))) ?
+                X86_MODRM | X86_IMM8 : X86_MODRM;
+        case 2:
+            return X86_MODRM;
+        case 3:
+            return X86_MODRM | X86_IMM8;
+        case 5:
+        case 6:
+            return (escape == 0x62) ? X86_MODRM : X86_BAD;
+        default:
+            return X86_BAD;
+    }
+}
+
+// The instruction length from its encoding alone, so the rows can be counted without disassembling them;
+// undecodable bytes are rows of one byte
+static size_t get_x86_64_insn_length(const unsigned char *code, const size_t size)
+{
+    unsigned char padded[X86_PADDED_LENGTH];
+    bool operand16 = false;
+    bool address32 = false;
+    bool rex_w = false;
+    unsigned char repeat = 0;
+    size_t length = 0;
+    unsigned char flags;
+
+    if (size < X86_PADDED_LENGTH)
+    {
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, code, size);
+        code = padded;
+    }
+
+    // REX counts only right before the opcode
+    for (;; length++)
+    {
+        unsigned char byte = code[length];
+
+        if (length >= X86_MAX_INSN_LENGTH)
+        {
+            return 1;
+        }
+
+        if ((byte & 0xf0) == 0x40)
+        {
+            rex_w = (byte & 0x08) != 0;
+            continue;
+        }
+
+        if (byte == 0x66)
+        {
+            operand16 = true;
+        }
+        else if (byte == 0x67)
+        {
+            address32 = true;
+        }
+        else if ((byte == 0xf2) || (byte == 0xf3))
+        {
+            repeat = byte;
+        }
+        else if ((byte != 0xf0) && (byte != 0x26) && (byte != 0x2e) && (byte != 0x36) && (byte != 0x3e) && (byte != 0x64) && (byte != 0x65))
+        {
+            break;
+        }
+
+        rex_w = false;
+    }
+
+    unsigned char opcode = code[length++];
+
+    if (opcode == 0x0f)
+    {
+        opcode = code[length++];
+        if (opcode == 0x38)
+        {
+            length++;
+            flags = X86_MODRM;
+        }
+        else if (opcode == 0x3a)
+        {
+            length++;
+            flags = X86_MODRM | X86_IMM8;
+        }
+        else if ((opcode == 0x78) && (operand16 || (repeat == 0xf2)))
+        {
+            // SSE4a extrq / insertq take two 8-bit immediates
+            flags = X86_MODRM | X86_IMM16;
+        }
+        else
+        {
+            flags = x86_map1_flags[opcode];
+        }
+    }
+    else if ((opcode == 0xc4) || (opcode == 0xc5) || (opcode == 0x62) || ((opcode == 0x8f) && ((code[length] & 0x1f) >= 8)))
+    {
+        unsigned char escape = opcode;
+        unsigned int map = (escape == 0xc5) ? 1 : code[length] & ((escape == 0x62) ? 0x07 : 0x1f);
+
+        length += (escape == 0xc5) ? 1 : (escape == 0x62) ? 3 : 2;
+        opcode = code[length++];
+        flags = get_x86_vex_flags(escape, map, opcode);
+    }
+    else
+    {
+        flags = x86_map0_flags[opcode];
+
+        // test r/m, imm is the only F6 / F7 form with an immediate
+        if (((opcode == 0xf6) || (opcode == 0xf7)) && (((code[length] >> 3) & 0x07) < 2))
+        {
+            flags |= (opcode == 0xf6) ? X86_IMM8 : X86_IMMZ;
+        }
+    }
+
+    if ((flags & X86_BAD) != 0)
+    {
+        return 1;
+    }
+
+    length += ((flags & X86_MODRM) != 0) ? get_x86_modrm_length(&code[length]) : 0;
+    length += ((flags & X86_IMM8) != 0) ? 1 : 0;
+    length += ((flags & X86_IMM16) != 0) ? 2 : 0;
+    length += ((flags & X86_IMM32) != 0) ? 4 : 0;
+    length += ((flags & X86_IMMZ) != 0) ? ((operand16 && !rex_w) ? 2 : 4) : 0;
+    length += ((flags & X86_IMMV) != 0) ? (rex_w ? 8 : operand16 ? 2 : 4) : 0;
+    length += ((flags & X86_MOFFS) != 0) ? (address32 ? 4 : 8) : 0;
+
+    if (length > X86_MAX_INSN_LENGTH)
+    {
+        return 1;
+    }
+
+    return (length < size) ? length : size;
+}
+
+static size_t get_aarch64_insn_length(const unsigned char *code, const size_t size)
+{
+    (void) code;
+    return (size < 4) ? size : 4;
+}
+
+// Compressed instructions are 16-bit, the others 32-bit
+static size_t get_riscv_insn_length(const unsigned char *code, const size_t size)
+{
+    size_t length = ((code[0] & 0x03) != 0x03) ? 2 : 4;
+    return (length < size) ? length : size;
+}
+
+static uint64_t get_label_offset(const disasm_rows_data *disasm, const size_t label_idx)
+{
+    return disasm->symbols->start[disasm->labels[label_idx]] - disasm->addr;
+}
+
+// Returns the length of the row at the position, 0 for a symbol label, and moves the position past it;
+// an instruction which would run into a symbol is cut before it
+static size_t next_row(const disasm_rows_data *disasm, disasm_position *position)
+{
+    uint64_t limit = disasm->size;
+
+    if (position->label_idx < disasm->label_count)
+    {
+        limit = get_label_offset(disasm, position->label_idx);
+        if (limit == position->offset)
+        {
+            position->label_idx++;
+            return 0;
+        }
+    }
+
+    size_t length = disasm->insn_length(&disasm->data[position->offset], limit - position->offset);
+    position->offset += length;
+    return length;
+}
+
+static bool index_rows(disasm_rows_data *disasm)
+{
+    disasm_position position = { 0, 0 };
+    size_t capacity = 1024;
+    size_t next_step = 0;
+
+    disasm->checkpoints = malloc(capacity * sizeof(disasm_position));
+    if (disasm->checkpoints == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the disassembly index.");
+    }
+
+    for (disasm->row_count = 0; position.offset < disasm->size; disasm->row_count++)
+    {
+        if ((disasm->row_count % DISASM_CHECKPOINT_ROWS) == 0)
+        {
+            if ((position.offset >= next_step) && (efb_render_step(position.offset, disasm->size) == false))
+            {
+                return false;
+            }
+
+            next_step = (position.offset >= next_step) ? position.offset + DISASM_STEP_BYTES : next_step;
+
+            if (disasm->checkpoint_count == capacity)
+            {
+                capacity *= 2;
+                disasm->checkpoints = realloc(disasm->checkpoints, capacity * sizeof(disasm_position));
+                if (disasm->checkpoints == NULL)
+                {
+                    errx(EXIT_FAILURE, "Cannot allocate the disassembly index for %zu rows.", disasm->row_count);
+                }
+            }
+
+            disasm->checkpoints[disasm->checkpoint_count++] = position;
+        }
+
+        next_row(disasm, &position);
+    }
+
+    return true;
+}
+
+// The symbol labels are the starts of the address intervals inside the section
+static void collect_labels(disasm_rows_data *disasm)
+{
+    size_t first_interval;
+
+    if ((disasm->symbols == NULL) || (disasm->addr == 0) ||
+        (efb_addr_index_lookup(disasm->symbols, disasm->addr, disasm->addr + disasm->size, &first_interval) == false))
+    {
+        return;
+    }
+
+    size_t last_interval = first_interval;
+    while ((last_interval < disasm->symbols->count) && (disasm->symbols->start[last_interval] < disasm->addr + disasm->size))
+    {
+        last_interval++;
+    }
+
+    disasm->labels = malloc((last_interval - first_interval) * sizeof(uint32_t));
+    if (disasm->labels == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the disassembly labels.");
+    }
+
+    for (size_t interval_idx = first_interval; interval_idx < last_interval; interval_idx++)
+    {
+        if ((disasm->symbols->start[interval_idx] >= disasm->addr) && (disasm->symbols->start[interval_idx] == disasm->symbols->sym_addr[interval_idx]))
+        {
+            disasm->labels[disasm->label_count++] = interval_idx;
+        }
+    }
+}
+
+// Keeps the branch target, it is named after the instruction; the disassembler prints the address
+static const char * lookup_branch_target(void *dis_info, uint64_t value, uint64_t *reference_type, uint64_t reference_pc,
+    const char **reference_name)
+{
+    disasm_rows_data *disasm = dis_info;
+
+    (void) reference_pc;
+    if (*reference_type == LLVMDisassembler_ReferenceType_In_Branch)
+    {
+        disasm->branch_target = value;
+        disasm->has_branch_target = true;
+    }
+
+    *reference_type = LLVMDisassembler_ReferenceType_InOut_None;
+    *reference_name = NULL;
+    return NULL;
+}
+
+static void append_branch_target(const disasm_rows_data *disasm, efb_buffer * out_buffer)
+{
+    size_t interval_idx;
+
+    if ((disasm->symbols == NULL) ||
+        (efb_addr_index_lookup(disasm->symbols, disasm->branch_target, disasm->branch_target + 1, &interval_idx) == false))
+    {
+        return;
+    }
+
+    GElf_Addr sym_addr = disasm->symbols->sym_addr[interval_idx];
+    if (disasm->branch_target == sym_addr)
+    {
+        efb_buf_printf(out_buffer, " <%s>", disasm->symbols->name[interval_idx]);
+    }
+    else
+    {
+        efb_buf_printf(out_buffer, " <%s+0x%lx>", disasm->symbols->name[interval_idx], disasm->branch_target - sym_addr);
+    }
+}
+
+// The mnemonic is padded to a column and the tabs are replaced, the view shows one character per cell
+static void append_insn_text(const char *text, efb_buffer * out_buffer)
+{
+    text += strspn(text, " \t");
+
+    const char *separator = strchr(text, '\t');
+    if (separator == NULL)
+    {
+        efb_buf_printf(out_buffer, "%s", text);
+        return;
+    }
+
+    efb_buf_printf(out_buffer, "%-7.*s ", (int) (separator - text), text);
+    for (const char *ptr = separator + 1; *ptr != '\0'; ptr++)
+    {
+        efb_buf_putc(out_buffer, (*ptr == '\t') ? ' ' : *ptr);
+    }
+}
+
+static void render_insn_row(disasm_rows_data *disasm, const uint64_t offset, const size_t length, efb_buffer * out_buffer)
+{
+    char text[256];
+
+    efb_buf_printf(out_buffer, "  %0*lx  ", disasm->addr_width, disasm->addr + offset);
+    for (size_t byte_idx = 0; byte_idx < DISASM_ROW_BYTES; byte_idx++)
+    {
+        if ((byte_idx == DISASM_ROW_BYTES - 1) && (length > DISASM_ROW_BYTES))
+        {
+            efb_buf_append(out_buffer, ".. ", 3);
+        }
+        else if (byte_idx < length)
+        {
+            efb_buf_printf(out_buffer, "%02x ", disasm->data[offset + byte_idx]);
+        }
+        else
+        {
+            efb_buf_append(out_buffer, "   ", 3);
+        }
+    }
+
+    efb_buf_putc(out_buffer, ' ');
+
+    // LLVM decodes some prefixes, e.g. lock, as instructions of their own; they share the row
+    for (size_t decoded = 0; decoded < length;)
+    {
+        disasm->has_branch_target = false;
+        size_t part = LLVMDisasmInstruction(disasm->disasm, (uint8_t *) &disasm->data[offset + decoded], length - decoded,
+            disasm->addr + offset + decoded, text, sizeof(text));
+
+        if (decoded > 0)
+        {
+            efb_buf_putc(out_buffer, ' ');
+        }
+
+        if (part == 0)
+        {
+            efb_buf_printf(out_buffer, "(bad)");
+            break;
+        }
+
+        append_insn_text(text, out_buffer);
+        if (disasm->has_branch_target)
+        {
+            append_branch_target(disasm, out_buffer);
+        }
+
+        decoded += part;
+    }
+
+    efb_buf_putc(out_buffer, '\n');
+}
+
+// Only the rows from the checkpoint before first_row are walked; only the rendered ones are disassembled
+static void render_disasm_rows(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer * out_buffer)
+{
+    disasm_rows_data *disasm = (disasm_rows_data *) rows_data;
+    disasm_position position = disasm->checkpoints[first_row / DISASM_CHECKPOINT_ROWS];
+
+    for (size_t row_idx = first_row - first_row % DISASM_CHECKPOINT_ROWS; row_idx < first_row; row_idx++)
+    {
+        next_row(disasm, &position);
+    }
+
+    for (size_t row_idx = first_row; row_idx < first_row + row_count; row_idx++)
+    {
+        disasm_position row = position;
+        size_t length = next_row(disasm, &position);
+
+        if (length == 0)
+        {
+            efb_buf_printf(out_buffer, "  %0*lx <%s>:\n", disasm->addr_width, disasm->addr + row.offset,
+                disasm->symbols->name[disasm->labels[row.label_idx]]);
+        }
+        else
+        {
+            render_insn_row(disasm, row.offset, length, out_buffer);
+        }
+    }
+}
+
+// An address or a section offset locates the instruction which contains it, or the label of a symbol starting there
+static bool locate_disasm_row(const void *rows_data, const efb_locate_kind kind, const uint64_t value, size_t *row)
+{
+    const disasm_rows_data *disasm = rows_data;
+    uint64_t offset = value;
+
+    if (kind == EFB_LOCATE_ADDRESS)
+    {
+        if ((disasm->addr == 0) || (value < disasm->addr))
+        {
+            return false;
+        }
+
+        offset = value - disasm->addr;
+    }
+    else if (kind != EFB_LOCATE_OFFSET)
+    {
+        return false;
+    }
+
+    if ((offset >= disasm->size) || (disasm->checkpoint_count == 0))
+    {
+        return false;
+    }
+
+    // The last checkpoint before the offset
+    size_t low = 0;
+    size_t high = disasm->checkpoint_count;
+    while (high - low > 1)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (disasm->checkpoints[mid].offset < offset)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    disasm_position position = disasm->checkpoints[low];
+    for (size_t row_idx = low * DISASM_CHECKPOINT_ROWS; row_idx < disasm->row_count; row_idx++)
+    {
+        uint64_t row_offset = position.offset;
+        size_t length = next_row(disasm, &position);
+
+        if ((length == 0) ? (row_offset == offset) : (row_offset + length > offset))
+        {
+            *row = row_idx;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void release_disasm_rows(void *rows_data)
+{
+    disasm_rows_data *disasm = rows_data;
+
+    if (disasm->disasm != NULL)
+    {
+        LLVMDisasmDispose(disasm->disasm);
+    }
+
+    free(disasm->labels);
+    free(disasm->checkpoints);
+    free(disasm);
+}
+
+// Executable sections are disassembled a window of rows at a time; returns false if the machine is not supported
+bool efb_info_sect_disasm(const efb_file *file, Elf_Data *elf_data, GElf_Shdr *sect_header, efb_view * view)
+{
+    GElf_Ehdr elf_header;
+    const char *triple = NULL;
+    const char *features = "";
+    insn_length_fn insn_length = NULL;
+
+    if ((elf_data->d_buf == NULL) || (elf_data->d_size == 0) || (gelf_getehdr(file->sElf, &elf_header) == NULL))
+    {
+        return false;
+    }
+
+    switch (elf_header.e_machine)
+    {
+        case EM_X86_64:
+            triple = "x86_64-unknown-linux-gnu";
+            insn_length = get_x86_64_insn_length;
+            break;
+        case EM_AARCH64:
+            triple = "aarch64-unknown-linux-gnu";
+            insn_length = get_aarch64_insn_length;
+            break;
+        case EM_RISCV:
+            triple = (elf_header.e_ident[EI_CLASS] == ELFCLASS32) ? "riscv32-unknown-linux-gnu" : "riscv64-unknown-linux-gnu";
+            features = "+m,+a,+f,+d,+c";
+            insn_length = get_riscv_insn_length;
+            break;
+        default:
+            return false;
+    }
+
+    disasm_rows_data *disasm = calloc(1, sizeof(disasm_rows_data));
+    if (disasm == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the disassembly view.");
+    }
+
+    pthread_once(&llvm_init_once, init_llvm_targets);
+
+    disasm->disasm = LLVMCreateDisasmCPUFeatures(triple, "", features, disasm, 0, NULL, lookup_branch_target);
+    if (disasm->disasm == NULL)
+    {
+        free(disasm);
+        return false;
+    }
+
+    LLVMSetDisasmOptions(disasm->disasm, LLVMDisassembler_Option_PrintImmHex);
+
+    disasm->data = elf_data->d_buf;
+    disasm->size = elf_data->d_size;
+    disasm->addr = sect_header->sh_addr;
+    disasm->addr_width = (elf_header.e_ident[EI_CLASS] == ELFCLASS32) ? 8 : 16;
+    disasm->insn_length = insn_length;
+    disasm->symbols = (sect_header->sh_addr != 0) ? efb_get_addr_index() : NULL;
+
+    efb_advise_sequential(file->sElf, elf_data->d_buf, elf_data->d_size);
+    collect_labels(disasm);
+
+    if (index_rows(disasm) == false)
+    {
+        release_disasm_rows(disasm);
+        return true;
+    }
+
+    efb_buf_printf(&view->text, "%zu instructions, %zu symbols (%s)\n\n", disasm->row_count - disasm->label_count, disasm->label_count, triple);
+
+    efb_view_add_rows(view, &(efb_row_source) {
+        .row_count = disasm->row_count,
+        .rows_data_size = sizeof(disasm_rows_data) + disasm->checkpoint_count * sizeof(disasm_position) + disasm->label_count * sizeof(uint32_t),
+        .render_rows = render_disasm_rows,
+        .locate_row = locate_disasm_row,
+        .release = release_disasm_rows,
+        .rows_data = disasm,
+    });
+
+    return true;
+}
+
+#else
+
+bool efb_info_sect_disasm(const efb_file *file, Elf_Data *elf_data, GElf_Shdr *sect_header, efb_view * view)
+{
+    (void) file;
+    (void) elf_data;
+    (void) sect_header;
+    (void) view;
+    return false;
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A viewed file may be truncated under its mapping by a rewrite in place (cp, install, a linker which
+// writes the output where it is): a read past the new end of the file raises SIGBUS. The handler maps
+// zeros over the page so that the read goes on, and the file is reloaded when the writer is done.
+typedef struct
+{
+    const unsigned char * image;
+    size_t image_size;
+    volatile sig_atomic_t truncated;
+} guarded_mapping;
+
+// Changed only while no other thread reads the mappings: at start, and while the render threads are stopped
+static guarded_mapping *guarded_mappings;
+static size_t guarded_count;
+static uintptr_t guard_page_size;
+
+// The file is mapped by libelf (ELF_C_READ_MMAP): section data of a native byte order
+// object points into the mapping, so nothing is read or copied before it is displayed.
+bool efb_file_open(efb_file *file, const char *path)
+{
+    file->path = path;
+    file->sElf = NULL;
+    file->image = NULL;
+    file->image_size = 0;
+    // The table is freed by efb_file_close(), also when the file is closed before it is built
+    file->sections = (efb_sect_table) { 0 };
+    file->error = NULL;
+
+    if ((file->fd = open(path, O_RDONLY, 0)) < 0)
+    {
+        file->error = strerror(errno);
+        return false;
+    }
+
+    if ((file->sElf = elf_begin(file->fd, ELF_C_READ_MMAP, NULL)) == NULL)
+    {
+        file->error = elf_errmsg(-1);
+        close(file->fd);
+        return false;
+    }
+
+    if (elf_kind(file->sElf) != ELF_K_ELF)
+    {
+        file->error = "not an ELF object";
+        efb_file_close(file);
+        return false;
+    }
+
+    if (efb_sect_table_build(file->sElf, &file->sections) == false)
+    {
+        file->error = "invalid section headers";
+        efb_file_close(file);
+        return false;
+    }
+
+    file->image = (const unsigned char *) elf_rawfile(file->sElf, &file->image_size);
+
+    // Headers and tables are looked up at scattered offsets, read-ahead would only waste memory
+    if (file->image != NULL)
+    {
+        madvise((void *) file->image, file->image_size, MADV_RANDOM);
+    }
+
+    return true;
+}
+
+static guarded_mapping * find_guarded_mapping(const void *addr)
+{
+    for (size_t guard_idx = 0; guard_idx < guarded_count; guard_idx++)
+    {
+        guarded_mapping *mapping = &guarded_mappings[guard_idx];
+
+        if (((const unsigned char *) addr >= mapping->image) && ((const unsigned char *) addr < mapping->image + mapping->image_size))
+        {
+            return mapping;
+        }
+    }
+
+    return NULL;
+}
+
+static void on_mapping_fault(int sig, siginfo_t *info, void *context)
+{
+    guarded_mapping *mapping = find_guarded_mapping(info->si_addr);
+    (void) context;
+
+    if ((mapping != NULL) && (info->si_code == BUS_ADRERR))
+    {
+        void *page = (void *) ((uintptr_t) info->si_addr & ~(guard_page_size - 1));
+
+        if (mmap(page, guard_page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED)
+        {
+            mapping->truncated = 1;
+            return;
+        }
+    }
+
+    // Not a read past the end of a viewed file: the fault is raised again, with the default action
+    signal(sig, SIG_DFL);
+}
+
+// Protects the viewer from a rewrite of the file under its mapping, see guarded_mapping
+void efb_file_guard(const efb_file *file)
+{
+    if (file->image == NULL)
+    {
+        return;
+    }
+
+    if (guard_page_size == 0)
+    {
+        struct sigaction action = { .sa_sigaction = on_mapping_fault, .sa_flags = SA_SIGINFO };
+
+        guard_page_size = (uintptr_t) sysconf(_SC_PAGESIZE);
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGBUS, &action, NULL);
+    }
+
+    guarded_mapping *mappings = realloc(guarded_mappings, (guarded_count + 1) * sizeof(guarded_mapping));
+    if (mappings == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot guard the mapping of %s.", file->path);
+    }
+
+    guarded_mappings = mappings;
+    guarded_mappings[guarded_count++] = (guarded_mapping) { file->image, file->image_size, 0 };
+}
+
+static void unguard_file(const efb_file *file)
+{
+    guarded_mapping *mapping = (file->image != NULL) ? find_guarded_mapping(file->image) : NULL;
+
+    if (mapping != NULL)
+    {
+        *mapping = guarded_mappings[--guarded_count];
+    }
+}
+
+// Returns true if a read has run past the end of the file, which has been truncated under its mapping
+bool efb_file_truncated(const efb_file *file)
+{
+    guarded_mapping *mapping = (file->image != NULL) ? find_guarded_mapping(file->image) : NULL;
+
+    return (mapping != NULL) && mapping->truncated;
+}
+
+// Returns true if the mapping of 'old_file' no longer shows the contents it had when it was opened:
+// 'new_file' is the same file rewritten in place, or the file has been truncated
+bool efb_file_rewritten(const efb_file *old_file, const efb_file *new_file)
+{
+    struct stat old_stat;
+    struct stat new_stat;
+
+    return efb_file_truncated(old_file) || (fstat(old_file->fd, &old_stat) != 0) || (fstat(new_file->fd, &new_stat) != 0)
+        || ((old_stat.st_dev == new_stat.st_dev) && (old_stat.st_ino == new_stat.st_ino));
+}
+
+void efb_file_close(efb_file *file)
+{
+    unguard_file(file);
+
+    if (file->sElf != NULL)
+    {
+        efb_sect_table_free(&file->sections);
+        elf_end(file->sElf);
+        file->sElf = NULL;
+    }
+
+    if (file->fd >= 0)
+    {
+        close(file->fd);
+        file->fd = -1;
+    }
+
+    file->image = NULL;
+    file->image_size = 0;
+}
+
+// Hints the kernel that 'data' (which may point into the mapped file) is going to be read sequentially
+void efb_advise_sequential(Elf *sElf, const void *data, const size_t size)
+{
+    size_t image_size;
+    const char *image = elf_rawfile(sElf, &image_size);
+    const char *ptr_data = data;
+
+    if ((image == NULL) || (ptr_data < image) || (ptr_data + size > image + image_size))
+    {
+        return;
+    }
+
+    uintptr_t page_mask = (uintptr_t) sysconf(_SC_PAGESIZE) - 1;
+    uintptr_t range_start = (uintptr_t) ptr_data & ~page_mask;
+
+    madvise((void *) range_start, (uintptr_t) ptr_data + size - range_start, MADV_SEQUENTIAL);
+}
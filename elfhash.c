@@ -0,0 +1,352 @@
+#include "elfibia.h"
+
+#include <string.h>
+
+#define HASH_HISTOGRAM_SIZE 8
+#define HASH_BAR_WIDTH 40
+#define GNU_HASH_HEADER_WORDS 4
+
+// Thresholds of a badly sized table: lookups walk long chains, the table wastes memory,
+// or the bloom filter lets through more than a quarter of the symbols which are not there
+#define HASH_MAX_LOAD 8.0
+#define HASH_MIN_LOAD 0.25
+#define HASH_MIN_FLAGGED_BUCKETS 64
+#define HASH_MAX_BLOOM_FILL 0.5
+
+typedef enum
+{
+    HASH_FEW_BUCKETS = 1,
+    HASH_SPARSE = 2,
+    HASH_BLOOM_FULL = 4
+} hash_problem;
+
+typedef struct
+{
+    bool gnu;
+    size_t bucket_count;
+    size_t sym_offset;
+    size_t sym_count;
+    size_t empty_count;
+    size_t max_chain;
+    size_t histogram[HASH_HISTOGRAM_SIZE];
+    // Sum of the positions of all symbols in their chains
+    double hit_probes;
+    size_t bloom_words;
+    size_t bloom_word_bits;
+    size_t bloom_set_bits;
+    unsigned int bloom_shift;
+} hash_stats;
+
+static void add_chain(hash_stats *stats, const size_t length)
+{
+    stats->sym_count += length;
+    stats->empty_count += (length == 0) ? 1 : 0;
+    stats->max_chain = (length > stats->max_chain) ? length : stats->max_chain;
+    stats->histogram[(length < HASH_HISTOGRAM_SIZE) ? length : HASH_HISTOGRAM_SIZE - 1]++;
+    stats->hit_probes += (double) length * (length + 1) / 2;
+}
+
+static uint32_t get_word(const Elf_Data *data, const size_t word_idx)
+{
+    uint32_t word;
+
+    memcpy(&word, (const unsigned char *) data->d_buf + word_idx * sizeof(uint32_t), sizeof(word));
+    return word;
+}
+
+// nbucket, nchain, the buckets and the chains, all 32-bit words
+static bool analyze_sysv_hash(const Elf_Data *data, hash_stats *stats)
+{
+    size_t word_count = data->d_size / sizeof(uint32_t);
+
+    if (word_count < 2)
+    {
+        return false;
+    }
+
+    size_t bucket_count = get_word(data, 0);
+    size_t chain_count = get_word(data, 1);
+
+    if (2 + bucket_count + chain_count > word_count)
+    {
+        return false;
+    }
+
+    stats->bucket_count = bucket_count;
+
+    for (size_t bucket = 0; bucket < bucket_count; bucket++)
+    {
+        size_t length = 0;
+
+        // The length limit stops a corrupted chain which loops
+        for (size_t sym_idx = get_word(data, 2 + bucket); (sym_idx != STN_UNDEF) && (sym_idx < chain_count) && (length < chain_count);
+            sym_idx = get_word(data, 2 + bucket_count + sym_idx))
+        {
+            length++;
+        }
+
+        add_chain(stats, length);
+    }
+
+    return true;
+}
+
+// nbuckets, symoffset, bloom_size, bloom_shift, the bloom filter words (of the file's class),
+// the buckets and one hash value per symbol from symoffset on; bit 0 of a hash value ends a chain
+static bool analyze_gnu_hash(Elf *sElf, const Elf_Data *data, const size_t dynsym_count, hash_stats *stats)
+{
+    size_t bloom_word_size = (gelf_getclass(sElf) == ELFCLASS32) ? sizeof(uint32_t) : sizeof(uint64_t);
+
+    if (data->d_size < GNU_HASH_HEADER_WORDS * sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    stats->gnu = true;
+    stats->bucket_count = get_word(data, 0);
+    stats->sym_offset = get_word(data, 1);
+    stats->bloom_words = get_word(data, 2);
+    stats->bloom_shift = get_word(data, 3);
+    stats->bloom_word_bits = bloom_word_size * 8;
+
+    size_t bloom_offset = GNU_HASH_HEADER_WORDS * sizeof(uint32_t);
+    size_t bucket_offset = bloom_offset + stats->bloom_words * bloom_word_size;
+    size_t chain_offset = bucket_offset + stats->bucket_count * sizeof(uint32_t);
+
+    if ((stats->bloom_words > data->d_size) || (stats->bucket_count > data->d_size) || (chain_offset > data->d_size))
+    {
+        return false;
+    }
+
+    for (size_t word_idx = 0; word_idx < stats->bloom_words; word_idx++)
+    {
+        uint64_t word = 0;
+        memcpy(&word, (const unsigned char *) data->d_buf + bloom_offset + word_idx * bloom_word_size, bloom_word_size);
+        stats->bloom_set_bits += __builtin_popcountll(word);
+    }
+
+    size_t chain_count = (data->d_size - chain_offset) / sizeof(uint32_t);
+    if ((dynsym_count > stats->sym_offset) && (dynsym_count - stats->sym_offset < chain_count))
+    {
+        chain_count = dynsym_count - stats->sym_offset;
+    }
+
+    for (size_t bucket = 0; bucket < stats->bucket_count; bucket++)
+    {
+        size_t sym_idx = get_word(data, bucket_offset / sizeof(uint32_t) + bucket);
+        size_t length = 0;
+
+        while ((sym_idx >= stats->sym_offset) && (sym_idx - stats->sym_offset < chain_count) && (sym_idx != STN_UNDEF))
+        {
+            length++;
+
+            if (get_word(data, chain_offset / sizeof(uint32_t) + sym_idx - stats->sym_offset) & 1)
+            {
+                break;
+            }
+
+            sym_idx++;
+        }
+
+        add_chain(stats, length);
+    }
+
+    return true;
+}
+
+static bool analyze_hash_section(const efb_file *file, const size_t sect_idx, hash_stats *stats)
+{
+    const efb_sect_table *sections = &file->sections;
+    Elf_Data *data = efb_elf_getdata(sections->scn[sect_idx], NULL);
+    size_t sym_sect_idx = sections->link[sect_idx];
+    size_t dynsym_count = 0;
+
+    memset(stats, 0, sizeof(hash_stats));
+
+    if ((data == NULL) || (data->d_buf == NULL))
+    {
+        return false;
+    }
+
+    if ((sym_sect_idx > 0) && (sym_sect_idx < sections->count) && (sections->entsize[sym_sect_idx] > 0))
+    {
+        dynsym_count = sections->size[sym_sect_idx] / sections->entsize[sym_sect_idx];
+    }
+
+    return (sections->type[sect_idx] == SHT_GNU_HASH) ? analyze_gnu_hash(file->sElf, data, dynsym_count, stats)
+        : analyze_sysv_hash(data, stats);
+}
+
+static double get_bloom_fill(const hash_stats *stats)
+{
+    size_t bloom_bits = stats->bloom_words * stats->bloom_word_bits;
+
+    return (bloom_bits > 0) ? (double) stats->bloom_set_bits / bloom_bits : 0.0;
+}
+
+static unsigned int get_hash_problems(const hash_stats *stats)
+{
+    unsigned int problems = 0;
+    double load = (stats->bucket_count > 0) ? (double) stats->sym_count / stats->bucket_count : 0.0;
+
+    if (load > HASH_MAX_LOAD)
+    {
+        problems |= HASH_FEW_BUCKETS;
+    }
+
+    if ((stats->bucket_count >= HASH_MIN_FLAGGED_BUCKETS) && (load < HASH_MIN_LOAD))
+    {
+        problems |= HASH_SPARSE;
+    }
+
+    if (stats->gnu && (get_bloom_fill(stats) > HASH_MAX_BLOOM_FILL))
+    {
+        problems |= HASH_BLOOM_FULL;
+    }
+
+    return problems;
+}
+
+static void print_hash_stats(const hash_stats *stats, efb_buffer *out_buffer)
+{
+    double load = (stats->bucket_count > 0) ? (double) stats->sym_count / stats->bucket_count : 0.0;
+    size_t used_buckets = stats->bucket_count - stats->empty_count;
+    // Each symbol sets two bits of one bloom word, a missing symbol gets through when both of its bits are set
+    double false_positives = get_bloom_fill(stats) * get_bloom_fill(stats);
+
+    efb_buf_printf(out_buffer, "%s hash table\n", stats->gnu ? "GNU" : "SysV");
+    efb_buf_printf(out_buffer, "  buckets            %zu\n", stats->bucket_count);
+    efb_buf_printf(out_buffer, "  hashed symbols     %zu", stats->sym_count);
+    if (stats->gnu)
+    {
+        efb_buf_printf(out_buffer, " (from symbol %zu)", stats->sym_offset);
+    }
+
+    efb_buf_printf(out_buffer, "\n  empty buckets      %zu (%.1f%%)\n", stats->empty_count,
+        (stats->bucket_count > 0) ? 100.0 * stats->empty_count / stats->bucket_count : 0.0);
+    efb_buf_printf(out_buffer, "  symbols per bucket %.2f (%.2f in the used buckets)\n", load,
+        (used_buckets > 0) ? (double) stats->sym_count / used_buckets : 0.0);
+    efb_buf_printf(out_buffer, "  longest chain      %zu\n", stats->max_chain);
+
+    if (stats->gnu)
+    {
+        efb_buf_printf(out_buffer, "  bloom filter       %zu x %zu bits, shift %u, %.1f%% set, %.1f%% false positives\n",
+            stats->bloom_words, stats->bloom_word_bits, stats->bloom_shift, 100.0 * get_bloom_fill(stats), 100.0 * false_positives);
+    }
+
+    // A lookup compares the symbols of its bucket's chain: GNU compares hash values first, SysV the names
+    efb_buf_printf(out_buffer, "  probes per lookup  %.2f found, %.2f not found (%s compares)\n",
+        (stats->sym_count > 0) ? stats->hit_probes / stats->sym_count : 0.0,
+        stats->gnu ? false_positives * load : load, stats->gnu ? "hash" : "string");
+
+    efb_buf_printf(out_buffer, "\n  %-12s %10s\n", "Chain length", "Buckets");
+    for (size_t length = 0; length < HASH_HISTOGRAM_SIZE; length++)
+    {
+        size_t count = stats->histogram[length];
+        double share = (stats->bucket_count > 0) ? (double) count / stats->bucket_count : 0.0;
+
+        int bar_width = (int) (share * HASH_BAR_WIDTH + 0.5);
+
+        efb_buf_printf(out_buffer, "  %11zu%s %10zu %6.1f%%%s", length, (length == HASH_HISTOGRAM_SIZE - 1) ? "+" : " ", count,
+            100.0 * share, (bar_width > 0) ? " " : "");
+        for (int bar = 0; bar < bar_width; bar++)
+        {
+            efb_buf_putc(out_buffer, '#');
+        }
+
+        efb_buf_putc(out_buffer, '\n');
+    }
+
+    unsigned int problems = get_hash_problems(stats);
+    if (problems != 0)
+    {
+        efb_buf_printf(out_buffer, "\n");
+    }
+
+    if (problems & HASH_FEW_BUCKETS)
+    {
+        efb_buf_printf(out_buffer, "Warning: too few buckets, every lookup walks a chain of %.1f symbols on average\n", load);
+    }
+
+    if (problems & HASH_SPARSE)
+    {
+        efb_buf_printf(out_buffer, "Warning: too many buckets, most of the table is empty\n");
+    }
+
+    if (problems & HASH_BLOOM_FULL)
+    {
+        efb_buf_printf(out_buffer, "Warning: the bloom filter is too small, %.0f%% of the missing symbols get through it\n",
+            100.0 * false_positives);
+    }
+}
+
+void efb_info_sect_hash(const efb_file *file, const int section_idx, GElf_Shdr *sect_header, efb_view * view)
+{
+    efb_buffer *out_buffer = &view->text;
+    hash_stats stats;
+
+    efb_get_secthdr_struct(sect_header, out_buffer);
+
+    if (analyze_hash_section(file, section_idx, &stats) == false)
+    {
+        efb_buf_printf(out_buffer, "Invalid hash table\n");
+        return;
+    }
+
+    print_hash_stats(&stats, out_buffer);
+
+    // ld.so only uses the SysV table of a library which has no GNU one
+    if (stats.gnu == false)
+    {
+        bool has_gnu_hash = false;
+
+        for (size_t sect_idx = 1; sect_idx < file->sections.count; sect_idx++)
+        {
+            has_gnu_hash |= (file->sections.type[sect_idx] == SHT_GNU_HASH);
+        }
+
+        if (has_gnu_hash == false)
+        {
+            efb_buf_printf(out_buffer, "\nNote: there is no GNU hash table, every lookup compares symbol names\n");
+        }
+    }
+}
+
+// The --scan summary: the hash tables and what is wrong with their size, e.g. hash=[gnu(few-buckets),sysv]
+void efb_summarize_hash_tables(const efb_file *file, efb_buffer *line)
+{
+    static const char *problem_names[] = { "few-buckets", "sparse", "bloom-full" };
+    bool first_table = true;
+
+    efb_buf_printf(line, " hash=[");
+
+    for (size_t sect_idx = 1; sect_idx < file->sections.count; sect_idx++)
+    {
+        hash_stats stats;
+
+        if (((file->sections.type[sect_idx] != SHT_HASH) && (file->sections.type[sect_idx] != SHT_GNU_HASH))
+            || (analyze_hash_section(file, sect_idx, &stats) == false))
+        {
+            continue;
+        }
+
+        efb_buf_printf(line, "%s%s", first_table ? "" : ",", stats.gnu ? "gnu" : "sysv");
+        first_table = false;
+
+        unsigned int problems = get_hash_problems(&stats);
+        bool first_problem = true;
+
+        for (size_t problem_idx = 0; problem_idx < sizeof(problem_names) / sizeof(problem_names[0]); problem_idx++)
+        {
+            if (problems & (1u << problem_idx))
+            {
+                efb_buf_printf(line, "%s%s", first_problem ? "(" : ",", problem_names[problem_idx]);
+                first_problem = false;
+            }
+        }
+
+        efb_buf_printf(line, "%s", first_problem ? "" : ")");
+    }
+
+    efb_buf_printf(line, "]");
+}
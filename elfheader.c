@@ -4,7 +4,8 @@
 #include <string.h>
 
 #define CUSTOM_BUFFER_SIZE 50
-static char custom_buf[CUSTOM_BUFFER_SIZE];
+// One per thread, the header and the segments may be rendered at the same time
+static _Thread_local char custom_buf[CUSTOM_BUFFER_SIZE];
 
 static char * get_elf_data(const int elf_data)
 {
@@ -64,7 +65,33 @@ static char * get_elf_ssabi(unsigned int elf_osabi)
     }
 }
 
-static char * get_elf_type(const int elf_type)
+// As readelf does, a DYN file is a PIE if its dynamic section has DF_1_PIE in DT_FLAGS_1
+static bool is_pie(const efb_sect_table *sections)
+{
+    GElf_Dyn elf_dyn;
+
+    for (size_t sect_idx = 0; sect_idx < sections->count; sect_idx++)
+    {
+        Elf_Data *elf_data;
+
+        if ((sections->type[sect_idx] != SHT_DYNAMIC) || ((elf_data = efb_elf_getdata(sections->scn[sect_idx], NULL)) == NULL))
+        {
+            continue;
+        }
+
+        for (int idx = 0; (gelf_getdyn(elf_data, idx, &elf_dyn) != NULL) && (elf_dyn.d_tag != DT_NULL); idx++)
+        {
+            if (elf_dyn.d_tag == DT_FLAGS_1)
+            {
+                return (elf_dyn.d_un.d_val & DF_1_PIE) != 0;
+            }
+        }
+    }
+
+    return false;
+}
+
+static char * get_elf_type(const int elf_type, const efb_sect_table *sections)
 {
     switch (elf_type)
     {
@@ -75,12 +102,7 @@ static char * get_elf_type(const int elf_type)
     case ET_EXEC:
         return "EXEC (Executable file)";
     case ET_DYN:
-        return "DYN (TODO: return the correct DYN type - PIE or SO)";
-// TODO get the correct DYN type (as it is done by the readelf app)
-//    case ET_DYN:
-//        return "DYN (Position-Independent Executable file)";
-//    case ET_DYN:
-//        return "DYN (Shared object file)";
+        return is_pie(sections) ? "DYN (Position-Independent Executable file)" : "DYN (Shared object file)";
     case ET_CORE:
         return "CORE (Core file)";
         break;
@@ -128,8 +150,9 @@ static char * get_machine(const int machine)
     }
 }
 
-void efb_get_elf_header(Elf * sElf, char * out_buffer)
+void efb_get_elf_header(const efb_file *file, efb_buffer * out_buffer)
 {
+    Elf *sElf = file->sElf;
     int elf_class;
     char * elf_ident;
     GElf_Ehdr elf_hdr;
@@ -140,7 +163,7 @@ void efb_get_elf_header(Elf * sElf, char * out_buffer)
         exit(EXIT_FAILURE);
     }
 
-    sprintf(&out_buffer[strlen(out_buffer)], "ELF Header:\n");
+    efb_buf_printf(out_buffer, "ELF Header:\n");
 
     if ((elf_ident = elf_getident(sElf, NULL)) == NULL)
     {
@@ -148,14 +171,14 @@ void efb_get_elf_header(Elf * sElf, char * out_buffer)
         exit(EXIT_FAILURE);
     }
 
-    sprintf(&out_buffer[strlen(out_buffer)], "  Magic:                             ");
+    efb_buf_printf(out_buffer, "  Magic:                             ");
 
     for (int idx = 0; idx < EI_NIDENT; idx++)
     {
-        sprintf(&out_buffer[strlen(out_buffer)], "%02X ", elf_ident[idx]);
+        efb_buf_printf(out_buffer, "%02X ", elf_ident[idx]);
     }
 
-    sprintf(&out_buffer[strlen(out_buffer)], "\n");
+    efb_buf_printf(out_buffer, "\n");
 
     if ((elf_class = gelf_getclass(sElf)) == ELFCLASSNONE)
     {
@@ -163,23 +186,58 @@ void efb_get_elf_header(Elf * sElf, char * out_buffer)
         exit(EXIT_FAILURE);
     }
 
-    sprintf(&out_buffer[strlen(out_buffer)], "  Class:                             ELF%d\n", elf_class == ELFCLASS32 ? 32 : 64);
-
-    sprintf(&out_buffer[strlen(out_buffer)], "  Data:                              %s\n", get_elf_data(elf_ident[EI_DATA]));
-    sprintf(&out_buffer[strlen(out_buffer)], "  Version:                           %s\n", get_elf_version(elf_ident[EI_VERSION]));
-    sprintf(&out_buffer[strlen(out_buffer)], "  OS/ABI:                            %s\n", get_elf_ssabi(elf_ident[EI_OSABI]));
-    sprintf(&out_buffer[strlen(out_buffer)], "  ABI Version:                       %d\n", elf_ident[EI_ABIVERSION]);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Type:                              %s\n", get_elf_type(elf_hdr.e_type));
-    sprintf(&out_buffer[strlen(out_buffer)], "  Machine:                           %s\n", get_machine(elf_hdr.e_machine));
-    sprintf(&out_buffer[strlen(out_buffer)], "  Version:                           0x%x\n", elf_hdr.e_version);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Entry point address:               0x%lx\n", elf_hdr.e_entry);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Start of program headers:          %lu (bytes into file)\n", elf_hdr.e_phoff);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Start of section headers:          %lu (bytes into file)\n", elf_hdr.e_shoff);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Flags:                             0x%x\n", elf_hdr.e_flags);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Size of this header:               %d (bytes)\n", elf_hdr.e_ehsize);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Size of program headers:           %d (bytes)\n", elf_hdr.e_phentsize);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Number of program headers:         %d\n", elf_hdr.e_phnum);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Size of section headers:           %d (bytes)\n", elf_hdr.e_shentsize);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Number of section headers:         %d\n", elf_hdr.e_shnum);
-    sprintf(&out_buffer[strlen(out_buffer)], "  Section header string table index: %d\n", elf_hdr.e_shstrndx);
+    efb_buf_printf(out_buffer, "  Class:                             ELF%d\n", elf_class == ELFCLASS32 ? 32 : 64);
+
+    efb_buf_printf(out_buffer, "  Data:                              %s\n", get_elf_data(elf_ident[EI_DATA]));
+    efb_buf_printf(out_buffer, "  Version:                           %s\n", get_elf_version(elf_ident[EI_VERSION]));
+    efb_buf_printf(out_buffer, "  OS/ABI:                            %s\n", get_elf_ssabi(elf_ident[EI_OSABI]));
+    efb_buf_printf(out_buffer, "  ABI Version:                       %d\n", elf_ident[EI_ABIVERSION]);
+    efb_buf_printf(out_buffer, "  Type:                              %s\n", get_elf_type(elf_hdr.e_type, &file->sections));
+    efb_buf_printf(out_buffer, "  Machine:                           %s\n", get_machine(elf_hdr.e_machine));
+    efb_buf_printf(out_buffer, "  Version:                           0x%x\n", elf_hdr.e_version);
+    efb_buf_printf(out_buffer, "  Entry point address:               0x%lx\n", elf_hdr.e_entry);
+    efb_buf_printf(out_buffer, "  Start of program headers:          %lu (bytes into file)\n", elf_hdr.e_phoff);
+    efb_buf_printf(out_buffer, "  Start of section headers:          %lu (bytes into file)\n", elf_hdr.e_shoff);
+    efb_buf_printf(out_buffer, "  Flags:                             0x%x\n", elf_hdr.e_flags);
+    efb_buf_printf(out_buffer, "  Size of this header:               %d (bytes)\n", elf_hdr.e_ehsize);
+    efb_buf_printf(out_buffer, "  Size of program headers:           %d (bytes)\n", elf_hdr.e_phentsize);
+    efb_buf_printf(out_buffer, "  Number of program headers:         %d\n", elf_hdr.e_phnum);
+    efb_buf_printf(out_buffer, "  Size of section headers:           %d (bytes)\n", elf_hdr.e_shentsize);
+    efb_buf_printf(out_buffer, "  Number of section headers:         %d\n", elf_hdr.e_shnum);
+    efb_buf_printf(out_buffer, "  Section header string table index: %d\n", elf_hdr.e_shstrndx);
+}
+
+void efb_json_elf_header(const efb_file *file, efb_json_writer * writer)
+{
+    Elf *sElf = file->sElf;
+    char * elf_ident;
+    GElf_Ehdr elf_hdr;
+
+    if ((gelf_getehdr(sElf, &elf_hdr) == NULL) || ((elf_ident = elf_getident(sElf, NULL)) == NULL))
+    {
+        printf("gelf_getehdr() failed: %s.\n", elf_errmsg(-1));
+        exit(EXIT_FAILURE);
+    }
+
+    efb_json_begin_record(writer, "header");
+    efb_json_uint(writer, "class", gelf_getclass(sElf) == ELFCLASS32 ? 32 : 64);
+    efb_json_string(writer, "data", get_elf_data(elf_ident[EI_DATA]));
+    efb_json_string(writer, "os_abi", get_elf_ssabi(elf_ident[EI_OSABI]));
+    efb_json_uint(writer, "abi_version", (unsigned char) elf_ident[EI_ABIVERSION]);
+    efb_json_uint(writer, "e_type", elf_hdr.e_type);
+    efb_json_string(writer, "elf_type", get_elf_type(elf_hdr.e_type, &file->sections));
+    efb_json_uint(writer, "e_machine", elf_hdr.e_machine);
+    efb_json_string(writer, "machine", get_machine(elf_hdr.e_machine));
+    efb_json_uint(writer, "version", elf_hdr.e_version);
+    efb_json_hex(writer, "entry", elf_hdr.e_entry);
+    efb_json_uint(writer, "phoff", elf_hdr.e_phoff);
+    efb_json_uint(writer, "shoff", elf_hdr.e_shoff);
+    efb_json_hex(writer, "flags", elf_hdr.e_flags);
+    efb_json_uint(writer, "ehsize", elf_hdr.e_ehsize);
+    efb_json_uint(writer, "phentsize", elf_hdr.e_phentsize);
+    efb_json_uint(writer, "phnum", elf_hdr.e_phnum);
+    efb_json_uint(writer, "shentsize", elf_hdr.e_shentsize);
+    efb_json_uint(writer, "shnum", elf_hdr.e_shnum);
+    efb_json_uint(writer, "shstrndx", elf_hdr.e_shstrndx);
+    efb_json_end_record(writer);
 }
@@ -1,37 +1,192 @@
 #include "elfibia.h"
 
+#include <err.h>
+#include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
-#include <fcntl.h>
+#include <string.h>
 #include <gelf.h>
 
 #define MENU_IDX_ELF_HEADER 0
 #define MENU_IDX_SEGMENTS_SUMMARY 1
 #define MENU_IDX_SECTIONS_SUMMARY 2
 #define MENU_IDX_FIRST_SECTION (MENU_IDX_SECTIONS_SUMMARY + 1)
+// The diff with the --compare file follows the sections
+#define MENU_IDX_DIFF (MENU_IDX_FIRST_SECTION + efb_ctx.file.sections.count)
 
-// TODO Use a dynamic buffer
-#define CONTENT_BUF_SIZE 5000000
-static char content_buf[CONTENT_BUF_SIZE];
+#define DEFAULT_CACHE_SIZE_MB 64
+
+typedef enum
+{
+    DUMP_FORMAT_TEXT,
+    DUMP_FORMAT_JSON,
+    DUMP_FORMAT_NDJSON
+} dump_format;
+#define MAX_BYTE_MATCHES (1 << 20)
+#define DUMP_STDOUT_BUFFER_SIZE (1 << 20)
+
+// The byte search runs as a job of the render threads, beside the menu items
+#define BYTE_SEARCH_JOB -1
+
+// Passed to the byte search job, which frees it
+typedef struct
+{
+    size_t length;
+    unsigned char data[];
+} byte_search_pattern;
+
+// The rows of the byte search results, released with the search view
+typedef struct
+{
+    const efb_sect_table *sections;
+    efb_byte_matches matches;
+} byte_match_rows;
+
+// A previous version of the reloaded file, kept open while cached views or the indexes point into it
+typedef struct
+{
+    efb_file file;
+    unsigned int generation;
+} retired_file;
 
 typedef struct
 {
-    int elf_file_desc;
+    efb_file file;
     size_t menu_item_count;
     Elf *sElf;
-    item_data *main_menu_data;
+    size_t cache_size;
+    const char *dump_items;
+    dump_format dump_format;
+    const char *scan_path;
+    bool diff_files;
+    const char *compare_path;
+    efb_file compare_file;
+    efb_view_cache view_cache;
+    bool sym_index_built;
+    efb_sym_index sym_index;
+    unsigned int sym_index_generation;
+    efb_sym_matches sym_matches;
+    efb_view search_view;
+    efb_buffer byte_pattern;
+    bool byte_search_running;
+    bool addr_index_built;
+    efb_addr_index addr_index;
+    unsigned int addr_index_generation;
+    efb_file_watch watch;
+    efb_file_fingerprint fingerprint;
+    unsigned int generation;
+    unsigned int *item_generation;
+    retired_file *retired_files;
+    size_t retired_count;
 } efb_context;
 
 efb_context efb_ctx;
 
-static void efb_init(efb_context *efb_ctx, int argc, char **argv)
+static void print_usage(const char *app_name)
+{
+    printf("Usage: %s [--cache-size=MB] [--compare=OLD] [--dump=ITEMS [--format=text|json|ndjson]] file-name\n", app_name);
+    printf("       %s --scan DIR\n", app_name);
+    printf("       %s --diff old-file new-file\n", app_name);
+    printf("  --cache-size=MB  memory used to keep the recently viewed items (default: %d MB)\n", DEFAULT_CACHE_SIZE_MB);
+    printf("  --dump=ITEMS     write the comma-separated items to stdout instead of starting the viewer;\n");
+    printf("                   an item is header, segments, sections, a section name (e.g. .dynamic) or all\n");
+    printf("  --format=FORMAT  output format of --dump: text (default), json or ndjson (one record per line)\n");
+    printf("  --scan DIR       write a one-line summary of every ELF file under DIR\n");
+    printf("  --diff           write the differences between the two files to stdout\n");
+    printf("  --compare=OLD    add a diff of OLD against the file to the viewer's menu\n");
+}
+
+static void parse_args(efb_context *efb_ctx, int argc, char **argv)
 {
-    if (argc != 2)
+    static const struct option long_options[] =
+    {
+        { "cache-size", required_argument, NULL, 'c' },
+        { "dump", required_argument, NULL, 'd' },
+        { "format", required_argument, NULL, 'f' },
+        { "scan", required_argument, NULL, 's' },
+        { "diff", no_argument, NULL, 'D' },
+        { "compare", required_argument, NULL, 'C' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int option;
+    efb_ctx->cache_size = (size_t) DEFAULT_CACHE_SIZE_MB << 20;
+    efb_ctx->dump_items = NULL;
+    efb_ctx->dump_format = DUMP_FORMAT_TEXT;
+    efb_ctx->scan_path = NULL;
+    efb_ctx->diff_files = false;
+    efb_ctx->compare_path = NULL;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (option)
+        {
+        case 'c':
+        {
+            char *end_ptr;
+            unsigned long cache_size_mb = strtoul(optarg, &end_ptr, 10);
+            if ((*optarg == '\0') || (*end_ptr != '\0'))
+            {
+                printf("Invalid cache size: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+
+            efb_ctx->cache_size = (size_t) cache_size_mb << 20;
+            break;
+        }
+        case 'd':
+            efb_ctx->dump_items = optarg;
+            break;
+        case 'f':
+            if (strcmp(optarg, "text") == 0)
+            {
+                efb_ctx->dump_format = DUMP_FORMAT_TEXT;
+            }
+            else if (strcmp(optarg, "json") == 0)
+            {
+                efb_ctx->dump_format = DUMP_FORMAT_JSON;
+            }
+            else if (strcmp(optarg, "ndjson") == 0)
+            {
+                efb_ctx->dump_format = DUMP_FORMAT_NDJSON;
+            }
+            else
+            {
+                printf("Invalid format: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 's':
+            efb_ctx->scan_path = optarg;
+            break;
+        case 'D':
+            efb_ctx->diff_files = true;
+            break;
+        case 'C':
+            efb_ctx->compare_path = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            exit(EXIT_SUCCESS);
+        default:
+            print_usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int file_count = (efb_ctx->scan_path != NULL) ? 0 : (efb_ctx->diff_files ? 2 : 1);
+    if (optind != argc - file_count)
     {
-        printf("Usage: %s file-name\n", argv[0]);
+        print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
+}
+
+static void efb_init(efb_context *efb_ctx, int argc, char **argv)
+{
+    parse_args(efb_ctx, argc, argv);
 
     if (elf_version(EV_CURRENT) == EV_NONE)
     {
@@ -39,64 +194,789 @@ static void efb_init(efb_context *efb_ctx, int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
-    if ((efb_ctx->elf_file_desc = open(argv[1], O_RDONLY, 0)) < 0)
+    if (efb_ctx->scan_path != NULL)
     {
-        printf("Cannot open %s\n", argv[1]);
-        exit(EXIT_FAILURE);
+        return;
     }
 
-    if ((efb_ctx->sElf = elf_begin(efb_ctx->elf_file_desc, ELF_C_READ, NULL)) == NULL)
+    if (efb_file_open(&efb_ctx->file, argv[optind]) == false)
     {
-        printf("elf_begin() failed: %s\n", elf_errmsg(-1));
+        printf("Cannot open %s: %s\n", argv[optind], efb_ctx->file.error);
         exit(EXIT_FAILURE);
     }
 
-    if (elf_kind(efb_ctx->sElf) != ELF_K_ELF)
+    efb_ctx->sElf = efb_ctx->file.sElf;
+
+    const char *compare_path = efb_ctx->diff_files ? argv[optind + 1] : efb_ctx->compare_path;
+    if ((compare_path != NULL) && (efb_file_open(&efb_ctx->compare_file, compare_path) == false))
     {
-        printf("%s is not an ELF object\n", argv[1]);
+        printf("Cannot open %s: %s\n", compare_path, efb_ctx->compare_file.error);
         exit(EXIT_FAILURE);
     }
+}
+
+static void render_byte_matches(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer * out_buffer)
+{
+    const byte_match_rows *rows = rows_data;
+    const efb_sect_table *sections = rows->sections;
+
+    for (size_t row_idx = first_row; row_idx < first_row + row_count; row_idx++)
+    {
+        const efb_byte_match *match = &rows->matches.entries[row_idx];
+
+        efb_buf_printf(out_buffer, "%-24.24s offset 0x%012lx", sections->name[match->sect_idx], match->offset);
+        if (sections->addr[match->sect_idx] != 0)
+        {
+            efb_buf_printf(out_buffer, "  vaddr 0x%016lx", sections->addr[match->sect_idx] + match->offset);
+        }
+        efb_buf_putc(out_buffer, '\n');
+    }
+}
+
+static void release_byte_matches(void *rows_data)
+{
+    byte_match_rows *rows = rows_data;
 
-    efb_ctx->main_menu_data = NULL;
+    free(rows->matches.entries);
+    free(rows);
 }
 
-char * efb_get_menu_item_content(const int menu_item_idx)
+// Runs on a render thread; a cancelled search ends early and its view is dropped
+static void search_bytes(const byte_search_pattern *pattern, efb_view *view)
 {
-    content_buf[0] = '\0';
+    byte_match_rows *rows = calloc(1, sizeof(byte_match_rows));
+    if (rows == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the pattern search results.");
+    }
+
+    rows->sections = &efb_ctx.file.sections;
+    efb_pattern_search(&efb_ctx.file, pattern->data, pattern->length, MAX_BYTE_MATCHES, &rows->matches);
+
+    efb_view_add_rows(view, &(efb_row_source) {
+        .row_count = rows->matches.count,
+        .rows_data_size = sizeof(byte_match_rows) + rows->matches.capacity * sizeof(efb_byte_match),
+        .render_rows = render_byte_matches,
+        .release = release_byte_matches,
+        .rows_data = rows,
+    });
+}
 
+// Runs on a render thread
+static void render_menu_item(const int menu_item_idx, const void *arg, efb_view *content_view)
+{
+    if (menu_item_idx == BYTE_SEARCH_JOB)
+    {
+        search_bytes(arg, content_view);
+    }
+    else if (menu_item_idx == MENU_IDX_ELF_HEADER)
+    {
+        efb_get_elf_header(&efb_ctx.file, &content_view->text);
+    }
+    else if (menu_item_idx == MENU_IDX_SEGMENTS_SUMMARY)
+    {
+        efb_get_segment_content(efb_ctx.sElf, &content_view->text);
+    }
+    else if ((efb_ctx.compare_path != NULL) && ((size_t) menu_item_idx == MENU_IDX_DIFF))
+    {
+        efb_diff_files(&efb_ctx.compare_file, &efb_ctx.file, &content_view->text);
+    }
+    else if (menu_item_idx == MENU_IDX_SECTIONS_SUMMARY)
+    {
+        efb_get_sections_summary(&efb_ctx.file, &content_view->text);
+    }
+    else
+    {
+        efb_get_section_content(&efb_ctx.file, menu_item_idx - MENU_IDX_FIRST_SECTION, content_view);
+    }
+
+    efb_view_finish(content_view);
+}
+
+// The menu shows only a window of its items, so their names are read from the section table when drawn
+void efb_get_menu_item_data(const int menu_item_idx, item_data *it_data)
+{
     if (menu_item_idx == MENU_IDX_ELF_HEADER)
     {
-        efb_get_elf_header(efb_ctx.sElf, content_buf);
+        *it_data = (item_data) {"ELF Header", "<info>"};
     }
     else if (menu_item_idx == MENU_IDX_SEGMENTS_SUMMARY)
     {
-        efb_get_segment_content(efb_ctx.sElf, content_buf);
+        *it_data = (item_data) {"Segments", "<info>"};
     }
     else if (menu_item_idx == MENU_IDX_SECTIONS_SUMMARY)
     {
-        // TODO
-        return "FIX ME: return a sections' summary";
+        *it_data = (item_data) {"Sections", "<info"};
+    }
+    else if ((efb_ctx.compare_path != NULL) && ((size_t) menu_item_idx == MENU_IDX_DIFF))
+    {
+        *it_data = (item_data) {"Diff", "<diff>"};
     }
     else
     {
-        efb_get_section_content(efb_ctx.sElf, menu_item_idx - MENU_IDX_FIRST_SECTION, content_buf);
+        efb_get_sect_name_and_type(&efb_ctx.file, menu_item_idx - MENU_IDX_FIRST_SECTION, it_data);
     }
+}
+
+// Returns NULL while the item is being rendered in the background, efb_poll_menu_item_content()
+// tells when a render has finished
+efb_view * efb_get_menu_item_content(const int menu_item_idx)
+{
+    efb_view *content_view = efb_cache_get(&efb_ctx.view_cache, menu_item_idx);
 
-    return content_buf;
+    efb_render_cancel_others(menu_item_idx);
+
+    if (content_view != NULL)
+    {
+        efb_cache_pin(&efb_ctx.view_cache, menu_item_idx);
+        return content_view;
+    }
+
+    efb_render_request(menu_item_idx, false);
+    return NULL;
+}
+
+// Moves the finished renders into the view cache; returns true if there were any
+bool efb_poll_menu_item_content(void)
+{
+    bool rendered = false;
+    int menu_item_idx;
+    efb_view content_view;
+
+    while (efb_render_take(&menu_item_idx, &content_view))
+    {
+        if (menu_item_idx == BYTE_SEARCH_JOB)
+        {
+            efb_view_free(&efb_ctx.search_view);
+            efb_ctx.search_view = content_view;
+            efb_ctx.byte_search_running = false;
+            rendered = true;
+            continue;
+        }
+
+        efb_cache_put(&efb_ctx.view_cache, menu_item_idx, &content_view);
+        efb_ctx.item_generation[menu_item_idx] = efb_ctx.generation;
+        rendered = true;
+    }
+
+    return rendered;
+}
+
+// Sorts the displayed view; a new sort order may grow it, so its size in the cache is updated
+bool efb_sort_menu_item_content(const int menu_item_idx)
+{
+    efb_view *content_view = efb_cache_get(&efb_ctx.view_cache, menu_item_idx);
+
+    if ((content_view == NULL) || (efb_view_sort(content_view) == false))
+    {
+        return false;
+    }
+
+    efb_cache_commit(&efb_ctx.view_cache, menu_item_idx);
+    return true;
+}
+
+int efb_get_menu_item_progress(const int menu_item_idx)
+{
+    return efb_render_progress(menu_item_idx);
+}
+
+// Renders the neighbours of the item in advance, so moving the selection shows them at once
+void efb_prefetch_menu_items(const int menu_item_idx)
+{
+    for (int item_idx = menu_item_idx - 1; item_idx <= menu_item_idx + 1; item_idx++)
+    {
+        if ((item_idx >= 0) && ((size_t) item_idx < efb_ctx.menu_item_count)
+            && (efb_cache_contains(&efb_ctx.view_cache, item_idx) == false))
+        {
+            efb_render_request(item_idx, true);
+        }
+    }
+}
+
+static void render_symbol_matches(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer * out_buffer)
+{
+    const efb_context *efb_ctx = rows_data;
+    const efb_sym_index *index = &efb_ctx->sym_index;
+
+    for (size_t row_idx = first_row; row_idx < first_row + row_count; row_idx++)
+    {
+        uint32_t entry_idx = efb_ctx->sym_matches.entries[row_idx];
+
+        efb_buf_printf(out_buffer, "0x%016lx %-16.16s %s\n", index->value[entry_idx],
+            efb_ctx->file.sections.name[index->sect_idx[entry_idx]], index->names[entry_idx]);
+    }
+}
+
+// Returns a view listing the symbols matching the query; the index is built on the first search
+efb_view * efb_search_symbols(const char *query, size_t *match_count)
+{
+    if (efb_ctx.sym_index_built == false)
+    {
+        efb_sym_index_build(&efb_ctx.file, &efb_ctx.sym_index);
+        efb_ctx.sym_index_built = true;
+        efb_ctx.sym_index_generation = efb_ctx.generation;
+    }
+
+    efb_sym_index_search(&efb_ctx.sym_index, query, &efb_ctx.sym_matches);
+
+    efb_view_reset(&efb_ctx.search_view);
+    efb_view_add_rows(&efb_ctx.search_view, &(efb_row_source) {
+        .row_count = efb_ctx.sym_matches.count,
+        .render_rows = render_symbol_matches,
+        .rows_data = &efb_ctx,
+    });
+    efb_view_finish(&efb_ctx.search_view);
+
+    *match_count = efb_ctx.sym_matches.count;
+    return &efb_ctx.search_view;
+}
+
+// Tells which menu item shows the matched symbol and which symbol of its table it is
+bool efb_get_symbol_match(const size_t match_idx, int *menu_item_idx, size_t *sym_idx)
+{
+    if (match_idx >= efb_ctx.sym_matches.count)
+    {
+        return false;
+    }
+
+    uint32_t entry_idx = efb_ctx.sym_matches.entries[match_idx];
+    *menu_item_idx = MENU_IDX_FIRST_SECTION + efb_ctx.sym_index.sect_idx[entry_idx];
+    *sym_idx = efb_ctx.sym_index.sym_idx[entry_idx];
+
+    return true;
+}
+
+// The results of the last byte search, or NULL if the search view shows something else
+static const efb_byte_matches * get_byte_matches(void)
+{
+    const efb_view *view = &efb_ctx.search_view;
+
+    if ((view->block_count == 0) || (view->blocks[0].source.render_rows != render_byte_matches))
+    {
+        return NULL;
+    }
+
+    return &((const byte_match_rows *) view->blocks[0].source.rows_data)->matches;
+}
+
+// Starts searching for the hex or "text pattern in the section data in the background, replacing a running
+// search; returns false if the pattern is invalid
+bool efb_start_byte_search(const char *pattern_text)
+{
+    efb_render_cancel(BYTE_SEARCH_JOB);
+    efb_ctx.byte_search_running = false;
+
+    if (efb_pattern_parse(pattern_text, &efb_ctx.byte_pattern) == false)
+    {
+        return false;
+    }
+
+    byte_search_pattern *pattern = malloc(sizeof(byte_search_pattern) + efb_ctx.byte_pattern.length);
+    if (pattern == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the pattern search.");
+    }
+
+    pattern->length = efb_ctx.byte_pattern.length;
+    memcpy(pattern->data, efb_ctx.byte_pattern.data, pattern->length);
+
+    efb_render_submit(BYTE_SEARCH_JOB, pattern);
+    efb_ctx.byte_search_running = true;
+    return true;
+}
+
+void efb_cancel_byte_search(void)
+{
+    efb_render_cancel(BYTE_SEARCH_JOB);
+    efb_ctx.byte_search_running = false;
+}
+
+// Returns the progress of the running byte search in percent, or -1 when it is not known
+int efb_get_byte_search_progress(void)
+{
+    return efb_render_progress(BYTE_SEARCH_JOB);
+}
+
+// Returns a view listing where the pattern occurs once the search has finished, NULL while it is running
+efb_view * efb_get_byte_search_result(size_t *match_count, bool *truncated)
+{
+    if (efb_ctx.byte_search_running)
+    {
+        return NULL;
+    }
+
+    const efb_byte_matches *matches = get_byte_matches();
+
+    *match_count = (matches != NULL) ? matches->count : 0;
+    *truncated = (matches != NULL) && matches->truncated;
+    return &efb_ctx.search_view;
+}
+
+bool efb_get_byte_match(const size_t match_idx, int *menu_item_idx, uint64_t *offset)
+{
+    const efb_byte_matches *matches = get_byte_matches();
+
+    if ((matches == NULL) || (match_idx >= matches->count))
+    {
+        return false;
+    }
+
+    *menu_item_idx = MENU_IDX_FIRST_SECTION + matches->entries[match_idx].sect_idx;
+    *offset = matches->entries[match_idx].offset;
+
+    return true;
+}
+
+static bool get_sect_location(const efb_sect_table *sections, const size_t sect_idx, const bool is_address, const uint64_t value,
+    uint64_t *offset)
+{
+    if ((sections->type[sect_idx] == SHT_NOBITS) || (is_address && ((sections->flags[sect_idx] & SHF_ALLOC) == 0)))
+    {
+        return false;
+    }
+
+    uint64_t sect_start = is_address ? sections->addr[sect_idx] : sections->offset[sect_idx];
+    if ((value < sect_start) || (value - sect_start >= sections->size[sect_idx]))
+    {
+        return false;
+    }
+
+    *offset = value - sect_start;
+    return true;
+}
+
+// Tells which section contains a file offset or a virtual address and where it is inside the section.
+// The viewed section is preferred, as sections may overlap.
+bool efb_get_file_location(const bool is_address, const uint64_t value, const int viewed_item_idx, int *menu_item_idx, uint64_t *offset)
+{
+    const efb_sect_table *sections = &efb_ctx.file.sections;
+
+    if ((viewed_item_idx >= MENU_IDX_FIRST_SECTION) && ((size_t) (viewed_item_idx - MENU_IDX_FIRST_SECTION) < sections->count)
+        && get_sect_location(sections, viewed_item_idx - MENU_IDX_FIRST_SECTION, is_address, value, offset))
+    {
+        *menu_item_idx = viewed_item_idx;
+        return true;
+    }
+
+    for (size_t sect_idx = 1; sect_idx < sections->count; sect_idx++)
+    {
+        if (get_sect_location(sections, sect_idx, is_address, value, offset))
+        {
+            *menu_item_idx = MENU_IDX_FIRST_SECTION + sect_idx;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void alloc_item_generations(void)
+{
+    free(efb_ctx.item_generation);
+
+    efb_ctx.item_generation = calloc(efb_ctx.menu_item_count, sizeof(unsigned int));
+    if (efb_ctx.item_generation == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the view generations of %zu menu items.", efb_ctx.menu_item_count);
+    }
+}
+
+int efb_get_watch_fd(void)
+{
+    return efb_ctx.watch.fd;
+}
+
+static bool is_same_section_list(const efb_sect_table *old_sections, const efb_sect_table *new_sections)
+{
+    if (old_sections->count != new_sections->count)
+    {
+        return false;
+    }
+
+    for (size_t sect_idx = 0; sect_idx < new_sections->count; sect_idx++)
+    {
+        if (strcmp(old_sections->name[sect_idx], new_sections->name[sect_idx]) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// A section's view also shows the sections it links to (e.g. the names of a symbol table, the symbols of
+// relocations), and the dumps and the disassembly of the loaded sections are annotated with the symbols.
+// Returns true if a symbol table has changed.
+static bool find_changed_sections(const efb_file_fingerprint *old_print, const efb_file_fingerprint *new_print, bool *changed)
+{
+    const efb_sect_table *sections = &efb_ctx.file.sections;
+    bool symbols_changed = false;
+    bool propagated = true;
+
+    for (size_t sect_idx = 0; sect_idx < sections->count; sect_idx++)
+    {
+        changed[sect_idx] = (old_print->sect_header_hashes[sect_idx] != new_print->sect_header_hashes[sect_idx])
+            || (old_print->sect_data_hashes[sect_idx] != new_print->sect_data_hashes[sect_idx]);
+    }
+
+    while (propagated)
+    {
+        propagated = false;
+
+        for (size_t sect_idx = 0; sect_idx < sections->count; sect_idx++)
+        {
+            GElf_Word link = sections->link[sect_idx];
+            GElf_Word info = sections->info[sect_idx];
+            bool is_reloc = (sections->type[sect_idx] == SHT_REL) || (sections->type[sect_idx] == SHT_RELA);
+
+            if ((changed[sect_idx] == false) && (((link < sections->count) && changed[link])
+                || (is_reloc && (info < sections->count) && changed[info])))
+            {
+                changed[sect_idx] = true;
+                propagated = true;
+            }
+        }
+    }
+
+    for (size_t sect_idx = 0; sect_idx < sections->count; sect_idx++)
+    {
+        symbols_changed = symbols_changed || (changed[sect_idx]
+            && ((sections->type[sect_idx] == SHT_SYMTAB) || (sections->type[sect_idx] == SHT_DYNSYM)));
+    }
+
+    for (size_t sect_idx = 0; symbols_changed && (sect_idx < sections->count); sect_idx++)
+    {
+        changed[sect_idx] = changed[sect_idx] || ((sections->flags[sect_idx] & SHF_ALLOC) != 0);
+    }
+
+    return symbols_changed;
+}
+
+// Drops the cached views of the changed menu items; returns true if the symbols have changed
+static bool invalidate_changed_items(const efb_file_fingerprint *old_print, const efb_file_fingerprint *new_print)
+{
+    size_t sect_count = efb_ctx.file.sections.count;
+    bool *changed = malloc((sect_count > 0 ? sect_count : 1) * sizeof(bool));
+
+    if (changed == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the changes of %zu sections.", sect_count);
+    }
+
+    bool symbols_changed = find_changed_sections(old_print, new_print, changed);
+    bool dynamic_changed = false;
+
+    for (size_t sect_idx = 0; sect_idx < sect_count; sect_idx++)
+    {
+        if (changed[sect_idx])
+        {
+            efb_cache_invalidate(&efb_ctx.view_cache, MENU_IDX_FIRST_SECTION + sect_idx);
+            dynamic_changed = dynamic_changed || (efb_ctx.file.sections.type[sect_idx] == SHT_DYNAMIC);
+        }
+    }
+
+    // The header tells a PIE from a shared object by the dynamic section
+    if (dynamic_changed)
+    {
+        efb_cache_invalidate(&efb_ctx.view_cache, MENU_IDX_ELF_HEADER);
+    }
+
+    if (old_print->headers_hash != new_print->headers_hash)
+    {
+        efb_cache_invalidate(&efb_ctx.view_cache, MENU_IDX_ELF_HEADER);
+        efb_cache_invalidate(&efb_ctx.view_cache, MENU_IDX_SEGMENTS_SUMMARY);
+    }
+
+    efb_cache_invalidate(&efb_ctx.view_cache, MENU_IDX_SECTIONS_SUMMARY);
+    if (efb_ctx.compare_path != NULL)
+    {
+        efb_cache_invalidate(&efb_ctx.view_cache, MENU_IDX_DIFF);
+    }
+
+    free(changed);
+    return symbols_changed;
+}
+
+static bool is_same_fingerprint(const efb_file_fingerprint *old_print, const efb_file_fingerprint *new_print)
+{
+    size_t hashes_size = new_print->sect_count * sizeof(uint64_t);
+
+    return (old_print->headers_hash == new_print->headers_hash) && (old_print->sect_count == new_print->sect_count)
+        && (memcmp(old_print->sect_header_hashes, new_print->sect_header_hashes, hashes_size) == 0)
+        && (memcmp(old_print->sect_data_hashes, new_print->sect_data_hashes, hashes_size) == 0);
+}
+
+// Closes the previous versions of the file which no cached view and no index points into any more
+static void close_unused_files(void)
+{
+    size_t kept_count = 0;
+
+    for (size_t retired_idx = 0; retired_idx < efb_ctx.retired_count; retired_idx++)
+    {
+        retired_file *retired = &efb_ctx.retired_files[retired_idx];
+        bool used = (efb_ctx.addr_index_built && (efb_ctx.addr_index_generation == retired->generation))
+            || (efb_ctx.sym_index_built && (efb_ctx.sym_index_generation == retired->generation));
+
+        for (size_t item_idx = 0; (item_idx < efb_ctx.menu_item_count) && (used == false); item_idx++)
+        {
+            used = efb_cache_contains(&efb_ctx.view_cache, item_idx) && (efb_ctx.item_generation[item_idx] == retired->generation);
+        }
+
+        if (used)
+        {
+            efb_ctx.retired_files[kept_count++] = *retired;
+        }
+        else
+        {
+            efb_file_close(&retired->file);
+        }
+    }
+
+    efb_ctx.retired_count = kept_count;
+}
+
+static void retire_file(void)
+{
+    retired_file *retired_files = realloc(efb_ctx.retired_files, (efb_ctx.retired_count + 1) * sizeof(retired_file));
+    if (retired_files == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot keep the previous version of the file.");
+    }
+
+    efb_ctx.retired_files = retired_files;
+    efb_ctx.retired_files[efb_ctx.retired_count++] = (retired_file) { efb_ctx.file, efb_ctx.generation };
+}
+
+// Called when the watched file may have changed: reopens it and drops the cached views of the menu items
+// which have changed; the other views are kept, with the previous version of the file they point into,
+// unless the file has been rewritten in place.
+// Returns false if the file has not changed or cannot be opened, the previous version is shown then.
+bool efb_reload_file(size_t *menu_item_count)
+{
+    efb_file new_file;
+    efb_file_fingerprint new_print;
+
+    if (efb_watch_changed(&efb_ctx.watch) == false)
+    {
+        return false;
+    }
+
+    // The render threads use the file and the indexes
+    efb_render_stop();
+
+    // A write which leaves no valid ELF file (truncated with '>', an interrupted link, a non-ELF file moved
+    // over it) is skipped: the open fails cleanly and the next finished write is loaded
+    if (efb_file_open(&new_file, efb_ctx.file.path) == false)
+    {
+        efb_render_start(render_menu_item);
+        return false;
+    }
+
+    efb_file_guard(&new_file);
+    efb_fingerprint_file(&new_file, &new_print);
+
+    // The views of a file rewritten in place point into a mapping which now shows the new contents: all are
+    // dropped. A replaced file is compared with the previous version, whose mapping is intact; the sections
+    // are hashed then, rather than when the file is opened.
+    bool rewritten = efb_file_rewritten(&efb_ctx.file, &new_file);
+
+    if (rewritten == false)
+    {
+        efb_fingerprint_contents(&efb_ctx.file, &efb_ctx.fingerprint);
+        efb_fingerprint_contents(&new_file, &new_print);
+
+        // Replaced with the same contents
+        if (is_same_fingerprint(&efb_ctx.fingerprint, &new_print))
+        {
+            efb_fingerprint_free(&new_print);
+            efb_file_close(&new_file);
+            efb_render_start(render_menu_item);
+            return false;
+        }
+    }
+
+    bool same_sections = (rewritten == false) && is_same_section_list(&efb_ctx.file.sections, &new_file.sections);
+
+    retire_file();
+    efb_ctx.file = new_file;
+    efb_ctx.sElf = new_file.sElf;
+    efb_ctx.generation++;
+
+    // The menu items are the sections, a new section list changes all of them. The indexes are rebuilt
+    // by the next dump or search which needs them.
+    if ((same_sections == false) || invalidate_changed_items(&efb_ctx.fingerprint, &new_print))
+    {
+        efb_addr_index_free(&efb_ctx.addr_index);
+        efb_ctx.addr_index_built = false;
+        efb_sym_index_free(&efb_ctx.sym_index);
+        efb_ctx.sym_index_built = false;
+    }
+
+    if (same_sections == false)
+    {
+        efb_cache_free(&efb_ctx.view_cache);
+        efb_ctx.menu_item_count = MENU_IDX_FIRST_SECTION + efb_get_sect_count(&efb_ctx.file) + ((efb_ctx.compare_path != NULL) ? 1 : 0);
+        efb_cache_init(&efb_ctx.view_cache, efb_ctx.menu_item_count, efb_ctx.cache_size);
+        alloc_item_generations();
+    }
+
+    efb_fingerprint_free(&efb_ctx.fingerprint);
+    efb_ctx.fingerprint = new_print;
+
+    close_unused_files();
+    efb_render_start(render_menu_item);
+
+    *menu_item_count = efb_ctx.menu_item_count;
+    return true;
+}
+
+// The index is built by the first dump which needs it; the render threads may ask for it at the same time
+const efb_addr_index * efb_get_addr_index(void)
+{
+    static pthread_mutex_t addr_index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock(&addr_index_lock);
+    if (efb_ctx.addr_index_built == false)
+    {
+        efb_addr_index_build(&efb_ctx.file, &efb_ctx.addr_index);
+        efb_ctx.addr_index_built = true;
+        efb_ctx.addr_index_generation = efb_ctx.generation;
+    }
+    pthread_mutex_unlock(&addr_index_lock);
+
+    return &efb_ctx.addr_index;
+}
+
+static void dump_menu_item_json(const int menu_item_idx, efb_json_writer *writer)
+{
+    if (menu_item_idx == MENU_IDX_ELF_HEADER)
+    {
+        efb_json_elf_header(&efb_ctx.file, writer);
+    }
+    else if (menu_item_idx == MENU_IDX_SEGMENTS_SUMMARY)
+    {
+        efb_json_segments(efb_ctx.sElf, writer);
+    }
+    else if (menu_item_idx == MENU_IDX_SECTIONS_SUMMARY)
+    {
+        efb_json_sections(&efb_ctx.file, writer);
+    }
+    else
+    {
+        efb_json_section(&efb_ctx.file, menu_item_idx - MENU_IDX_FIRST_SECTION, writer);
+    }
+}
+
+// Writes the item as text, or as JSON records when a writer is given
+static void dump_menu_item(const int menu_item_idx, efb_json_writer *writer)
+{
+    efb_view view;
+
+    if (writer != NULL)
+    {
+        dump_menu_item_json(menu_item_idx, writer);
+        return;
+    }
+
+    efb_view_init(&view);
+    render_menu_item(menu_item_idx, NULL, &view);
+    efb_view_finish(&view);
+
+    if (efb_view_write(&view, stdout) == false)
+    {
+        fprintf(stderr, "Cannot write the output.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    efb_view_free(&view);
+}
+
+// Batch mode: renders the items with the viewer's renderers and streams them to stdout, one view at a time
+static void dump_items(efb_context *efb_ctx)
+{
+    static const char *item_names[] = { [MENU_IDX_ELF_HEADER] = "header", [MENU_IDX_SEGMENTS_SUMMARY] = "segments",
+        [MENU_IDX_SECTIONS_SUMMARY] = "sections" };
+    const efb_sect_table *sections = &efb_ctx->file.sections;
+    const char *item = efb_ctx->dump_items;
+    efb_json_writer json_writer;
+    efb_json_writer *writer = NULL;
+
+    setvbuf(stdout, NULL, _IOFBF, DUMP_STDOUT_BUFFER_SIZE);
+
+    if (efb_ctx->dump_format != DUMP_FORMAT_TEXT)
+    {
+        efb_json_init(&json_writer, stdout, efb_ctx->dump_format == DUMP_FORMAT_NDJSON);
+        writer = &json_writer;
+    }
+
+    while (*item != '\0')
+    {
+        size_t item_len = strcspn(item, ",");
+        bool all_items = (item_len == strlen("all")) && (strncmp(item, "all", item_len) == 0);
+        bool found = false;
+
+        for (int menu_item_idx = 0; menu_item_idx < MENU_IDX_FIRST_SECTION; menu_item_idx++)
+        {
+            if (all_items || ((strlen(item_names[menu_item_idx]) == item_len) && (strncmp(item, item_names[menu_item_idx], item_len) == 0)))
+            {
+                dump_menu_item(menu_item_idx, writer);
+                found = true;
+            }
+        }
+
+        // Section names are not unique, every section with the name is written
+        for (size_t sect_idx = 1; sect_idx < sections->count; sect_idx++)
+        {
+            if (all_items || ((strlen(sections->name[sect_idx]) == item_len) && (strncmp(item, sections->name[sect_idx], item_len) == 0)))
+            {
+                dump_menu_item(MENU_IDX_FIRST_SECTION + sect_idx, writer);
+                found = true;
+            }
+        }
+
+        if ((found == false) && (item_len > 0))
+        {
+            fflush(stdout);
+            fprintf(stderr, "Unknown item: %.*s\n", (int) item_len, item);
+            exit(EXIT_FAILURE);
+        }
+
+        item += item_len + ((item[item_len] == ',') ? 1 : 0);
+    }
+
+    if (writer != NULL)
+    {
+        efb_json_finish(writer);
+    }
+
+    fflush(stdout);
 }
 
 static void efb_close(efb_context *efb_ctx)
 {
-    if (efb_ctx->sElf != NULL)
+    efb_render_stop();
+    efb_cache_free(&efb_ctx->view_cache);
+    efb_view_free(&efb_ctx->search_view);
+    efb_sym_index_free(&efb_ctx->sym_index);
+    efb_addr_index_free(&efb_ctx->addr_index);
+    free(efb_ctx->sym_matches.entries);
+    efb_buf_free(&efb_ctx->byte_pattern);
+    efb_watch_stop(&efb_ctx->watch);
+    efb_fingerprint_free(&efb_ctx->fingerprint);
+    free(efb_ctx->item_generation);
+    efb_file_close(&efb_ctx->file);
+
+    for (size_t retired_idx = 0; retired_idx < efb_ctx->retired_count; retired_idx++)
     {
-        elf_end(efb_ctx->sElf);
+        efb_file_close(&efb_ctx->retired_files[retired_idx].file);
     }
 
-    close(efb_ctx->elf_file_desc);
+    free(efb_ctx->retired_files);
 
-    if (efb_ctx->main_menu_data != NULL)
+    if (efb_ctx->compare_path != NULL)
     {
-        free(efb_ctx->main_menu_data);
+        efb_file_close(&efb_ctx->compare_file);
     }
 }
 
@@ -104,14 +984,56 @@ int main(int argc, char **argv)
 {
     efb_init(&efb_ctx, argc, argv);
 
-    efb_ctx.menu_item_count = MENU_IDX_FIRST_SECTION + efb_get_sect_count(efb_ctx.sElf);
-    efb_ctx.main_menu_data = malloc(efb_ctx.menu_item_count * sizeof(item_data));
-    efb_ctx.main_menu_data[MENU_IDX_ELF_HEADER] = (item_data) {"ELF Header", "<info>"};
-    efb_ctx.main_menu_data[MENU_IDX_SEGMENTS_SUMMARY] = (item_data) {"Segments", "<info>"};
-    efb_ctx.main_menu_data[MENU_IDX_SECTIONS_SUMMARY] = (item_data) {"Sections", "<info"};
-    efb_get_sect_name_and_type(efb_ctx.sElf, &efb_ctx.main_menu_data[MENU_IDX_FIRST_SECTION]);
+    if (efb_ctx.scan_path != NULL)
+    {
+        if (efb_scan_tree(efb_ctx.scan_path) == 0)
+        {
+            fprintf(stderr, "No ELF files found in %s\n", efb_ctx.scan_path);
+            return EXIT_FAILURE;
+        }
+
+        return 0;
+    }
+
+    // The first file is the old one, the second the new one
+    if (efb_ctx.diff_files)
+    {
+        efb_buffer diff;
+
+        efb_buf_init(&diff);
+        efb_diff_files(&efb_ctx.file, &efb_ctx.compare_file, &diff);
+        fwrite(diff.data, 1, diff.length, stdout);
+        efb_buf_free(&diff);
+        efb_file_close(&efb_ctx.compare_file);
+        efb_file_close(&efb_ctx.file);
+        return 0;
+    }
+
+    if (efb_ctx.dump_items != NULL)
+    {
+        dump_items(&efb_ctx);
+        efb_addr_index_free(&efb_ctx.addr_index);
+        efb_file_close(&efb_ctx.file);
+        return 0;
+    }
+
+    efb_ctx.menu_item_count = MENU_IDX_FIRST_SECTION + efb_get_sect_count(&efb_ctx.file) + ((efb_ctx.compare_path != NULL) ? 1 : 0);
+    efb_cache_init(&efb_ctx.view_cache, efb_ctx.menu_item_count, efb_ctx.cache_size);
+    alloc_item_generations();
+    efb_view_init(&efb_ctx.search_view);
+    efb_buf_init(&efb_ctx.byte_pattern);
+
+    // Only the headers are hashed here, the sections are hashed by the first reload
+    efb_fingerprint_file(&efb_ctx.file, &efb_ctx.fingerprint);
+    efb_watch_start(&efb_ctx.watch, efb_ctx.file.path);
+    efb_file_guard(&efb_ctx.file);
+    if (efb_ctx.compare_path != NULL)
+    {
+        efb_file_guard(&efb_ctx.compare_file);
+    }
+    efb_render_start(render_menu_item);
 
-    efb_draw_view(efb_ctx.main_menu_data, efb_ctx.menu_item_count);
+    efb_draw_view(efb_ctx.menu_item_count);
 
     efb_close(&efb_ctx);
     return 0;
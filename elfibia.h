@@ -1,6 +1,7 @@
 #ifndef ELFIBIA_H_INCLUDED
 #define ELFIBIA_H_INCLUDED
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <gelf.h>
 
@@ -10,17 +11,355 @@ typedef struct
     char * item_descr;
 } item_data;
 
-void efb_get_sect_name_and_type(Elf *sElf, item_data * it_data);
-size_t efb_get_sect_count(Elf *sElf);
+// Growable output buffer; 'data' is always '\0' terminated.
+// A buffer set up by efb_buf_index_lines() also keeps the offset after each '\n', found as the text is written.
+typedef struct
+{
+    char * data;
+    size_t length;
+    size_t capacity;
+    size_t * line_ends;
+    size_t line_count;
+    size_t line_capacity;
+} efb_buffer;
+
+void efb_buf_init(efb_buffer *buf);
+void efb_buf_index_lines(efb_buffer *buf);
+void efb_buf_free(efb_buffer *buf);
+void efb_buf_reset(efb_buffer *buf);
+void efb_buf_reserve(efb_buffer *buf, const size_t extra);
+void efb_buf_commit(efb_buffer *buf, const size_t length);
+void efb_buf_truncate(efb_buffer *buf, const size_t length);
+void efb_buf_append(efb_buffer *buf, const char *str, const size_t len);
+void efb_buf_putc(efb_buffer *buf, const char ch);
+void efb_buf_printf(efb_buffer *buf, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+// What efb_view_locate() looks for
+typedef enum
+{
+    EFB_LOCATE_SYMBOL,
+    EFB_LOCATE_OFFSET,
+    EFB_LOCATE_ADDRESS
+} efb_locate_kind;
+
+// Rows which are rendered on demand, only when they become visible
+typedef struct
+{
+    size_t row_count;
+    size_t rows_data_size;
+    void (*render_rows)(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer *out_buffer);
+    // Returns the number of bytes it allocated for the new order, they are added to 'rows_data_size'
+    size_t (*sort_rows)(void *rows_data);
+    bool (*locate_row)(const void *rows_data, const efb_locate_kind kind, const uint64_t value, size_t *row);
+    void (*release)(void *rows_data);
+    void *rows_data;
+} efb_row_source;
+
+// A run of view rows: either pre-rendered text lines or rows of a row source
+typedef struct
+{
+    size_t first_row;
+    size_t row_count;
+    size_t first_text_line;
+    efb_row_source source;
+} efb_view_block;
+
+// Content of a menu item
+typedef struct
+{
+    efb_buffer text;
+    size_t text_line_count;
+    efb_view_block *blocks;
+    size_t block_count;
+    size_t block_capacity;
+    size_t row_count;
+    size_t rows_data_size;
+} efb_view;
+
+void efb_view_init(efb_view *view);
+void efb_view_reset(efb_view *view);
+void efb_view_free(efb_view *view);
+void efb_view_add_rows(efb_view *view, const efb_row_source *source);
+void efb_view_finish(efb_view *view);
+void efb_view_render_rows(const efb_view *view, const size_t first_row, const size_t row_count, efb_buffer *out_buffer);
+bool efb_view_sort(efb_view *view);
+bool efb_view_locate(const efb_view *view, const efb_locate_kind kind, const uint64_t value, size_t *row);
+bool efb_view_write(const efb_view *view, FILE *stream);
+
+// LRU cache of the rendered menu item views, limited by the memory they use
+typedef struct efb_cache_entry efb_cache_entry;
+
+typedef struct
+{
+    efb_cache_entry **entries;
+    size_t item_count;
+    size_t max_size;
+    size_t used_size;
+    efb_cache_entry *most_recent;
+    efb_cache_entry *least_recent;
+    int pinned_item;
+} efb_view_cache;
+
+void efb_cache_init(efb_view_cache *cache, const size_t item_count, const size_t max_size);
+void efb_cache_free(efb_view_cache *cache);
+bool efb_cache_contains(const efb_view_cache *cache, const int item_idx);
+efb_view * efb_cache_get(efb_view_cache *cache, const int item_idx);
+efb_view * efb_cache_add(efb_view_cache *cache, const int item_idx);
+void efb_cache_commit(efb_view_cache *cache, const int item_idx);
+void efb_cache_put(efb_view_cache *cache, const int item_idx, efb_view *view);
+void efb_cache_pin(efb_view_cache *cache, const int item_idx);
+void efb_cache_invalidate(efb_view_cache *cache, const int item_idx);
+
+// Background rendering of the menu item views
+typedef void (*efb_render_fn)(const int item_idx, const void *arg, efb_view *view);
+
+void efb_render_start(efb_render_fn render);
+void efb_render_stop(void);
+void efb_render_request(const int item_idx, const bool prefetch);
+void efb_render_submit(const int item_idx, void *arg);
+void efb_render_cancel(const int item_idx);
+void efb_render_cancel_others(const int item_idx);
+bool efb_render_take(int *item_idx, efb_view *view);
+int efb_render_progress(const int item_idx);
+bool efb_render_step(const size_t done, const size_t total);
+
+// libelf calls which may load data lazily, serialized for the render threads
+Elf_Data * efb_elf_getdata(Elf_Scn *sect, Elf_Data *data);
+Elf_Data * efb_elf_rawdata(Elf_Scn *sect, Elf_Data *data);
+char * efb_elf_strptr(Elf *sElf, const size_t sect_idx, const size_t offset);
+GElf_Phdr * efb_gelf_getphdr(Elf *sElf, const int seg_idx, GElf_Phdr *prg_hdr);
+GElf_Chdr * efb_gelf_getchdr(Elf_Scn *sect, GElf_Chdr *chdr);
+
+// Section headers read once at load, one array per header field
+typedef struct
+{
+    size_t count;
+    size_t shstrndx;
+    Elf_Scn ** scn;
+    const char ** name;
+    GElf_Word * name_offset;
+    GElf_Word * type;
+    GElf_Xword * flags;
+    GElf_Addr * addr;
+    GElf_Off * offset;
+    GElf_Xword * size;
+    GElf_Word * link;
+    GElf_Word * info;
+    GElf_Xword * addralign;
+    GElf_Xword * entsize;
+} efb_sect_table;
+
+bool efb_sect_table_build(Elf *sElf, efb_sect_table *table);
+void efb_sect_table_free(efb_sect_table *table);
+void efb_sect_table_get_shdr(const efb_sect_table *table, const size_t sect_idx, GElf_Shdr *sect_header);
+
+typedef struct
+{
+    const char * path;
+    int fd;
+    Elf *sElf;
+    const unsigned char * image;
+    size_t image_size;
+    efb_sect_table sections;
+    const char * error;
+} efb_file;
+
+bool efb_file_open(efb_file *file, const char *path);
+void efb_file_close(efb_file *file);
+void efb_advise_sequential(Elf *sElf, const void *data, const size_t size);
+void efb_file_guard(const efb_file *file);
+bool efb_file_truncated(const efb_file *file);
+bool efb_file_rewritten(const efb_file *old_file, const efb_file *new_file);
+
+// Watches the viewed file for rewrites by a linker
+typedef struct
+{
+    int fd;
+    char * name;
+} efb_file_watch;
+
+bool efb_watch_start(efb_file_watch *watch, const char *path);
+void efb_watch_stop(efb_file_watch *watch);
+bool efb_watch_changed(efb_file_watch *watch);
+
+// What a reload compares to find the changed menu items
+typedef struct
+{
+    uint64_t headers_hash;
+    size_t sect_count;
+    uint64_t * sect_header_hashes;
+    // NULL until efb_fingerprint_contents() has hashed the sections
+    uint64_t * sect_data_hashes;
+} efb_file_fingerprint;
+
+void efb_fingerprint_file(const efb_file *file, efb_file_fingerprint *print);
+void efb_fingerprint_contents(const efb_file *file, efb_file_fingerprint *print);
+void efb_fingerprint_free(efb_file_fingerprint *print);
+
+void efb_get_sect_name_and_type(const efb_file *file, const size_t sect_idx, item_data * it_data);
+size_t efb_get_sect_count(const efb_file *file);
+void efb_get_sections_summary(const efb_file *file, efb_buffer * out_buffer);
+
+#define EFB_DUMP_ROW_WIDTH 16
+
+void efb_hex_dump_rows(const unsigned char *data, const size_t size, const GElf_Addr addr, const int addr_width,
+    const size_t first_row, const size_t row_count, efb_buffer *out_buffer);
+
+// Symbol names of all symbol tables sorted by name, with a trigram index for substring searches
+typedef struct
+{
+    size_t count;
+    const char ** names;
+    uint32_t * sect_idx;
+    uint32_t * sym_idx;
+    GElf_Addr * value;
+    uint32_t * trigram_start;
+    uint32_t * trigram_blocks;
+} efb_sym_index;
+
+// Indexes into efb_sym_index
+typedef struct
+{
+    uint32_t * entries;
+    size_t count;
+    size_t capacity;
+} efb_sym_matches;
+
+void efb_sym_index_build(const efb_file *file, efb_sym_index *index);
+void efb_sym_index_free(efb_sym_index *index);
+void efb_sym_index_search(const efb_sym_index *index, const char *query, efb_sym_matches *matches);
+
+// Disjoint address intervals sorted by address, each named by the innermost symbol covering it
+typedef struct
+{
+    size_t count;
+    GElf_Addr * start;
+    GElf_Addr * end;
+    GElf_Addr * sym_addr;
+    const char ** name;
+} efb_addr_index;
+
+void efb_addr_index_build(const efb_file *file, efb_addr_index *index);
+void efb_addr_index_free(efb_addr_index *index);
+bool efb_addr_index_lookup(const efb_addr_index *index, const GElf_Addr addr, const GElf_Addr limit, size_t *interval_idx);
+
+typedef struct
+{
+    uint32_t sect_idx;
+    uint64_t offset;
+} efb_byte_match;
+
+typedef struct
+{
+    efb_byte_match * entries;
+    size_t count;
+    size_t capacity;
+    bool truncated;
+} efb_byte_matches;
+
+bool efb_pattern_parse(const char *text, efb_buffer *pattern);
+void efb_pattern_search(const efb_file *file, const unsigned char *pattern, const size_t pattern_len,
+    const size_t max_matches, efb_byte_matches *matches);
+
+size_t efb_scan_tree(const char *root_path);
+
+#define EFB_HASH_BLOCK_SIZE (64 * 1024)
+
+// A byte range hashed in EFB_HASH_BLOCK_SIZE blocks
+typedef struct
+{
+    const unsigned char * data;
+    size_t size;
+    uint64_t * block_hashes;
+} efb_hash_region;
+
+uint64_t efb_hash64(const void *data, const size_t size, const uint64_t seed);
+size_t efb_hash_block_count(const size_t size);
+void efb_hash_regions(efb_hash_region *regions, const size_t region_count);
+
+void efb_diff_files(const efb_file *old_file, const efb_file *new_file, efb_buffer *out);
+
+#define EFB_JSON_MAX_DEPTH 16
+
+// Streaming JSON/NDJSON writer: values are formatted straight into a small buffer which is flushed to the stream
+typedef struct
+{
+    FILE * stream;
+    efb_buffer out;
+    bool ndjson;
+    int depth;
+    bool has_items[EFB_JSON_MAX_DEPTH];
+    bool record_closed;
+    const char * table_type;
+    const char * table_section;
+} efb_json_writer;
+
+void efb_json_init(efb_json_writer *writer, FILE *stream, const bool ndjson);
+void efb_json_finish(efb_json_writer *writer);
+void efb_json_begin_object(efb_json_writer *writer, const char *key);
+void efb_json_end_object(efb_json_writer *writer);
+void efb_json_begin_array(efb_json_writer *writer, const char *key);
+void efb_json_end_array(efb_json_writer *writer);
+void efb_json_string(efb_json_writer *writer, const char *key, const char *value);
+void efb_json_uint(efb_json_writer *writer, const char *key, const uint64_t value);
+void efb_json_int(efb_json_writer *writer, const char *key, const int64_t value);
+void efb_json_hex(efb_json_writer *writer, const char *key, const uint64_t value);
+void efb_json_bool(efb_json_writer *writer, const char *key, const bool value);
+void efb_json_begin_record(efb_json_writer *writer, const char *type);
+void efb_json_end_record(efb_json_writer *writer);
+void efb_json_begin_table(efb_json_writer *writer, const char *key, const char *row_type, const char *section_name);
+void efb_json_end_table(efb_json_writer *writer);
+void efb_json_begin_row(efb_json_writer *writer);
+void efb_json_end_row(efb_json_writer *writer);
+
+void efb_json_elf_header(const efb_file *file, efb_json_writer *writer);
+void efb_json_segments(Elf *sElf, efb_json_writer *writer);
+void efb_json_sections(const efb_file *file, efb_json_writer *writer);
+void efb_json_section(const efb_file *file, const int section_idx, efb_json_writer *writer);
+void efb_json_symbols(const efb_file *file, const int section_idx, efb_json_writer *writer);
+
+void efb_draw_view(const int menu_items_count);
+
+void efb_get_menu_item_data(const int menu_item_idx, item_data *it_data);
+efb_view * efb_get_menu_item_content(const int menu_item_idx);
+bool efb_poll_menu_item_content(void);
+bool efb_sort_menu_item_content(const int menu_item_idx);
+int efb_get_menu_item_progress(const int menu_item_idx);
+void efb_prefetch_menu_items(const int menu_item_idx);
+efb_view * efb_search_symbols(const char *query, size_t *match_count);
+bool efb_get_symbol_match(const size_t match_idx, int *menu_item_idx, size_t *sym_idx);
+const efb_addr_index * efb_get_addr_index(void);
+bool efb_start_byte_search(const char *pattern_text);
+void efb_cancel_byte_search(void);
+int efb_get_byte_search_progress(void);
+efb_view * efb_get_byte_search_result(size_t *match_count, bool *truncated);
+bool efb_get_byte_match(const size_t match_idx, int *menu_item_idx, uint64_t *offset);
+bool efb_get_file_location(const bool is_address, const uint64_t value, const int viewed_item_idx, int *menu_item_idx, uint64_t *offset);
+int efb_get_watch_fd(void);
+bool efb_reload_file(size_t *menu_item_count);
 
-void efb_draw_view(item_data *it_data, const int menu_items_count);
+void efb_get_section_content(const efb_file *file, const int section_idx, efb_view * view);
+void efb_get_secthdr_struct(GElf_Shdr *elfShdr, efb_buffer * out_buffer);
+void efb_get_elf_data_struct(Elf_Data *elf_data, efb_buffer * out_buffer);
 
-char * efb_get_menu_item_content(const int menu_item_idx);
+void efb_info_sect_symbols(const efb_file *file, Elf_Scn *sect, GElf_Shdr *sect_header, efb_view * view);
+char * efb_get_sym_type(const unsigned int sym_type);
+char * efb_get_sym_bind(const unsigned int sym_bind);
+char * efb_get_sym_visibility(const unsigned int sym_visibility);
+const char * efb_get_sym_sect_name(const efb_sect_table *sections, const GElf_Section shndx, const GElf_Word xndx);
+Elf_Data * efb_get_sym_shndx_data(const efb_sect_table *sections, const size_t sym_sect_idx);
+const char * efb_get_sym_name(const Elf_Data *str_data, const GElf_Word name_offset);
+char * efb_get_dynamic_type(const long int dyn_type);
 
-void efb_get_section_content(Elf *sElf, const int section_idx, char * out_buffer);
+void efb_info_sect_relocs(const efb_file *file, Elf_Scn *sect, GElf_Shdr *sect_header, efb_view * view);
+void efb_info_sect_strings(Elf_Data *elf_data, efb_view * view);
+bool efb_info_sect_compressed(Elf *sElf, Elf_Scn *sect, GElf_Shdr *sect_header, efb_view * view);
+bool efb_info_sect_disasm(const efb_file *file, Elf_Data *elf_data, GElf_Shdr *sect_header, efb_view * view);
+void efb_info_sect_hash(const efb_file *file, const int section_idx, GElf_Shdr *sect_header, efb_view * view);
+void efb_summarize_hash_tables(const efb_file *file, efb_buffer *line);
 
-void efb_get_elf_header(Elf * sElf, char * out_buffer);
+void efb_get_elf_header(const efb_file *file, efb_buffer * out_buffer);
 
-void efb_get_segment_content(Elf *sElf, char * out_buffer);
+void efb_get_segment_content(Elf *sElf, efb_buffer * out_buffer);
 
 #endif // ELFIBIA_H_INCLUDED
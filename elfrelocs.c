@@ -0,0 +1,589 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The type counts are a by-product of the pass which lays out the rows; the progress is reported every this many entries
+#define RELOC_STEP_ENTRIES 4096
+#define RELOC_TYPE_SIZE 32
+
+typedef struct
+{
+    GElf_Word type;
+    const char *name;
+} reloc_name;
+
+#define RELOC_NAME(type) { type, #type }
+
+static const reloc_name x86_64_relocs[] =
+{
+    RELOC_NAME(R_X86_64_NONE), RELOC_NAME(R_X86_64_64), RELOC_NAME(R_X86_64_PC32), RELOC_NAME(R_X86_64_GOT32),
+    RELOC_NAME(R_X86_64_PLT32), RELOC_NAME(R_X86_64_COPY), RELOC_NAME(R_X86_64_GLOB_DAT),
+    RELOC_NAME(R_X86_64_JUMP_SLOT), RELOC_NAME(R_X86_64_RELATIVE), RELOC_NAME(R_X86_64_GOTPCREL),
+    RELOC_NAME(R_X86_64_32), RELOC_NAME(R_X86_64_32S), RELOC_NAME(R_X86_64_16), RELOC_NAME(R_X86_64_PC16),
+    RELOC_NAME(R_X86_64_8), RELOC_NAME(R_X86_64_PC8), RELOC_NAME(R_X86_64_DTPMOD64), RELOC_NAME(R_X86_64_DTPOFF64),
+    RELOC_NAME(R_X86_64_TPOFF64), RELOC_NAME(R_X86_64_TLSGD), RELOC_NAME(R_X86_64_TLSLD), RELOC_NAME(R_X86_64_DTPOFF32),
+    RELOC_NAME(R_X86_64_GOTTPOFF), RELOC_NAME(R_X86_64_TPOFF32), RELOC_NAME(R_X86_64_PC64),
+    RELOC_NAME(R_X86_64_GOTOFF64), RELOC_NAME(R_X86_64_GOTPC32), RELOC_NAME(R_X86_64_GOT64),
+    RELOC_NAME(R_X86_64_GOTPCREL64), RELOC_NAME(R_X86_64_GOTPC64), RELOC_NAME(R_X86_64_GOTPLT64),
+    RELOC_NAME(R_X86_64_PLTOFF64), RELOC_NAME(R_X86_64_SIZE32), RELOC_NAME(R_X86_64_SIZE64),
+    RELOC_NAME(R_X86_64_GOTPC32_TLSDESC), RELOC_NAME(R_X86_64_TLSDESC_CALL), RELOC_NAME(R_X86_64_TLSDESC),
+    RELOC_NAME(R_X86_64_IRELATIVE), RELOC_NAME(R_X86_64_RELATIVE64), RELOC_NAME(R_X86_64_GOTPCRELX),
+    RELOC_NAME(R_X86_64_REX_GOTPCRELX),
+};
+
+static const reloc_name aarch64_relocs[] =
+{
+    RELOC_NAME(R_AARCH64_NONE), RELOC_NAME(R_AARCH64_ABS64), RELOC_NAME(R_AARCH64_ABS32), RELOC_NAME(R_AARCH64_ABS16),
+    RELOC_NAME(R_AARCH64_PREL64), RELOC_NAME(R_AARCH64_PREL32), RELOC_NAME(R_AARCH64_PREL16),
+    RELOC_NAME(R_AARCH64_MOVW_UABS_G0), RELOC_NAME(R_AARCH64_MOVW_UABS_G0_NC), RELOC_NAME(R_AARCH64_MOVW_UABS_G1),
+    RELOC_NAME(R_AARCH64_MOVW_UABS_G1_NC), RELOC_NAME(R_AARCH64_MOVW_UABS_G2), RELOC_NAME(R_AARCH64_MOVW_UABS_G2_NC),
+    RELOC_NAME(R_AARCH64_MOVW_UABS_G3), RELOC_NAME(R_AARCH64_MOVW_SABS_G0), RELOC_NAME(R_AARCH64_MOVW_SABS_G1),
+    RELOC_NAME(R_AARCH64_MOVW_SABS_G2), RELOC_NAME(R_AARCH64_LD_PREL_LO19), RELOC_NAME(R_AARCH64_ADR_PREL_LO21),
+    RELOC_NAME(R_AARCH64_ADR_PREL_PG_HI21), RELOC_NAME(R_AARCH64_ADR_PREL_PG_HI21_NC),
+    RELOC_NAME(R_AARCH64_ADD_ABS_LO12_NC), RELOC_NAME(R_AARCH64_LDST8_ABS_LO12_NC), RELOC_NAME(R_AARCH64_TSTBR14),
+    RELOC_NAME(R_AARCH64_CONDBR19), RELOC_NAME(R_AARCH64_JUMP26), RELOC_NAME(R_AARCH64_CALL26),
+    RELOC_NAME(R_AARCH64_LDST16_ABS_LO12_NC), RELOC_NAME(R_AARCH64_LDST32_ABS_LO12_NC),
+    RELOC_NAME(R_AARCH64_LDST64_ABS_LO12_NC), RELOC_NAME(R_AARCH64_MOVW_PREL_G0), RELOC_NAME(R_AARCH64_MOVW_PREL_G0_NC),
+    RELOC_NAME(R_AARCH64_MOVW_PREL_G1), RELOC_NAME(R_AARCH64_MOVW_PREL_G1_NC), RELOC_NAME(R_AARCH64_MOVW_PREL_G2),
+    RELOC_NAME(R_AARCH64_MOVW_PREL_G2_NC), RELOC_NAME(R_AARCH64_MOVW_PREL_G3),
+    RELOC_NAME(R_AARCH64_LDST128_ABS_LO12_NC), RELOC_NAME(R_AARCH64_MOVW_GOTOFF_G0),
+    RELOC_NAME(R_AARCH64_MOVW_GOTOFF_G0_NC), RELOC_NAME(R_AARCH64_MOVW_GOTOFF_G1),
+    RELOC_NAME(R_AARCH64_MOVW_GOTOFF_G1_NC), RELOC_NAME(R_AARCH64_MOVW_GOTOFF_G2),
+    RELOC_NAME(R_AARCH64_MOVW_GOTOFF_G2_NC), RELOC_NAME(R_AARCH64_MOVW_GOTOFF_G3), RELOC_NAME(R_AARCH64_GOTREL64),
+    RELOC_NAME(R_AARCH64_GOTREL32), RELOC_NAME(R_AARCH64_GOT_LD_PREL19), RELOC_NAME(R_AARCH64_LD64_GOTOFF_LO15),
+    RELOC_NAME(R_AARCH64_ADR_GOT_PAGE), RELOC_NAME(R_AARCH64_LD64_GOT_LO12_NC), RELOC_NAME(R_AARCH64_LD64_GOTPAGE_LO15),
+    RELOC_NAME(R_AARCH64_TLSGD_ADR_PREL21), RELOC_NAME(R_AARCH64_TLSGD_ADR_PAGE21),
+    RELOC_NAME(R_AARCH64_TLSGD_ADD_LO12_NC), RELOC_NAME(R_AARCH64_TLSGD_MOVW_G1),
+    RELOC_NAME(R_AARCH64_TLSGD_MOVW_G0_NC), RELOC_NAME(R_AARCH64_TLSLD_ADR_PREL21),
+    RELOC_NAME(R_AARCH64_TLSLD_ADR_PAGE21), RELOC_NAME(R_AARCH64_TLSLD_ADD_LO12_NC),
+    RELOC_NAME(R_AARCH64_TLSLD_MOVW_G1), RELOC_NAME(R_AARCH64_TLSLD_MOVW_G0_NC), RELOC_NAME(R_AARCH64_TLSLD_LD_PREL19),
+    RELOC_NAME(R_AARCH64_TLSLD_MOVW_DTPREL_G2), RELOC_NAME(R_AARCH64_TLSLD_MOVW_DTPREL_G1),
+    RELOC_NAME(R_AARCH64_TLSLD_MOVW_DTPREL_G1_NC), RELOC_NAME(R_AARCH64_TLSLD_MOVW_DTPREL_G0),
+    RELOC_NAME(R_AARCH64_TLSLD_MOVW_DTPREL_G0_NC), RELOC_NAME(R_AARCH64_TLSLD_ADD_DTPREL_HI12),
+    RELOC_NAME(R_AARCH64_TLSLD_ADD_DTPREL_LO12), RELOC_NAME(R_AARCH64_TLSLD_ADD_DTPREL_LO12_NC),
+    RELOC_NAME(R_AARCH64_TLSLD_LDST8_DTPREL_LO12), RELOC_NAME(R_AARCH64_TLSLD_LDST8_DTPREL_LO12_NC),
+    RELOC_NAME(R_AARCH64_TLSLD_LDST16_DTPREL_LO12), RELOC_NAME(R_AARCH64_TLSLD_LDST16_DTPREL_LO12_NC),
+    RELOC_NAME(R_AARCH64_TLSLD_LDST32_DTPREL_LO12), RELOC_NAME(R_AARCH64_TLSLD_LDST32_DTPREL_LO12_NC),
+    RELOC_NAME(R_AARCH64_TLSLD_LDST64_DTPREL_LO12), RELOC_NAME(R_AARCH64_TLSLD_LDST64_DTPREL_LO12_NC),
+    RELOC_NAME(R_AARCH64_TLSIE_MOVW_GOTTPREL_G1), RELOC_NAME(R_AARCH64_TLSIE_MOVW_GOTTPREL_G0_NC),
+    RELOC_NAME(R_AARCH64_TLSIE_ADR_GOTTPREL_PAGE21), RELOC_NAME(R_AARCH64_TLSIE_LD64_GOTTPREL_LO12_NC),
+    RELOC_NAME(R_AARCH64_TLSIE_LD_GOTTPREL_PREL19), RELOC_NAME(R_AARCH64_TLSLE_MOVW_TPREL_G2),
+    RELOC_NAME(R_AARCH64_TLSLE_MOVW_TPREL_G1), RELOC_NAME(R_AARCH64_TLSLE_MOVW_TPREL_G1_NC),
+    RELOC_NAME(R_AARCH64_TLSLE_MOVW_TPREL_G0), RELOC_NAME(R_AARCH64_TLSLE_MOVW_TPREL_G0_NC),
+    RELOC_NAME(R_AARCH64_TLSLE_ADD_TPREL_HI12), RELOC_NAME(R_AARCH64_TLSLE_ADD_TPREL_LO12),
+    RELOC_NAME(R_AARCH64_TLSLE_ADD_TPREL_LO12_NC), RELOC_NAME(R_AARCH64_TLSLE_LDST8_TPREL_LO12),
+    RELOC_NAME(R_AARCH64_TLSLE_LDST8_TPREL_LO12_NC), RELOC_NAME(R_AARCH64_TLSLE_LDST16_TPREL_LO12),
+    RELOC_NAME(R_AARCH64_TLSLE_LDST16_TPREL_LO12_NC), RELOC_NAME(R_AARCH64_TLSLE_LDST32_TPREL_LO12),
+    RELOC_NAME(R_AARCH64_TLSLE_LDST32_TPREL_LO12_NC), RELOC_NAME(R_AARCH64_TLSLE_LDST64_TPREL_LO12),
+    RELOC_NAME(R_AARCH64_TLSLE_LDST64_TPREL_LO12_NC), RELOC_NAME(R_AARCH64_TLSDESC_LD_PREL19),
+    RELOC_NAME(R_AARCH64_TLSDESC_ADR_PREL21), RELOC_NAME(R_AARCH64_TLSDESC_ADR_PAGE21),
+    RELOC_NAME(R_AARCH64_TLSDESC_LD64_LO12), RELOC_NAME(R_AARCH64_TLSDESC_ADD_LO12),
+    RELOC_NAME(R_AARCH64_TLSDESC_OFF_G1), RELOC_NAME(R_AARCH64_TLSDESC_OFF_G0_NC), RELOC_NAME(R_AARCH64_TLSDESC_LDR),
+    RELOC_NAME(R_AARCH64_TLSDESC_ADD), RELOC_NAME(R_AARCH64_TLSDESC_CALL),
+    RELOC_NAME(R_AARCH64_TLSLE_LDST128_TPREL_LO12), RELOC_NAME(R_AARCH64_TLSLE_LDST128_TPREL_LO12_NC),
+    RELOC_NAME(R_AARCH64_TLSLD_LDST128_DTPREL_LO12), RELOC_NAME(R_AARCH64_TLSLD_LDST128_DTPREL_LO12_NC),
+    RELOC_NAME(R_AARCH64_COPY), RELOC_NAME(R_AARCH64_GLOB_DAT), RELOC_NAME(R_AARCH64_JUMP_SLOT),
+    RELOC_NAME(R_AARCH64_RELATIVE), RELOC_NAME(R_AARCH64_TLS_DTPMOD), RELOC_NAME(R_AARCH64_TLS_DTPREL),
+    RELOC_NAME(R_AARCH64_TLS_TPREL), RELOC_NAME(R_AARCH64_TLSDESC), RELOC_NAME(R_AARCH64_IRELATIVE),
+};
+
+static const reloc_name riscv_relocs[] =
+{
+    RELOC_NAME(R_RISCV_NONE), RELOC_NAME(R_RISCV_32), RELOC_NAME(R_RISCV_64), RELOC_NAME(R_RISCV_RELATIVE),
+    RELOC_NAME(R_RISCV_COPY), RELOC_NAME(R_RISCV_JUMP_SLOT), RELOC_NAME(R_RISCV_TLS_DTPMOD32),
+    RELOC_NAME(R_RISCV_TLS_DTPMOD64), RELOC_NAME(R_RISCV_TLS_DTPREL32), RELOC_NAME(R_RISCV_TLS_DTPREL64),
+    RELOC_NAME(R_RISCV_TLS_TPREL32), RELOC_NAME(R_RISCV_TLS_TPREL64), RELOC_NAME(R_RISCV_BRANCH),
+    RELOC_NAME(R_RISCV_JAL), RELOC_NAME(R_RISCV_CALL), RELOC_NAME(R_RISCV_CALL_PLT), RELOC_NAME(R_RISCV_GOT_HI20),
+    RELOC_NAME(R_RISCV_TLS_GOT_HI20), RELOC_NAME(R_RISCV_TLS_GD_HI20), RELOC_NAME(R_RISCV_PCREL_HI20),
+    RELOC_NAME(R_RISCV_PCREL_LO12_I), RELOC_NAME(R_RISCV_PCREL_LO12_S), RELOC_NAME(R_RISCV_HI20),
+    RELOC_NAME(R_RISCV_LO12_I), RELOC_NAME(R_RISCV_LO12_S), RELOC_NAME(R_RISCV_TPREL_HI20),
+    RELOC_NAME(R_RISCV_TPREL_LO12_I), RELOC_NAME(R_RISCV_TPREL_LO12_S), RELOC_NAME(R_RISCV_TPREL_ADD),
+    RELOC_NAME(R_RISCV_ADD8), RELOC_NAME(R_RISCV_ADD16), RELOC_NAME(R_RISCV_ADD32), RELOC_NAME(R_RISCV_ADD64),
+    RELOC_NAME(R_RISCV_SUB8), RELOC_NAME(R_RISCV_SUB16), RELOC_NAME(R_RISCV_SUB32), RELOC_NAME(R_RISCV_SUB64),
+    RELOC_NAME(R_RISCV_GNU_VTINHERIT), RELOC_NAME(R_RISCV_GNU_VTENTRY), RELOC_NAME(R_RISCV_ALIGN),
+    RELOC_NAME(R_RISCV_RVC_BRANCH), RELOC_NAME(R_RISCV_RVC_JUMP), RELOC_NAME(R_RISCV_RVC_LUI),
+    RELOC_NAME(R_RISCV_GPREL_I), RELOC_NAME(R_RISCV_GPREL_S), RELOC_NAME(R_RISCV_TPREL_I), RELOC_NAME(R_RISCV_TPREL_S),
+    RELOC_NAME(R_RISCV_RELAX), RELOC_NAME(R_RISCV_SUB6), RELOC_NAME(R_RISCV_SET6), RELOC_NAME(R_RISCV_SET8),
+    RELOC_NAME(R_RISCV_SET16), RELOC_NAME(R_RISCV_SET32), RELOC_NAME(R_RISCV_32_PCREL), RELOC_NAME(R_RISCV_IRELATIVE),
+};
+
+typedef struct
+{
+    GElf_Word type;
+    size_t count;
+} reloc_type_count;
+
+// The relocations are decoded from the section data only when their rows are rendered.
+// A RELR entry is an address or a bitmap of the words which follow the previous entry, so
+// the first relocation and the base address of every entry are kept to find a row's entry.
+typedef struct
+{
+    Elf_Data *rel_data;
+    Elf_Data *sym_data;
+    Elf_Data *str_data;
+    GElf_Half machine;
+    GElf_Word sect_type;
+    size_t entry_size;
+    size_t entry_count;
+    size_t reloc_count;
+    size_t *relr_first;
+    GElf_Addr *relr_base;
+} reloc_rows_data;
+
+static const char * get_reloc_name(const GElf_Half machine, const GElf_Word type)
+{
+    const reloc_name *names;
+    size_t name_count;
+
+    switch (machine)
+    {
+        case EM_X86_64:
+            names = x86_64_relocs;
+            name_count = sizeof(x86_64_relocs) / sizeof(x86_64_relocs[0]);
+            break;
+        case EM_AARCH64:
+            names = aarch64_relocs;
+            name_count = sizeof(aarch64_relocs) / sizeof(aarch64_relocs[0]);
+            break;
+        case EM_RISCV:
+            names = riscv_relocs;
+            name_count = sizeof(riscv_relocs) / sizeof(riscv_relocs[0]);
+            break;
+        default:
+            return NULL;
+    }
+
+    for (size_t name_idx = 0; name_idx < name_count; name_idx++)
+    {
+        if (names[name_idx].type == type)
+        {
+            return names[name_idx].name;
+        }
+    }
+
+    return NULL;
+}
+
+static const char * format_reloc_type(const GElf_Half machine, const GElf_Word type, char *type_str)
+{
+    const char *name = get_reloc_name(machine, type);
+
+    if (name == NULL)
+    {
+        snprintf(type_str, RELOC_TYPE_SIZE, "<type %u>", type);
+        return type_str;
+    }
+
+    return name;
+}
+
+// The type of the relocations packed in RELR
+static GElf_Word get_relative_type(const GElf_Half machine)
+{
+    switch (machine)
+    {
+        case EM_X86_64:
+            return R_X86_64_RELATIVE;
+        case EM_AARCH64:
+            return R_AARCH64_RELATIVE;
+        case EM_RISCV:
+            return R_RISCV_RELATIVE;
+        default:
+            return 0;
+    }
+}
+
+static uint64_t get_relr_word(const reloc_rows_data *relocs, const size_t entry_idx)
+{
+    const unsigned char *entry = (const unsigned char *) relocs->rel_data->d_buf + entry_idx * relocs->entry_size;
+
+    if (relocs->entry_size == sizeof(uint32_t))
+    {
+        uint32_t word;
+        memcpy(&word, entry, sizeof(word));
+        return word;
+    }
+
+    uint64_t word;
+    memcpy(&word, entry, sizeof(word));
+    return word;
+}
+
+static void get_reloc(const reloc_rows_data *relocs, const size_t entry_idx, GElf_Rela *rela)
+{
+    if (relocs->sect_type == SHT_RELA)
+    {
+        if (gelf_getrela(relocs->rel_data, entry_idx, rela) != rela)
+        {
+            errx(EXIT_FAILURE, "gelf_getrela() failed: %s.", elf_errmsg(-1));
+        }
+
+        return;
+    }
+
+    GElf_Rel rel;
+    if (gelf_getrel(relocs->rel_data, entry_idx, &rel) != &rel)
+    {
+        errx(EXIT_FAILURE, "gelf_getrel() failed: %s.", elf_errmsg(-1));
+    }
+
+    *rela = (GElf_Rela) { rel.r_offset, rel.r_info, 0 };
+}
+
+static void count_reloc_type(reloc_type_count **counts, size_t *type_count, size_t *capacity, const GElf_Word type)
+{
+    // Sections have few distinct types, and consecutive relocations mostly have the same one
+    for (size_t type_idx = *type_count; type_idx > 0; type_idx--)
+    {
+        if ((*counts)[type_idx - 1].type == type)
+        {
+            (*counts)[type_idx - 1].count++;
+            return;
+        }
+    }
+
+    if (*type_count == *capacity)
+    {
+        *capacity = (*capacity > 0) ? *capacity * 2 : 16;
+        *counts = realloc(*counts, *capacity * sizeof(reloc_type_count));
+        if (*counts == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot allocate the relocation type counts.");
+        }
+    }
+
+    (*counts)[(*type_count)++] = (reloc_type_count) { type, 1 };
+}
+
+static int compare_type_counts(const void *left, const void *right)
+{
+    const reloc_type_count *left_count = left;
+    const reloc_type_count *right_count = right;
+
+    if (left_count->count != right_count->count)
+    {
+        return (left_count->count > right_count->count) ? -1 : 1;
+    }
+
+    return (left_count->type < right_count->type) ? -1 : (left_count->type > right_count->type);
+}
+
+// RELR: lays out the rows of the entries; the relocations of a bitmap are the set bits above bit 0
+static bool scan_relr_entries(reloc_rows_data *relocs)
+{
+    size_t word_bits = relocs->entry_size * 8;
+    GElf_Addr base = 0;
+
+    relocs->relr_first = malloc((relocs->entry_count + 1) * sizeof(size_t));
+    relocs->relr_base = malloc((relocs->entry_count + 1) * sizeof(GElf_Addr));
+    if ((relocs->relr_first == NULL) || (relocs->relr_base == NULL))
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the RELR index for %zu entries.", relocs->entry_count);
+    }
+
+    for (size_t entry_idx = 0; entry_idx < relocs->entry_count; entry_idx++)
+    {
+        if (((entry_idx % RELOC_STEP_ENTRIES) == 0) && (efb_render_step(entry_idx, relocs->entry_count) == false))
+        {
+            return false;
+        }
+
+        uint64_t word = get_relr_word(relocs, entry_idx);
+
+        relocs->relr_first[entry_idx] = relocs->reloc_count;
+
+        if ((word & 1) == 0)
+        {
+            relocs->relr_base[entry_idx] = word;
+            relocs->reloc_count++;
+            base = word + relocs->entry_size;
+        }
+        else
+        {
+            relocs->relr_base[entry_idx] = base;
+            relocs->reloc_count += __builtin_popcountll(word >> 1);
+            base += (word_bits - 1) * relocs->entry_size;
+        }
+    }
+
+    relocs->relr_first[relocs->entry_count] = relocs->reloc_count;
+    return true;
+}
+
+// REL/RELA: counts the relocations of every type
+static bool count_reloc_types(reloc_rows_data *relocs, reloc_type_count **counts, size_t *type_count)
+{
+    size_t capacity = 0;
+
+    for (size_t entry_idx = 0; entry_idx < relocs->entry_count; entry_idx++)
+    {
+        if (((entry_idx % RELOC_STEP_ENTRIES) == 0) && (efb_render_step(entry_idx, relocs->entry_count) == false))
+        {
+            return false;
+        }
+
+        GElf_Rela rela;
+        get_reloc(relocs, entry_idx, &rela);
+        count_reloc_type(counts, type_count, &capacity, GELF_R_TYPE(rela.r_info));
+    }
+
+    relocs->reloc_count = relocs->entry_count;
+    return true;
+}
+
+static void print_type_counts(const reloc_rows_data *relocs, reloc_type_count *counts, const size_t type_count, efb_buffer *out_buffer)
+{
+    char type_str[RELOC_TYPE_SIZE];
+
+    qsort(counts, type_count, sizeof(reloc_type_count), compare_type_counts);
+
+    efb_buf_printf(out_buffer, "%zu relocations", relocs->reloc_count);
+    if (relocs->sect_type == SHT_RELR)
+    {
+        efb_buf_printf(out_buffer, " in %zu entries", relocs->entry_count);
+    }
+
+    efb_buf_printf(out_buffer, "\n");
+
+    for (size_t type_idx = 0; type_idx < type_count; type_idx++)
+    {
+        efb_buf_printf(out_buffer, "  %-32s %10zu\n", format_reloc_type(relocs->machine, counts[type_idx].type, type_str),
+            counts[type_idx].count);
+    }
+
+    efb_buf_printf(out_buffer, "\n");
+}
+
+// Returns the entry of the relocation and the relocated address
+static size_t get_relr_reloc(const reloc_rows_data *relocs, const size_t reloc_idx, GElf_Addr *addr)
+{
+    size_t low = 0;
+    size_t high = relocs->entry_count;
+
+    // The last entry whose first relocation is not after reloc_idx: it has at least one relocation
+    while (high - low > 1)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (relocs->relr_first[mid] <= reloc_idx)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    uint64_t word = get_relr_word(relocs, low);
+    size_t bit_rank = reloc_idx - relocs->relr_first[low];
+
+    *addr = relocs->relr_base[low];
+
+    if (word & 1)
+    {
+        uint64_t bits = word >> 1;
+
+        for (; bit_rank > 0; bit_rank--)
+        {
+            bits &= bits - 1;
+        }
+
+        *addr += __builtin_ctzll(bits) * relocs->entry_size;
+    }
+
+    return low;
+}
+
+static void render_relr_row(const reloc_rows_data *relocs, const size_t reloc_idx, efb_buffer *out_buffer)
+{
+    char type_str[RELOC_TYPE_SIZE];
+    GElf_Addr addr;
+    size_t entry_idx = get_relr_reloc(relocs, reloc_idx, &addr);
+
+    efb_buf_printf(out_buffer, "%7zu:  %016lx %-24s [entry %zu]\n", reloc_idx, addr,
+        format_reloc_type(relocs->machine, get_relative_type(relocs->machine), type_str), entry_idx);
+}
+
+static void render_rela_row(const reloc_rows_data *relocs, const size_t entry_idx, efb_buffer *out_buffer)
+{
+    char type_str[RELOC_TYPE_SIZE];
+    GElf_Rela rela;
+
+    get_reloc(relocs, entry_idx, &rela);
+
+    efb_buf_printf(out_buffer, "%7zu:  %016lx %016lx %-24s", entry_idx, rela.r_offset, rela.r_info,
+        format_reloc_type(relocs->machine, GELF_R_TYPE(rela.r_info), type_str));
+
+    GElf_Sym sym;
+    size_t sym_idx = GELF_R_SYM(rela.r_info);
+    bool has_sym = (sym_idx != 0) && (relocs->sym_data != NULL) && (gelf_getsym(relocs->sym_data, sym_idx, &sym) == &sym);
+
+    if (has_sym)
+    {
+        efb_buf_printf(out_buffer, " %016lx %s", sym.st_value, efb_get_sym_name(relocs->str_data, sym.st_name));
+    }
+    else
+    {
+        efb_buf_printf(out_buffer, " %16s", "");
+    }
+
+    if (relocs->sect_type == SHT_RELA)
+    {
+        efb_buf_printf(out_buffer, " %c 0x%lx", (rela.r_addend < 0) ? '-' : '+',
+            (rela.r_addend < 0) ? -(uint64_t) rela.r_addend : (uint64_t) rela.r_addend);
+    }
+
+    efb_buf_printf(out_buffer, "\n");
+}
+
+// Row 0 is the column heading, row N shows the (N - 1)th relocation
+static void render_reloc_rows(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer * out_buffer)
+{
+    const reloc_rows_data *relocs = rows_data;
+
+    for (size_t row_idx = first_row; row_idx < first_row + row_count; row_idx++)
+    {
+        if (row_idx == 0)
+        {
+            if (relocs->sect_type == SHT_RELR)
+            {
+                efb_buf_printf(out_buffer, "%8s  %-16s %s\n", "Num:", "Offset", "Type");
+            }
+            else
+            {
+                efb_buf_printf(out_buffer, "%8s  %-16s %-16s %-24s %-16s %s\n", "Num:", "Offset", "Info", "Type", "Sym. Value",
+                    (relocs->sect_type == SHT_RELA) ? "Sym. Name + Addend" : "Sym. Name");
+            }
+        }
+        else if (relocs->sect_type == SHT_RELR)
+        {
+            render_relr_row(relocs, row_idx - 1, out_buffer);
+        }
+        else
+        {
+            render_rela_row(relocs, row_idx - 1, out_buffer);
+        }
+    }
+}
+
+static bool locate_reloc_row(const void *rows_data, const efb_locate_kind kind, const uint64_t value, size_t *row)
+{
+    const reloc_rows_data *relocs = rows_data;
+
+    // An offset into the section locates the (first) relocation of the entry which contains it
+    if ((kind != EFB_LOCATE_OFFSET) || (relocs->reloc_count == 0) || (value / relocs->entry_size >= relocs->entry_count))
+    {
+        return false;
+    }
+
+    size_t entry_idx = value / relocs->entry_size;
+    size_t reloc_idx = (relocs->sect_type == SHT_RELR) ? relocs->relr_first[entry_idx] : entry_idx;
+
+    *row = ((reloc_idx < relocs->reloc_count) ? reloc_idx : relocs->reloc_count - 1) + 1;
+    return true;
+}
+
+static void release_reloc_rows(void *rows_data)
+{
+    reloc_rows_data *relocs = rows_data;
+
+    free(relocs->relr_first);
+    free(relocs->relr_base);
+    free(relocs);
+}
+
+void efb_info_sect_relocs(const efb_file *file, Elf_Scn *sect, GElf_Shdr *sect_header, efb_view * view)
+{
+    const efb_sect_table *sections = &file->sections;
+    efb_buffer *out_buffer = &view->text;
+    GElf_Ehdr elf_header;
+
+    efb_get_secthdr_struct(sect_header, out_buffer);
+
+    Elf_Data *rel_data = NULL;
+    if ((rel_data = efb_elf_getdata(sect, rel_data)) == NULL)
+    {
+        errx(EXIT_FAILURE, "elf_getdata() failed: %s.", elf_errmsg(-1));
+    }
+
+    efb_get_elf_data_struct(rel_data, out_buffer);
+
+    if (gelf_getehdr(file->sElf, &elf_header) == NULL)
+    {
+        errx(EXIT_FAILURE, "gelf_getehdr() failed: %s.", elf_errmsg(-1));
+    }
+
+    reloc_rows_data *relocs = calloc(1, sizeof(reloc_rows_data));
+    if (relocs == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the relocation view.");
+    }
+
+    relocs->rel_data = rel_data;
+    relocs->machine = elf_header.e_machine;
+    relocs->sect_type = sect_header->sh_type;
+    relocs->entry_size = sect_header->sh_entsize;
+
+    // RELR entries are words of the file's class
+    if ((relocs->sect_type == SHT_RELR) && (relocs->entry_size != sizeof(uint32_t)) && (relocs->entry_size != sizeof(uint64_t)))
+    {
+        relocs->entry_size = (gelf_getclass(file->sElf) == ELFCLASS32) ? sizeof(uint32_t) : sizeof(uint64_t);
+    }
+
+    relocs->entry_count = (relocs->entry_size > 0) ? rel_data->d_size / relocs->entry_size : 0;
+
+    if ((relocs->sect_type != SHT_RELR) && (sect_header->sh_link > 0) && (sect_header->sh_link < sections->count))
+    {
+        Elf_Scn *sym_sect = sections->scn[sect_header->sh_link];
+        size_t str_idx = sections->link[sect_header->sh_link];
+
+        relocs->sym_data = efb_elf_getdata(sym_sect, NULL);
+        relocs->str_data = ((str_idx > 0) && (str_idx < sections->count)) ? efb_elf_getdata(sections->scn[str_idx], NULL) : NULL;
+    }
+
+    efb_advise_sequential(file->sElf, rel_data->d_buf, rel_data->d_size);
+
+    reloc_type_count *counts = NULL;
+    size_t type_count = 0;
+    bool scanned;
+
+    if (relocs->sect_type == SHT_RELR)
+    {
+        scanned = scan_relr_entries(relocs);
+        counts = malloc(sizeof(reloc_type_count));
+        if (counts == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot allocate the relocation type counts.");
+        }
+
+        counts[type_count++] = (reloc_type_count) { get_relative_type(relocs->machine), relocs->reloc_count };
+    }
+    else
+    {
+        scanned = count_reloc_types(relocs, &counts, &type_count);
+    }
+
+    if (scanned == false)
+    {
+        free(counts);
+        release_reloc_rows(relocs);
+        return;
+    }
+
+    print_type_counts(relocs, counts, type_count, out_buffer);
+    free(counts);
+
+    size_t relr_index_size = (relocs->relr_first != NULL) ? (relocs->entry_count + 1) * (sizeof(size_t) + sizeof(GElf_Addr)) : 0;
+
+    efb_view_add_rows(view, &(efb_row_source) {
+        .row_count = relocs->reloc_count + 1,
+        .rows_data_size = sizeof(reloc_rows_data) + relr_index_size,
+        .render_rows = render_reloc_rows,
+        .locate_row = locate_reloc_row,
+        .release = release_reloc_rows,
+        .rows_data = relocs,
+    });
+}
@@ -0,0 +1,475 @@
+#include "elfibia.h"
+
+#include <dirent.h>
+#include <err.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAX_SCAN_WORKERS 64
+#define SCAN_IDLE_WAIT_US 200
+
+// A directory to read or a file to summarize
+typedef struct
+{
+    char *path;
+    bool is_dir;
+} scan_task;
+
+// The owner pushes and pops at the bottom, thieves take from the top:
+// the owner works depth-first on its own subtree while the others take the oldest (largest) subtrees
+typedef struct
+{
+    pthread_mutex_t lock;
+    scan_task *tasks;
+    size_t top;
+    size_t bottom;
+    size_t capacity;
+} task_deque;
+
+typedef struct
+{
+    task_deque *deques;
+    size_t worker_count;
+    atomic_size_t pending_tasks;
+    atomic_size_t file_count;
+    pthread_mutex_t output_lock;
+} scan_pool;
+
+typedef struct
+{
+    scan_pool *pool;
+    size_t worker_idx;
+    efb_buffer line;
+} scan_worker;
+
+static void push_task(scan_pool *pool, const size_t worker_idx, char *path, const bool is_dir)
+{
+    task_deque *deque = &pool->deques[worker_idx];
+
+    // Counted before it is visible to thieves, so the pool cannot look finished while it is queued
+    atomic_fetch_add(&pool->pending_tasks, 1);
+
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->bottom == deque->capacity)
+    {
+        // Compacts the stolen slots at the top before growing
+        memmove(deque->tasks, &deque->tasks[deque->top], (deque->bottom - deque->top) * sizeof(scan_task));
+        deque->bottom -= deque->top;
+        deque->top = 0;
+
+        if (deque->bottom == deque->capacity)
+        {
+            deque->capacity = (deque->capacity > 0) ? 2 * deque->capacity : 256;
+            deque->tasks = realloc(deque->tasks, deque->capacity * sizeof(scan_task));
+            if (deque->tasks == NULL)
+            {
+                errx(EXIT_FAILURE, "Cannot allocate the scan queue.");
+            }
+        }
+    }
+
+    deque->tasks[deque->bottom++] = (scan_task) { path, is_dir };
+
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static bool pop_task(task_deque *deque, scan_task *task, const bool steal)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->top < deque->bottom)
+    {
+        *task = steal ? deque->tasks[deque->top++] : deque->tasks[--deque->bottom];
+        found = true;
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool take_task(scan_worker *worker, scan_task *task)
+{
+    scan_pool *pool = worker->pool;
+
+    if (pop_task(&pool->deques[worker->worker_idx], task, false))
+    {
+        return true;
+    }
+
+    for (size_t victim_offset = 1; victim_offset < pool->worker_count; victim_offset++)
+    {
+        if (pop_task(&pool->deques[(worker->worker_idx + victim_offset) % pool->worker_count], task, true))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static char * join_path(const char *dir_path, const char *name)
+{
+    size_t dir_len = strlen(dir_path);
+    size_t name_len = strlen(name);
+    char *path = malloc(dir_len + name_len + 2);
+
+    if (path == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate a path.");
+    }
+
+    memcpy(path, dir_path, dir_len);
+    path[dir_len] = '/';
+    memcpy(&path[dir_len + (((dir_len > 0) && (dir_path[dir_len - 1] == '/')) ? 0 : 1)], name, name_len + 1);
+
+    return path;
+}
+
+// Symbolic links are not followed, so the walk stays inside the tree and cannot loop
+static void scan_directory(scan_worker *worker, const char *dir_path)
+{
+    DIR *dir = opendir(dir_path);
+    struct dirent *entry;
+
+    if (dir == NULL)
+    {
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0))
+        {
+            continue;
+        }
+
+        unsigned char entry_type = entry->d_type;
+        char *path = join_path(dir_path, entry->d_name);
+
+        if (entry_type == DT_UNKNOWN)
+        {
+            struct stat path_stat;
+            entry_type = (lstat(path, &path_stat) != 0) ? DT_UNKNOWN
+                : S_ISDIR(path_stat.st_mode) ? DT_DIR : S_ISREG(path_stat.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+
+        if ((entry_type == DT_DIR) || (entry_type == DT_REG))
+        {
+            push_task(worker->pool, worker->worker_idx, path, entry_type == DT_DIR);
+        }
+        else
+        {
+            free(path);
+        }
+    }
+
+    closedir(dir);
+}
+
+// Most files of an image are not ELF objects: the magic is checked before libelf maps the file
+static bool has_elf_magic(const char *path)
+{
+    unsigned char magic[SELFMAG];
+    int fd = open(path, O_RDONLY, 0);
+    bool is_elf = false;
+
+    if (fd >= 0)
+    {
+        is_elf = (read(fd, magic, SELFMAG) == SELFMAG) && (memcmp(magic, ELFMAG, SELFMAG) == 0);
+        close(fd);
+    }
+
+    return is_elf;
+}
+
+static const char * get_scan_machine(const GElf_Half machine)
+{
+    switch (machine)
+    {
+    case EM_386:
+        return "i386";
+    case EM_X86_64:
+        return "x86-64";
+    case EM_ARM:
+        return "arm";
+    case EM_AARCH64:
+        return "aarch64";
+    case EM_RISCV:
+        return "riscv";
+    case EM_PPC64:
+        return "ppc64";
+    case EM_S390:
+        return "s390";
+    default:
+        return NULL;
+    }
+}
+
+static const char * get_scan_type(const GElf_Half type)
+{
+    switch (type)
+    {
+    case ET_REL:
+        return "REL";
+    case ET_EXEC:
+        return "EXEC";
+    case ET_DYN:
+        return "DYN";
+    case ET_CORE:
+        return "CORE";
+    default:
+        return "OTHER";
+    }
+}
+
+static void print_segment_flags(const GElf_Word flags, efb_buffer *line)
+{
+    efb_buf_printf(line, "%s%s%s", (flags & PF_R) ? "R" : "", (flags & PF_W) ? "W" : "", (flags & PF_X) ? "X" : "");
+}
+
+static void summarize_segments(Elf *sElf, efb_buffer *line)
+{
+    size_t seg_count;
+    GElf_Phdr prg_hdr;
+    bool has_stack = false;
+    bool exec_stack = false;
+    bool has_relro = false;
+    bool first_load = true;
+
+    if (elf_getphdrnum(sElf, &seg_count) != 0)
+    {
+        seg_count = 0;
+    }
+
+    efb_buf_printf(line, " load=[");
+    for (size_t seg_idx = 0; seg_idx < seg_count; seg_idx++)
+    {
+        if (gelf_getphdr(sElf, seg_idx, &prg_hdr) != &prg_hdr)
+        {
+            continue;
+        }
+
+        if (prg_hdr.p_type == PT_LOAD)
+        {
+            efb_buf_printf(line, first_load ? "" : ",");
+            print_segment_flags(prg_hdr.p_flags, line);
+            first_load = false;
+        }
+        else if (prg_hdr.p_type == PT_GNU_STACK)
+        {
+            has_stack = true;
+            exec_stack = (prg_hdr.p_flags & PF_X) != 0;
+        }
+        else if (prg_hdr.p_type == PT_GNU_RELRO)
+        {
+            has_relro = true;
+        }
+    }
+
+    // Without PT_GNU_STACK the loader falls back to an executable stack
+    efb_buf_printf(line, "] stack=%s relro=%s", (has_stack == false) ? (seg_count > 0 ? "default-exec" : "none")
+        : exec_stack ? "exec" : "noexec", has_relro ? "yes" : "no");
+}
+
+static void summarize_needed(const efb_file *file, efb_buffer *line)
+{
+    const efb_sect_table *sections = &file->sections;
+    bool first_needed = true;
+
+    efb_buf_printf(line, " needed=[");
+
+    for (size_t sect_idx = 1; sect_idx < sections->count; sect_idx++)
+    {
+        if ((sections->type[sect_idx] != SHT_DYNAMIC) || (sections->entsize[sect_idx] == 0))
+        {
+            continue;
+        }
+
+        Elf_Data *dyn_data = elf_getdata(sections->scn[sect_idx], NULL);
+        if (dyn_data == NULL)
+        {
+            continue;
+        }
+
+        size_t dyn_count = dyn_data->d_size / sections->entsize[sect_idx];
+        for (size_t dyn_idx = 0; dyn_idx < dyn_count; dyn_idx++)
+        {
+            GElf_Dyn dyn;
+            if ((gelf_getdyn(dyn_data, dyn_idx, &dyn) != &dyn) || (dyn.d_tag == DT_NULL))
+            {
+                break;
+            }
+
+            if (dyn.d_tag == DT_NEEDED)
+            {
+                const char *name = elf_strptr(file->sElf, sections->link[sect_idx], dyn.d_un.d_val);
+                efb_buf_printf(line, "%s%s", first_needed ? "" : ",", (name != NULL) ? name : "?");
+                first_needed = false;
+            }
+        }
+    }
+
+    efb_buf_printf(line, "]\n");
+}
+
+static void scan_file(scan_worker *worker, const char *path)
+{
+    efb_buffer *line = &worker->line;
+    efb_file file;
+    GElf_Ehdr elf_hdr;
+
+    if (has_elf_magic(path) == false)
+    {
+        return;
+    }
+
+    efb_buf_reset(line);
+    efb_buf_printf(line, "%s:", path);
+
+    if (efb_file_open(&file, path) == false)
+    {
+        efb_buf_printf(line, " error=\"%s\"\n", file.error);
+    }
+    else if (gelf_getehdr(file.sElf, &elf_hdr) == NULL)
+    {
+        efb_buf_printf(line, " error=\"%s\"\n", elf_errmsg(-1));
+        efb_file_close(&file);
+    }
+    else
+    {
+        const char *machine = get_scan_machine(elf_hdr.e_machine);
+
+        efb_buf_printf(line, " class=%s", (gelf_getclass(file.sElf) == ELFCLASS32) ? "ELF32" : "ELF64");
+        if (machine != NULL)
+        {
+            efb_buf_printf(line, " machine=%s", machine);
+        }
+        else
+        {
+            efb_buf_printf(line, " machine=%d", elf_hdr.e_machine);
+        }
+        efb_buf_printf(line, " type=%s", get_scan_type(elf_hdr.e_type));
+
+        summarize_segments(file.sElf, line);
+        efb_summarize_hash_tables(&file, line);
+        summarize_needed(&file, line);
+        efb_file_close(&file);
+    }
+
+    // Each summary is written as soon as it is ready, whole lines only
+    pthread_mutex_lock(&worker->pool->output_lock);
+    fwrite(line->data, 1, line->length, stdout);
+    fflush(stdout);
+    pthread_mutex_unlock(&worker->pool->output_lock);
+
+    atomic_fetch_add(&worker->pool->file_count, 1);
+}
+
+static void * scan_thread(void *arg)
+{
+    scan_worker *worker = arg;
+    scan_task task;
+
+    while (atomic_load(&worker->pool->pending_tasks) > 0)
+    {
+        if (take_task(worker, &task) == false)
+        {
+            // Another worker is still reading a directory which may add tasks
+            usleep(SCAN_IDLE_WAIT_US);
+            continue;
+        }
+
+        if (task.is_dir)
+        {
+            scan_directory(worker, task.path);
+        }
+        else
+        {
+            scan_file(worker, task.path);
+        }
+
+        free(task.path);
+        atomic_fetch_sub(&worker->pool->pending_tasks, 1);
+    }
+
+    return NULL;
+}
+
+static size_t get_scan_worker_count(void)
+{
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t worker_count = (cpu_count > 0) ? (size_t) cpu_count : 1;
+
+    return (worker_count < MAX_SCAN_WORKERS) ? worker_count : MAX_SCAN_WORKERS;
+}
+
+// Writes a one-line summary of every ELF file under root_path; returns the number of ELF files found
+size_t efb_scan_tree(const char *root_path)
+{
+    scan_pool pool;
+    pthread_t threads[MAX_SCAN_WORKERS];
+    scan_worker workers[MAX_SCAN_WORKERS];
+    struct stat root_stat;
+
+    if (stat(root_path, &root_stat) != 0)
+    {
+        return 0;
+    }
+
+    pool.worker_count = get_scan_worker_count();
+    pool.deques = calloc(pool.worker_count, sizeof(task_deque));
+    if (pool.deques == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the scan queues.");
+    }
+
+    atomic_init(&pool.pending_tasks, 0);
+    atomic_init(&pool.file_count, 0);
+    pthread_mutex_init(&pool.output_lock, NULL);
+
+    for (size_t worker_idx = 0; worker_idx < pool.worker_count; worker_idx++)
+    {
+        pthread_mutex_init(&pool.deques[worker_idx].lock, NULL);
+        workers[worker_idx] = (scan_worker) { .pool = &pool, .worker_idx = worker_idx };
+        efb_buf_init(&workers[worker_idx].line);
+    }
+
+    push_task(&pool, 0, strdup(root_path), S_ISDIR(root_stat.st_mode));
+
+    size_t started_count = 1;
+    for (; started_count < pool.worker_count; started_count++)
+    {
+        if (pthread_create(&threads[started_count], NULL, scan_thread, &workers[started_count]) != 0)
+        {
+            break;
+        }
+    }
+
+    // The calling thread is worker 0
+    scan_thread(&workers[0]);
+
+    for (size_t worker_idx = 1; worker_idx < started_count; worker_idx++)
+    {
+        pthread_join(threads[worker_idx], NULL);
+    }
+
+    for (size_t worker_idx = 0; worker_idx < pool.worker_count; worker_idx++)
+    {
+        efb_buf_free(&workers[worker_idx].line);
+        pthread_mutex_destroy(&pool.deques[worker_idx].lock);
+        free(pool.deques[worker_idx].tasks);
+    }
+
+    free(pool.deques);
+    pthread_mutex_destroy(&pool.output_lock);
+
+    return atomic_load(&pool.file_count);
+}
@@ -6,26 +6,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define DUMP_ROW_WIDTH 16
-#define DUMP_COL_WIDTH 4
-#define BUF_HEX_SIZE   (2 * DUMP_ROW_WIDTH + DUMP_COL_WIDTH + 1)
-
-static size_t get_secthdr_strtbl_idx(Elf *sElf)
-{
-    size_t sect_hdr_strtbl_idx;
-
-    if (elf_getshdrstrndx(sElf, &sect_hdr_strtbl_idx) != 0)
-    {
-        printf("elf_getshdrstrndx() failed: %s", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
-    }
-
-    return sect_hdr_strtbl_idx;
-}
-
-static void get_secthdr_struct(GElf_Shdr *elfShdr, char * out_buffer)
+void efb_get_secthdr_struct(GElf_Shdr *elfShdr, efb_buffer * out_buffer)
 {
-    sprintf(&out_buffer[strlen(out_buffer)],
+    efb_buf_printf(out_buffer,
         "sh_addr      = %lx\n"
         "sh_addralign = %ld\n"
         "sh_entsize   = %ld\n"
@@ -41,9 +24,9 @@ static void get_secthdr_struct(GElf_Shdr *elfShdr, char * out_buffer)
         elfShdr->sh_name, elfShdr->sh_offset, elfShdr->sh_size, elfShdr->sh_type);
 }
 
-static void get_elf_data_struct(Elf_Data *elf_data, char * out_buffer)
+void efb_get_elf_data_struct(Elf_Data *elf_data, efb_buffer * out_buffer)
 {
-    sprintf(&out_buffer[strlen(out_buffer)],
+    efb_buf_printf(out_buffer,
         "d_buf     = %p\n"
         "d_type    = %d\n"
         "d_version = %d\n"
@@ -54,67 +37,129 @@ static void get_elf_data_struct(Elf_Data *elf_data, char * out_buffer)
         elf_data->d_size, elf_data->d_off, elf_data->d_align);
 }
 
-static void dump_sect_data(Elf_Data *elf_data, GElf_Addr sect_addr, char * out_buffer)
+typedef struct
 {
-    size_t data_index = 0;
-    size_t row_index = 0;
-    size_t buf_hex_index = 0;
-    size_t buf_char_index = 0;
-    const char *ptr_data = elf_data->d_buf;
-    char buf_hex[BUF_HEX_SIZE];
-    char buf_char[DUMP_ROW_WIDTH + 1];
+    const unsigned char *data;
+    size_t size;
+    GElf_Addr addr;
+    int addr_width;
+    const efb_addr_index *symbols;
+} dump_rows_data;
+
+// Appends the symbol which contains the first byte of the row, or else the first symbol starting in the row
+static void annotate_dump_row(const dump_rows_data *dump, const size_t row_idx, efb_buffer * out_buffer)
+{
+    GElf_Addr row_addr = dump->addr + row_idx * EFB_DUMP_ROW_WIDTH;
+    size_t interval_idx;
 
-    if (elf_data->d_buf != NULL)
+    if (efb_addr_index_lookup(dump->symbols, row_addr, row_addr + EFB_DUMP_ROW_WIDTH, &interval_idx) == false)
     {
-        while (ptr_data < ((char *)elf_data->d_buf + elf_data->d_size))
-        {
-            sprintf(&buf_hex[buf_hex_index], "%02x", *ptr_data);
-            buf_hex_index += 2;
-            sprintf(&buf_char[buf_char_index++], "%c", (*ptr_data < ' ' || *ptr_data > '~') ? '.' : *ptr_data);
-            data_index++;
-            row_index++;
-            ptr_data++;
-            if ((data_index % DUMP_COL_WIDTH) == 0)
-            {
-                sprintf(&buf_hex[buf_hex_index++], "%c", ' ');
-            }
+        return;
+    }
 
-            if (((row_index % DUMP_ROW_WIDTH) == 0) || (data_index >= elf_data->d_size))
-            {
-                buf_hex_index = 0;
-                buf_char_index = 0;
-                int buf_padding = BUF_HEX_SIZE - buf_hex_index;
+    GElf_Addr sym_addr = dump->symbols->sym_addr[interval_idx];
+    GElf_Addr sym_offset = (row_addr > sym_addr) ? row_addr - sym_addr : 0;
+    int padding = (row_addr < sym_addr) ? (int) (sym_addr - row_addr) : 0;
 
-                // TODO it should be 32 and 64 bit compatible (depending on the sect_addr type)
-                sprintf(&out_buffer[strlen(out_buffer)], "  0x%08lx %*s%s\n", sect_addr + data_index - row_index, -buf_padding, buf_hex, buf_char);
-                row_index = 0;
-            }
-        }
+    // A symbol starting inside the row is marked by its distance from the row start
+    if (padding > 0)
+    {
+        efb_buf_printf(out_buffer, "  <+%d: %s>", padding, dump->symbols->name[interval_idx]);
+    }
+    else if (sym_offset > 0)
+    {
+        efb_buf_printf(out_buffer, "  <%s+0x%lx>", dump->symbols->name[interval_idx], sym_offset);
     }
     else
     {
-        sprintf(&out_buffer[strlen(out_buffer)], "The section has no data to dump.\n");
+        efb_buf_printf(out_buffer, "  <%s>", dump->symbols->name[interval_idx]);
     }
 }
 
-static void dump_sect_strings(Elf_Data *elf_data, GElf_Addr sect_addr, char * out_buffer)
+static void render_dump_rows(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer * out_buffer)
 {
-    const char *ptr_data = elf_data->d_buf;
-    size_t data_index = 0;
+    const dump_rows_data *dump = rows_data;
 
-    if ((*ptr_data == 0) && (elf_data->d_size > 0))
+    if ((dump->symbols == NULL) || (dump->symbols->count == 0))
     {
-        sprintf(&out_buffer[strlen(out_buffer)], "  [%6d]  %s\n", 0, "(empty string)");
-        ptr_data++;
-        data_index++;
+        efb_hex_dump_rows(dump->data, dump->size, dump->addr, dump->addr_width, first_row, row_count, out_buffer);
+        return;
     }
 
-    while (ptr_data < ((char *)elf_data->d_buf + elf_data->d_size))
+    // Annotated rows are formatted one by one, with one lookup per visible row
+    for (size_t row_idx = first_row; row_idx < first_row + row_count; row_idx++)
     {
-        size_t str_size = strlen(ptr_data) + 1;
-        sprintf(&out_buffer[strlen(out_buffer)], "  [%6ld]  %s\n", data_index, ptr_data);
-        ptr_data += str_size;
-        data_index += str_size;
+        size_t row_start = out_buffer->length;
+
+        efb_hex_dump_rows(dump->data, dump->size, dump->addr, dump->addr_width, row_idx, 1, out_buffer);
+        if (out_buffer->length == row_start)
+        {
+            break;
+        }
+
+        bool has_newline = (out_buffer->data[out_buffer->length - 1] == '\n');
+        efb_buf_truncate(out_buffer, out_buffer->length - (has_newline ? 1 : 0));
+        annotate_dump_row(dump, row_idx, out_buffer);
+        efb_buf_putc(out_buffer, '\n');
+    }
+}
+
+static bool locate_dump_row(const void *rows_data, const efb_locate_kind kind, const uint64_t value, size_t *row)
+{
+    const dump_rows_data *dump = rows_data;
+    uint64_t offset = value;
+
+    if (kind == EFB_LOCATE_ADDRESS)
+    {
+        if ((dump->addr == 0) || (value < dump->addr))
+        {
+            return false;
+        }
+
+        offset = value - dump->addr;
+    }
+    else if (kind != EFB_LOCATE_OFFSET)
+    {
+        return false;
+    }
+
+    if (offset >= dump->size)
+    {
+        return false;
+    }
+
+    *row = offset / EFB_DUMP_ROW_WIDTH;
+    return true;
+}
+
+// The rows of the dump are rendered on demand, so only the visible part of a large section is formatted
+static void dump_sect_data(Elf *sElf, Elf_Data *elf_data, GElf_Addr sect_addr, const bool annotate, efb_view * view)
+{
+    if ((elf_data->d_buf != NULL) && (elf_data->d_size > 0))
+    {
+        dump_rows_data *dump = malloc(sizeof(dump_rows_data));
+        if (dump == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot allocate the section dump.");
+        }
+
+        efb_advise_sequential(sElf, elf_data->d_buf, elf_data->d_size);
+
+        *dump = (dump_rows_data) { elf_data->d_buf, elf_data->d_size, sect_addr, (gelf_getclass(sElf) == ELFCLASS32) ? 8 : 16,
+            ((annotate == true) && (sect_addr != 0)) ? efb_get_addr_index() : NULL };
+
+        efb_view_add_rows(view, &(efb_row_source) {
+            .row_count = (elf_data->d_size + EFB_DUMP_ROW_WIDTH - 1) / EFB_DUMP_ROW_WIDTH,
+            .rows_data_size = sizeof(dump_rows_data),
+            .render_rows = render_dump_rows,
+            .locate_row = locate_dump_row,
+            .release = free,
+            .rows_data = dump,
+        });
+    }
+    else
+    {
+        efb_buf_printf(&view->text, "The section has no data to dump.\n");
     }
 }
 
@@ -158,12 +203,14 @@ static char * efb_get_section_type(const long int sect_type)
             return "SYMTAB_SHNDX";
         case SHT_RELR:
             return "RELR";
+        case SHT_GNU_HASH:
+            return "GNU_HASH";
         default:
             return "<unknown>";
     }
 }
 
-char * get_dynamic_type(const long int dyn_type)
+char * efb_get_dynamic_type(const long int dyn_type)
 {
     switch (dyn_type)
     {
@@ -276,7 +323,7 @@ char * get_dyn_symbol_val(Elf *sElf, GElf_Shdr *sect_header, GElf_Dyn * elf_dyn_
             sprintf(sym_val, "0x%lx", elf_dyn_symbol->d_un.d_val);
             break;
         case DT_PLTREL:
-            sprintf(sym_val, "%s", get_dynamic_type(elf_dyn_symbol->d_un.d_val));
+            sprintf(sym_val, "%s", efb_get_dynamic_type(elf_dyn_symbol->d_un.d_val));
             break;
         case DT_STRTAB:
             sprintf(sym_val, "0x%lx", elf_dyn_symbol->d_un.d_val);
@@ -322,7 +369,7 @@ char * get_dyn_symbol_val(Elf *sElf, GElf_Shdr *sect_header, GElf_Dyn * elf_dyn_
             break;
         case DT_NEEDED:
             char *sym_name;
-            if ((sym_name = elf_strptr(sElf, sect_header->sh_link, elf_dyn_symbol->d_un.d_val)) == NULL)
+            if ((sym_name = efb_elf_strptr(sElf, sect_header->sh_link, elf_dyn_symbol->d_un.d_val)) == NULL)
             {
                 errx(EXIT_FAILURE, "elf_strptr() failed: %s.", elf_errmsg(-1));
             }
@@ -338,22 +385,29 @@ char * get_dyn_symbol_val(Elf *sElf, GElf_Shdr *sect_header, GElf_Dyn * elf_dyn_
     return sym_val;
 }
 
-void info_sect_dynamic(Elf *sElf, Elf_Scn * sect, GElf_Shdr *sect_header, const bool dump_data, char * out_buffer)
+void info_sect_dynamic(Elf *sElf, Elf_Scn * sect, GElf_Shdr *sect_header, const bool dump_data, efb_view * view)
 {
+    efb_buffer *out_buffer = &view->text;
+
     if (sect_header->sh_type == SHT_DYNAMIC)
     {
-        get_secthdr_struct(sect_header, out_buffer);
+        efb_get_secthdr_struct(sect_header, out_buffer);
 
         Elf_Data *elf_data = NULL;
-        if ((elf_data = elf_getdata(sect, elf_data)) == NULL)
+        if ((elf_data = efb_elf_getdata(sect, elf_data)) == NULL)
         {
             errx(EXIT_FAILURE, "elf_getdata() failed: %s.", elf_errmsg(-1));
         }
 
-        printf("%-19s %-18s %s\n", " Tag", "Type", "Name / Value");
+        efb_buf_printf(out_buffer, "%-19s %-18s %s\n", " Tag", "Type", "Name / Value");
         GElf_Dyn elf_dyn_symbol;
         for (int idx = 0; idx < (sect_header->sh_size / sect_header->sh_entsize); idx++)
         {
+            if (efb_render_step(idx, sect_header->sh_size / sect_header->sh_entsize) == false)
+            {
+                return;
+            }
+
             if (gelf_getdyn(elf_data, idx, &elf_dyn_symbol) == NULL)
             {
                 errx(EXIT_FAILURE, "gelf_getsym() failed: %s.", elf_errmsg(-1));
@@ -364,130 +418,281 @@ void info_sect_dynamic(Elf *sElf, Elf_Scn * sect, GElf_Shdr *sect_header, const
                 // TODO check if the size is enough
                 // Add a guard condition
                 char sym_val[100] = { "<unknown>" };
-                sprintf(&out_buffer[strlen(out_buffer)], " 0x%016lx %-18s %s\n",
+                efb_buf_printf(out_buffer, " 0x%016lx %-18s %s\n",
                         elf_dyn_symbol.d_tag,
-                        get_dynamic_type(elf_dyn_symbol.d_tag),
+                        efb_get_dynamic_type(elf_dyn_symbol.d_tag),
                         get_dyn_symbol_val(sElf, sect_header, &elf_dyn_symbol, sym_val));
             }
         }
 
-        putchar('\n');
+        efb_buf_putc(out_buffer, '\n');
 
-        get_elf_data_struct(elf_data, out_buffer);
+        efb_get_elf_data_struct(elf_data, out_buffer);
 
         if (dump_data == true)
         {
-            dump_sect_data(elf_data, sect_header->sh_addr, out_buffer);
+            dump_sect_data(sElf, elf_data, sect_header->sh_addr, false, view);
         }
     }
 }
 
-static void info_sect_strtab(Elf_Scn * elf_sect, GElf_Shdr *sect_header, const bool dump_data, char * out_buffer)
+static void info_sect_strtab(Elf *sElf, Elf_Scn * elf_sect, GElf_Shdr *sect_header, const bool dump_data, efb_view * view)
 {
+    efb_buffer *out_buffer = &view->text;
+
     if (sect_header->sh_type == SHT_STRTAB)
     {
-        get_secthdr_struct(sect_header, out_buffer);
+        efb_get_secthdr_struct(sect_header, out_buffer);
 
         Elf_Data *elf_data = NULL;
-        if ((elf_data = elf_getdata(elf_sect, elf_data)) == NULL)
+        if ((elf_data = efb_elf_getdata(elf_sect, elf_data)) == NULL)
         {
             errx(EXIT_FAILURE, "elf_getdata() failed: %s.", elf_errmsg(-1));
         }
 
-        get_elf_data_struct(elf_data, out_buffer);
-        dump_sect_strings(elf_data, sect_header->sh_addr, out_buffer);
+        efb_get_elf_data_struct(elf_data, out_buffer);
+        efb_info_sect_strings(elf_data, view);
 
         if (dump_data == true)
         {
-            dump_sect_data(elf_data, sect_header->sh_addr, out_buffer);
+            dump_sect_data(sElf, elf_data, sect_header->sh_addr, false, view);
         }
     }
 }
 
-static char * efb_get_sect_name(Elf *sElf, Elf64_Word sect_name_offset)
+void efb_get_sect_name_and_type(const efb_file *file, const size_t sect_idx, item_data * it_data)
 {
-    char *sect_name = NULL;
+    const efb_sect_table *sections = &file->sections;
 
-    if ((sect_name = elf_strptr(sElf, get_secthdr_strtbl_idx(sElf), sect_name_offset)) == NULL)
-    {
-        printf("elf_strptr() failed: %s\n", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
-    }
+    it_data->item_name = (sect_idx > 0) ? (char *) sections->name[sect_idx] : NULL;
+    it_data->item_descr = efb_get_section_type(sections->type[sect_idx]);
+}
 
-    return sect_name;
+size_t efb_get_sect_count(const efb_file *file)
+{
+    return file->sections.count;
 }
 
-void efb_get_sect_name_and_type(Elf *sElf, item_data * it_data)
+void efb_get_section_content(const efb_file *file, const int section_idx, efb_view * view)
 {
-    Elf_Scn *sect = NULL;
-    while ((sect = elf_nextscn(sElf, sect)) != NULL)
+    Elf *sElf = file->sElf;
+    const efb_sect_table *sections = &file->sections;
+    efb_buffer *out_buffer = &view->text;
+
+    if ((section_idx > 0) && ((size_t) section_idx < sections->count))
     {
+        Elf_Scn *sect = sections->scn[section_idx];
         GElf_Shdr sect_header;
-        if (gelf_getshdr(sect, &sect_header) != &sect_header)
+
+        efb_sect_table_get_shdr(sections, section_idx, &sect_header);
+
+        efb_buf_printf(out_buffer, "Section %jd\n", (uintmax_t)section_idx);
+        if (((sect_header.sh_flags & SHF_COMPRESSED) != 0) && efb_info_sect_compressed(sElf, sect, &sect_header, view))
         {
-            printf("getshdr() failed: %s\n", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
+            return;
         }
 
-        it_data[elf_ndxscn(sect)].item_name = efb_get_sect_name(sElf, sect_header.sh_name);
-        it_data[elf_ndxscn(sect)].item_descr = efb_get_section_type(sect_header.sh_type);
+        switch (sect_header.sh_type)
+        {
+        case SHT_DYNAMIC:
+            info_sect_dynamic(sElf, sect, &sect_header, true, view);
+            break;
+        case SHT_STRTAB:
+            info_sect_strtab(sElf, sect, &sect_header, true, view);
+            break;
+        case SHT_SYMTAB:
+        case SHT_DYNSYM:
+            efb_info_sect_symbols(file, sect, &sect_header, view);
+            break;
+        case SHT_REL:
+        case SHT_RELA:
+        case SHT_RELR:
+            efb_info_sect_relocs(file, sect, &sect_header, view);
+            break;
+        case SHT_HASH:
+        case SHT_GNU_HASH:
+            efb_info_sect_hash(file, section_idx, &sect_header, view);
+            break;
+        default:
+            efb_get_secthdr_struct(&sect_header, out_buffer);
+
+            Elf_Data *elf_data = NULL;
+            if ((elf_data = efb_elf_getdata(sect, elf_data)) == NULL)
+            {
+                errx(EXIT_FAILURE, "elf_getdata() failed: %s.", elf_errmsg(-1));
+            }
+
+            efb_get_elf_data_struct(elf_data, out_buffer);
+
+            // Merged string sections, e.g. .debug_str or .comment
+            if (((sect_header.sh_flags & (SHF_STRINGS | SHF_COMPRESSED)) == SHF_STRINGS) && (sect_header.sh_entsize <= 1))
+            {
+                efb_info_sect_strings(elf_data, view);
+            }
+
+            if (((sect_header.sh_flags & SHF_EXECINSTR) == 0) || (efb_info_sect_disasm(file, elf_data, &sect_header, view) == false))
+            {
+                dump_sect_data(sElf, elf_data, sect_header.sh_addr, (sect_header.sh_flags & SHF_ALLOC) != 0, view);
+            }
+            break;
+        }
+    }
+
+    if (out_buffer->length == 0)
+    {
+        efb_buf_printf(out_buffer, "Section %jd\n(empty)", (uintmax_t)section_idx);
     }
 }
 
-size_t efb_get_sect_count(Elf *sElf)
+static void json_sect_header(const efb_sect_table *sections, const size_t sect_idx, efb_json_writer *writer)
 {
-    size_t section_count;
-    if (elf_getshdrnum(sElf, &section_count) != 0)
+    efb_json_uint(writer, "index", sect_idx);
+    efb_json_string(writer, "name", sections->name[sect_idx]);
+    efb_json_string(writer, "sh_type", efb_get_section_type(sections->type[sect_idx]));
+    efb_json_hex(writer, "sh_flags", sections->flags[sect_idx]);
+    efb_json_hex(writer, "sh_addr", sections->addr[sect_idx]);
+    efb_json_uint(writer, "sh_offset", sections->offset[sect_idx]);
+    efb_json_uint(writer, "sh_size", sections->size[sect_idx]);
+    efb_json_uint(writer, "sh_link", sections->link[sect_idx]);
+    efb_json_uint(writer, "sh_info", sections->info[sect_idx]);
+    efb_json_uint(writer, "sh_addralign", sections->addralign[sect_idx]);
+    efb_json_uint(writer, "sh_entsize", sections->entsize[sect_idx]);
+}
+
+// One row per section with the fields of the JSON section record
+void efb_get_sections_summary(const efb_file *file, efb_buffer * out_buffer)
+{
+    const efb_sect_table *sections = &file->sections;
+    int name_width = strlen("Name");
+
+    for (size_t sect_idx = 0; sect_idx < sections->count; sect_idx++)
     {
-        printf("elf_getshdrnum() failed: %s", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
+        int name_length = strlen(sections->name[sect_idx]);
+        name_width = (name_length > name_width) ? name_length : name_width;
     }
 
-    return section_count;
+    efb_buf_printf(out_buffer, "Sections: %zu\n\n", sections->count);
+    efb_buf_printf(out_buffer, "  %6s  %-*s  %-14s  %8s  %16s  %10s  %10s\n", "Index", name_width, "Name", "Type", "Flags", "Address",
+        "Offset", "Size");
+
+    for (size_t sect_idx = 0; sect_idx < sections->count; sect_idx++)
+    {
+        efb_buf_printf(out_buffer, "  %6zu  %-*s  %-14s  %8lx  %16lx  %10lu  %10lu\n", sect_idx, name_width, sections->name[sect_idx],
+            efb_get_section_type(sections->type[sect_idx]), (unsigned long) sections->flags[sect_idx],
+            (unsigned long) sections->addr[sect_idx], (unsigned long) sections->offset[sect_idx], (unsigned long) sections->size[sect_idx]);
+    }
 }
 
-void efb_get_section_content(Elf *sElf, const int section_idx, char * out_buffer)
+void efb_json_sections(const efb_file *file, efb_json_writer *writer)
 {
-    Elf_Scn *sect = NULL;
+    const efb_sect_table *sections = &file->sections;
 
-    while ((sect = elf_nextscn(sElf, sect)) != NULL)
+    efb_json_begin_record(writer, "sections");
+    efb_json_uint(writer, "count", sections->count);
+    efb_json_begin_table(writer, "sections", "section_header", NULL);
+
+    for (size_t sect_idx = 0; sect_idx < sections->count; sect_idx++)
     {
-        GElf_Shdr sect_header;
-        if (gelf_getshdr(sect, &sect_header) != &sect_header)
+        efb_json_begin_row(writer);
+        json_sect_header(sections, sect_idx, writer);
+        efb_json_end_row(writer);
+    }
+
+    efb_json_end_table(writer);
+    efb_json_end_record(writer);
+}
+
+static void json_sect_dynamic(const efb_file *file, const size_t sect_idx, Elf_Data *elf_data, efb_json_writer *writer)
+{
+    const efb_sect_table *sections = &file->sections;
+    size_t dyn_count = (sections->entsize[sect_idx] > 0) ? elf_data->d_size / sections->entsize[sect_idx] : 0;
+    GElf_Dyn elf_dyn_symbol;
+
+    efb_json_begin_table(writer, "entries", "dynamic", sections->name[sect_idx]);
+
+    for (size_t idx = 0; idx < dyn_count; idx++)
+    {
+        if ((gelf_getdyn(elf_data, idx, &elf_dyn_symbol) == NULL) || (elf_dyn_symbol.d_tag == DT_NULL))
+        {
+            break;
+        }
+
+        efb_json_begin_row(writer);
+        efb_json_hex(writer, "tag", elf_dyn_symbol.d_tag);
+        efb_json_string(writer, "d_type", efb_get_dynamic_type(elf_dyn_symbol.d_tag));
+        efb_json_hex(writer, "value", elf_dyn_symbol.d_un.d_val);
+
+        if ((elf_dyn_symbol.d_tag == DT_NEEDED) || (elf_dyn_symbol.d_tag == DT_SONAME)
+            || (elf_dyn_symbol.d_tag == DT_RPATH) || (elf_dyn_symbol.d_tag == DT_RUNPATH))
         {
-            errx(EXIT_FAILURE, "getshdr() failed: %s.", elf_errmsg(-1));
+            efb_json_string(writer, "name", efb_elf_strptr(file->sElf, sections->link[sect_idx], elf_dyn_symbol.d_un.d_val));
         }
 
-        if (elf_ndxscn(sect) == section_idx)
+        efb_json_end_row(writer);
+    }
+
+    efb_json_end_table(writer);
+}
+
+static void json_sect_strings(const efb_sect_table *sections, const size_t sect_idx, Elf_Data *elf_data, efb_json_writer *writer)
+{
+    const char *ptr_data = elf_data->d_buf;
+    const char *data_end = ptr_data + elf_data->d_size;
+
+    efb_json_begin_table(writer, "strings", "string", sections->name[sect_idx]);
+
+    while ((ptr_data != NULL) && (ptr_data < data_end))
+    {
+        const char *str_end = memchr(ptr_data, '\0', data_end - ptr_data);
+        if (str_end == NULL)
         {
-            sprintf(out_buffer, "Section %jd\n", (uintmax_t)elf_ndxscn(sect));
-            switch (sect_header.sh_type)
-            {
-            case SHT_DYNAMIC:
-                info_sect_dynamic(sElf, sect, &sect_header, true, out_buffer);
-                break;
-            case SHT_STRTAB:
-                info_sect_strtab(sect, &sect_header, true, out_buffer);
-                break;
-            default:
-                get_secthdr_struct(&sect_header, out_buffer);
-
-                Elf_Data *elf_data = NULL;
-                if ((elf_data = elf_getdata(sect, elf_data)) == NULL)
-                {
-                    errx(EXIT_FAILURE, "elf_getdata() failed: %s.", elf_errmsg(-1));
-                }
-
-                get_elf_data_struct(elf_data, out_buffer);
-
-                dump_sect_data(elf_data, sect_header.sh_addr, out_buffer);
-                break;
-            }
+            break;
         }
+
+        efb_json_begin_row(writer);
+        efb_json_uint(writer, "offset", ptr_data - (const char *) elf_data->d_buf);
+        efb_json_string(writer, "value", ptr_data);
+        efb_json_end_row(writer);
+
+        ptr_data = str_end + 1;
+    }
+
+    efb_json_end_table(writer);
+}
+
+// The header of the section, followed by its entries for the dynamic, string and symbol tables
+void efb_json_section(const efb_file *file, const int section_idx, efb_json_writer *writer)
+{
+    const efb_sect_table *sections = &file->sections;
+
+    if ((section_idx <= 0) || ((size_t) section_idx >= sections->count))
+    {
+        return;
     }
 
-    if (strlen(out_buffer) == 0)
+    efb_json_begin_record(writer, "section");
+    json_sect_header(sections, section_idx, writer);
+
+    Elf_Data *elf_data = NULL;
+    if ((sections->type[section_idx] != SHT_NOBITS) && ((elf_data = efb_elf_getdata(sections->scn[section_idx], NULL)) != NULL)
+        && (elf_data->d_buf != NULL))
     {
-        sprintf(out_buffer, "Section %jd\n(empty)", (uintmax_t)elf_ndxscn(sect));
+        switch (sections->type[section_idx])
+        {
+        case SHT_DYNAMIC:
+            json_sect_dynamic(file, section_idx, elf_data, writer);
+            break;
+        case SHT_STRTAB:
+            json_sect_strings(sections, section_idx, elf_data, writer);
+            break;
+        case SHT_SYMTAB:
+        case SHT_DYNSYM:
+            efb_json_symbols(file, section_idx, writer);
+            break;
+        default:
+            break;
+        }
     }
+
+    efb_json_end_record(writer);
 }
@@ -4,7 +4,8 @@
 #include <string.h>
 
 #define CUSTOM_BUFFER_SIZE 50
-static char custom_buf[CUSTOM_BUFFER_SIZE];
+// One per thread, the header and the segments may be rendered at the same time
+static _Thread_local char custom_buf[CUSTOM_BUFFER_SIZE];
 
 static char * get_seg_type(size_t seg_type)
 {
@@ -52,7 +53,7 @@ static char * get_seg_type(size_t seg_type)
     }
 }
 
-void efb_get_segment_content(Elf *sElf, char * out_buffer)
+void efb_get_segment_content(Elf *sElf, efb_buffer * out_buffer)
 {
     size_t seg_count;
     GElf_Phdr prg_hdr;
@@ -65,37 +66,80 @@ void efb_get_segment_content(Elf *sElf, char * out_buffer)
 
     for (int idx = 0; idx < seg_count; idx++)
     {
-        if (gelf_getphdr(sElf, idx, &prg_hdr) != &prg_hdr)
+        if (efb_gelf_getphdr(sElf, idx, &prg_hdr) != &prg_hdr)
         {
             printf("getphdr() failed: %s.\n", elf_errmsg(-1));
             exit(EXIT_FAILURE);
         }
 
-        sprintf(&out_buffer[strlen(out_buffer)], "Segment %d\n", idx);
-        sprintf(&out_buffer[strlen(out_buffer)], "  p_type:   %s\n", get_seg_type(prg_hdr.p_type));
-        sprintf(&out_buffer[strlen(out_buffer)], "  p_offset: %ld\n", prg_hdr.p_offset);
+        efb_buf_printf(out_buffer, "Segment %d\n", idx);
+        efb_buf_printf(out_buffer, "  p_type:   %s\n", get_seg_type(prg_hdr.p_type));
+        efb_buf_printf(out_buffer, "  p_offset: %ld\n", prg_hdr.p_offset);
 
-        sprintf(&out_buffer[strlen(out_buffer)], "  p_align:  %ld\n", prg_hdr.p_align);
-        sprintf(&out_buffer[strlen(out_buffer)], "  p_filesz: %ld\n", prg_hdr.p_filesz);
+        efb_buf_printf(out_buffer, "  p_align:  %ld\n", prg_hdr.p_align);
+        efb_buf_printf(out_buffer, "  p_filesz: %ld\n", prg_hdr.p_filesz);
 
-        sprintf(&out_buffer[strlen(out_buffer)], "  p_flags:  0x%x", prg_hdr.p_flags);
-        sprintf(&out_buffer[strlen(out_buffer)], " [");
+        efb_buf_printf(out_buffer, "  p_flags:  0x%x", prg_hdr.p_flags);
+        efb_buf_printf(out_buffer, " [");
         if (prg_hdr.p_flags & PF_X)
         {
-            sprintf(&out_buffer[strlen(out_buffer)], " execute");
+            efb_buf_printf(out_buffer, " execute");
         }
         if (prg_hdr.p_flags & PF_R)
         {
-            sprintf(&out_buffer[strlen(out_buffer)], " read");
+            efb_buf_printf(out_buffer, " read");
         }
         if (prg_hdr.p_flags & PF_W)
         {
-            sprintf(&out_buffer[strlen(out_buffer)], " write");
+            efb_buf_printf(out_buffer, " write");
         }
-        sprintf(&out_buffer[strlen(out_buffer)], " ]\n");
+        efb_buf_printf(out_buffer, " ]\n");
 
-        sprintf(&out_buffer[strlen(out_buffer)], "  p_memsz:  %ld\n", prg_hdr.p_memsz);
-        sprintf(&out_buffer[strlen(out_buffer)], "  p_paddr:  0x%lx\n", prg_hdr.p_paddr);
-        sprintf(&out_buffer[strlen(out_buffer)], "  p_vaddr:  0x%lx\n\n", prg_hdr.p_vaddr);
+        efb_buf_printf(out_buffer, "  p_memsz:  %ld\n", prg_hdr.p_memsz);
+        efb_buf_printf(out_buffer, "  p_paddr:  0x%lx\n", prg_hdr.p_paddr);
+        efb_buf_printf(out_buffer, "  p_vaddr:  0x%lx\n\n", prg_hdr.p_vaddr);
     }
 }
+
+void efb_json_segments(Elf *sElf, efb_json_writer *writer)
+{
+    size_t seg_count;
+    GElf_Phdr prg_hdr;
+
+    if (elf_getphdrnum(sElf, &seg_count) != 0)
+    {
+        printf("elf_getphdrnum() failed: %s.\n", elf_errmsg(-1));
+        exit(EXIT_FAILURE);
+    }
+
+    efb_json_begin_record(writer, "segments");
+    efb_json_uint(writer, "count", seg_count);
+    efb_json_begin_table(writer, "segments", "segment", NULL);
+
+    for (size_t idx = 0; idx < seg_count; idx++)
+    {
+        if (efb_gelf_getphdr(sElf, idx, &prg_hdr) != &prg_hdr)
+        {
+            printf("getphdr() failed: %s.\n", elf_errmsg(-1));
+            exit(EXIT_FAILURE);
+        }
+
+        efb_json_begin_row(writer);
+        efb_json_uint(writer, "index", idx);
+        efb_json_string(writer, "p_type", get_seg_type(prg_hdr.p_type));
+        efb_json_uint(writer, "p_offset", prg_hdr.p_offset);
+        efb_json_uint(writer, "p_align", prg_hdr.p_align);
+        efb_json_uint(writer, "p_filesz", prg_hdr.p_filesz);
+        efb_json_hex(writer, "p_flags", prg_hdr.p_flags);
+        efb_json_bool(writer, "read", (prg_hdr.p_flags & PF_R) != 0);
+        efb_json_bool(writer, "write", (prg_hdr.p_flags & PF_W) != 0);
+        efb_json_bool(writer, "execute", (prg_hdr.p_flags & PF_X) != 0);
+        efb_json_uint(writer, "p_memsz", prg_hdr.p_memsz);
+        efb_json_hex(writer, "p_paddr", prg_hdr.p_paddr);
+        efb_json_hex(writer, "p_vaddr", prg_hdr.p_vaddr);
+        efb_json_end_row(writer);
+    }
+
+    efb_json_end_table(writer);
+    efb_json_end_record(writer);
+}
@@ -0,0 +1,375 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRINGS_STEP_BYTES (1 << 20)
+// Lengths 0, 1, 2-3, 4-7, ... 512-1023, 1024 and longer
+#define STRINGS_HISTOGRAM_SIZE 12
+
+// The offset of every string, found in one pass when the view is rendered; the rows are formatted only when
+// they are shown. Offsets are 32-bit like the st_name / sh_name fields which refer to them.
+typedef struct
+{
+    const char *data;
+    size_t size;
+    uint32_t *offsets;
+    size_t string_count;
+} string_rows_data;
+
+// The last 8 bytes of the string, last byte first, decide most comparisons without reading the string
+typedef struct
+{
+    uint64_t key;
+    const unsigned char *end;
+    uint32_t length;
+} string_tail;
+
+typedef struct
+{
+    size_t empty_count;
+    size_t duplicate_bytes;
+    size_t suffix_bytes;
+    size_t histogram[STRINGS_HISTOGRAM_SIZE];
+} string_stats;
+
+static size_t get_string_length(const string_rows_data *strings, const size_t string_idx)
+{
+    size_t start = strings->offsets[string_idx];
+
+    // Only the last string may lack its NUL
+    if (string_idx + 1 < strings->string_count)
+    {
+        return strings->offsets[string_idx + 1] - 1 - start;
+    }
+
+    const char *nul = memchr(&strings->data[start], '\0', strings->size - start);
+    return (nul != NULL) ? (size_t) (nul - &strings->data[start]) : strings->size - start;
+}
+
+static size_t get_length_bucket(size_t length)
+{
+    size_t bucket = 0;
+
+    for (; (length > 0) && (bucket < STRINGS_HISTOGRAM_SIZE - 1); length >>= 1)
+    {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static bool index_strings(string_rows_data *strings)
+{
+    size_t capacity = 1024;
+    size_t offset = 0;
+    size_t next_step = 0;
+
+    strings->offsets = malloc(capacity * sizeof(uint32_t));
+    if (strings->offsets == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the string index.");
+    }
+
+    while (offset < strings->size)
+    {
+        if ((offset >= next_step) && (efb_render_step(offset, strings->size) == false))
+        {
+            return false;
+        }
+
+        next_step = (offset >= next_step) ? offset + STRINGS_STEP_BYTES : next_step;
+
+        if (strings->string_count == capacity)
+        {
+            capacity *= 2;
+            strings->offsets = realloc(strings->offsets, capacity * sizeof(uint32_t));
+            if (strings->offsets == NULL)
+            {
+                errx(EXIT_FAILURE, "Cannot allocate the string index for %zu strings.", capacity);
+            }
+        }
+
+        strings->offsets[strings->string_count++] = offset;
+
+        const char *nul = memchr(&strings->data[offset], '\0', strings->size - offset);
+        offset = (nul != NULL) ? (size_t) (nul - strings->data) + 1 : strings->size;
+    }
+
+    return true;
+}
+
+// Orders the strings by their reversed text, so a string is next to the strings it is a suffix of
+static int compare_tails(const void *left, const void *right)
+{
+    const string_tail *left_tail = left;
+    const string_tail *right_tail = right;
+    size_t length = (left_tail->length < right_tail->length) ? left_tail->length : right_tail->length;
+
+    if (left_tail->key != right_tail->key)
+    {
+        return (left_tail->key < right_tail->key) ? -1 : 1;
+    }
+
+    for (size_t pos = sizeof(uint64_t) + 1; pos <= length; pos++)
+    {
+        if (left_tail->end[-pos] != right_tail->end[-pos])
+        {
+            return (left_tail->end[-pos] < right_tail->end[-pos]) ? -1 : 1;
+        }
+    }
+
+    return (left_tail->length < right_tail->length) ? -1 : (left_tail->length > right_tail->length);
+}
+
+// LSD radix sort of the tails by key, a byte per pass; passes where all keys have the same byte are skipped
+static void sort_tail_keys(string_tail *tails, const size_t tail_count)
+{
+    string_tail *sorted = malloc((tail_count > 0 ? tail_count : 1) * sizeof(string_tail));
+    string_tail *source = tails;
+    string_tail *target = sorted;
+
+    if (sorted == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the string statistics.");
+    }
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = { 0 };
+
+        for (size_t tail_idx = 0; tail_idx < tail_count; tail_idx++)
+        {
+            counts[(source[tail_idx].key >> shift) & 0xff]++;
+        }
+
+        if ((tail_count == 0) || (counts[(source[0].key >> shift) & 0xff] == tail_count))
+        {
+            continue;
+        }
+
+        size_t position = 0;
+        for (size_t digit = 0; digit < 256; digit++)
+        {
+            size_t count = counts[digit];
+            counts[digit] = position;
+            position += count;
+        }
+
+        for (size_t tail_idx = 0; tail_idx < tail_count; tail_idx++)
+        {
+            target[counts[(source[tail_idx].key >> shift) & 0xff]++] = source[tail_idx];
+        }
+
+        string_tail *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != tails)
+    {
+        memcpy(tails, source, tail_count * sizeof(string_tail));
+    }
+
+    free(sorted);
+}
+
+// Duplicate bytes are the copies of a string after its first one; suffix-sharable bytes are the strings
+// (with their NULs) which a linker could store as the tail of a longer string
+static void get_string_stats(const string_rows_data *strings, string_stats *stats)
+{
+    string_tail *tails = malloc((strings->string_count > 0 ? strings->string_count : 1) * sizeof(string_tail));
+
+    if (tails == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the string statistics.");
+    }
+
+    memset(stats, 0, sizeof(string_stats));
+
+    for (size_t string_idx = 0; string_idx < strings->string_count; string_idx++)
+    {
+        size_t length = get_string_length(strings, string_idx);
+
+        string_tail *tail = &tails[string_idx];
+
+        tail->end = (const unsigned char *) &strings->data[strings->offsets[string_idx] + length];
+        tail->length = length;
+        tail->key = 0;
+        for (size_t pos = 1; pos <= sizeof(uint64_t); pos++)
+        {
+            tail->key = (tail->key << 8) | ((pos <= length) ? tail->end[-pos] : 0);
+        }
+
+        stats->empty_count += (length == 0) ? 1 : 0;
+        stats->histogram[get_length_bucket(length)]++;
+    }
+
+    // Only the strings which end in the same 8 bytes need comparing byte by byte
+    sort_tail_keys(tails, strings->string_count);
+
+    size_t run_start = 0;
+    while (run_start < strings->string_count)
+    {
+        size_t run_end = run_start + 1;
+        while ((run_end < strings->string_count) && (tails[run_end].key == tails[run_start].key))
+        {
+            run_end++;
+        }
+
+        if (run_end - run_start > 1)
+        {
+            qsort(&tails[run_start], run_end - run_start, sizeof(string_tail), compare_tails);
+        }
+
+        run_start = run_end;
+    }
+
+    for (size_t tail_idx = 0; tail_idx + 1 < strings->string_count; tail_idx++)
+    {
+        const string_tail *tail = &tails[tail_idx];
+        const string_tail *next_tail = &tails[tail_idx + 1];
+
+        if ((tail->length > next_tail->length) || (memcmp(tail->end - tail->length, next_tail->end - tail->length, tail->length) != 0))
+        {
+            continue;
+        }
+
+        if (tail->length == next_tail->length)
+        {
+            stats->duplicate_bytes += tail->length + 1;
+        }
+        else
+        {
+            stats->suffix_bytes += tail->length + 1;
+        }
+    }
+
+    free(tails);
+}
+
+static void print_string_stats(const string_rows_data *strings, const string_stats *stats, efb_buffer *out_buffer)
+{
+    efb_buf_printf(out_buffer, "%zu strings (%zu empty), %zu bytes\n", strings->string_count, stats->empty_count, strings->size);
+    efb_buf_printf(out_buffer, "  duplicate bytes       %10zu (%.1f%%)\n", stats->duplicate_bytes,
+        (strings->size > 0) ? 100.0 * stats->duplicate_bytes / strings->size : 0.0);
+    efb_buf_printf(out_buffer, "  suffix-sharable bytes %10zu (%.1f%%)\n", stats->suffix_bytes,
+        (strings->size > 0) ? 100.0 * stats->suffix_bytes / strings->size : 0.0);
+
+    efb_buf_printf(out_buffer, "\n  %-12s %10s\n", "Length", "Strings");
+    for (size_t bucket = 0; bucket < STRINGS_HISTOGRAM_SIZE; bucket++)
+    {
+        char range[32];
+        size_t low = (bucket > 0) ? (size_t) 1 << (bucket - 1) : 0;
+
+        if (bucket == STRINGS_HISTOGRAM_SIZE - 1)
+        {
+            snprintf(range, sizeof(range), "%zu+", low);
+        }
+        else if (bucket < 2)
+        {
+            snprintf(range, sizeof(range), "%zu", low);
+        }
+        else
+        {
+            snprintf(range, sizeof(range), "%zu-%zu", low, 2 * low - 1);
+        }
+
+        efb_buf_printf(out_buffer, "  %12s %10zu %6.1f%%\n", range, stats->histogram[bucket],
+            (strings->string_count > 0) ? 100.0 * stats->histogram[bucket] / strings->string_count : 0.0);
+    }
+
+    efb_buf_printf(out_buffer, "\n");
+}
+
+static void render_string_rows(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer * out_buffer)
+{
+    const string_rows_data *strings = rows_data;
+
+    for (size_t row_idx = first_row; row_idx < first_row + row_count; row_idx++)
+    {
+        size_t offset = strings->offsets[row_idx];
+        size_t length = get_string_length(strings, row_idx);
+
+        if ((offset == 0) && (length == 0))
+        {
+            efb_buf_printf(out_buffer, "  [%6d]  %s\n", 0, "(empty string)");
+        }
+        else
+        {
+            efb_buf_printf(out_buffer, "  [%6zu]  %.*s\n", offset, (int) length, &strings->data[offset]);
+        }
+    }
+}
+
+// An offset into the section locates the string which contains it
+static bool locate_string_row(const void *rows_data, const efb_locate_kind kind, const uint64_t value, size_t *row)
+{
+    const string_rows_data *strings = rows_data;
+    size_t low = 0;
+    size_t high = strings->string_count;
+
+    if ((kind != EFB_LOCATE_OFFSET) || (value >= strings->size) || (strings->string_count == 0))
+    {
+        return false;
+    }
+
+    while (high - low > 1)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (strings->offsets[mid] <= value)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    *row = low;
+    return true;
+}
+
+static void release_string_rows(void *rows_data)
+{
+    string_rows_data *strings = rows_data;
+
+    free(strings->offsets);
+    free(strings);
+}
+
+void efb_info_sect_strings(Elf_Data *elf_data, efb_view * view)
+{
+    string_rows_data *strings = calloc(1, sizeof(string_rows_data));
+    string_stats stats;
+
+    if (strings == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the string view.");
+    }
+
+    strings->data = elf_data->d_buf;
+    strings->size = (elf_data->d_buf != NULL) ? elf_data->d_size : 0;
+    strings->size = (strings->size <= UINT32_MAX) ? strings->size : UINT32_MAX;
+
+    if (index_strings(strings) == false)
+    {
+        release_string_rows(strings);
+        return;
+    }
+
+    get_string_stats(strings, &stats);
+    print_string_stats(strings, &stats, &view->text);
+
+    efb_view_add_rows(view, &(efb_row_source) {
+        .row_count = strings->string_count,
+        .rows_data_size = sizeof(string_rows_data) + strings->string_count * sizeof(uint32_t),
+        .render_rows = render_string_rows,
+        .locate_row = locate_string_row,
+        .release = release_string_rows,
+        .rows_data = strings,
+    });
+}
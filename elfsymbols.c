@@ -0,0 +1,438 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+    SYM_ORDER_INDEX,
+    SYM_ORDER_ADDRESS,
+    SYM_ORDER_SIZE,
+    SYM_ORDER_NAME,
+    SYM_ORDER_COUNT
+} sym_order;
+
+static const char * const sym_order_names[SYM_ORDER_COUNT] = { "index", "address", "size", "name" };
+
+// The symbols are decoded from the section data only when their rows are rendered;
+// the permutation of a sort order is computed the first time the order is selected
+typedef struct
+{
+    Elf_Data *sym_data;
+    Elf_Data *str_data;
+    Elf_Data *shndx_data;
+    const efb_sect_table *sections;
+    size_t sym_count;
+    sym_order order;
+    uint32_t *order_perm[SYM_ORDER_COUNT];
+} sym_rows_data;
+
+typedef struct
+{
+    uint64_t key;
+    uint32_t sym_idx;
+} sym_sort_key;
+
+typedef struct
+{
+    const char *name;
+    uint32_t sym_idx;
+} sym_sort_name;
+
+char * efb_get_sym_type(const unsigned int sym_type)
+{
+    switch (sym_type)
+    {
+        case STT_NOTYPE:
+            return "NOTYPE";
+        case STT_OBJECT:
+            return "OBJECT";
+        case STT_FUNC:
+            return "FUNC";
+        case STT_SECTION:
+            return "SECTION";
+        case STT_FILE:
+            return "FILE";
+        case STT_COMMON:
+            return "COMMON";
+        case STT_TLS:
+            return "TLS";
+        case STT_GNU_IFUNC:
+            return "IFUNC";
+        default:
+            return "<unknown>";
+    }
+}
+
+char * efb_get_sym_bind(const unsigned int sym_bind)
+{
+    switch (sym_bind)
+    {
+        case STB_LOCAL:
+            return "LOCAL";
+        case STB_GLOBAL:
+            return "GLOBAL";
+        case STB_WEAK:
+            return "WEAK";
+        case STB_GNU_UNIQUE:
+            return "UNIQUE";
+        default:
+            return "<unknown>";
+    }
+}
+
+char * efb_get_sym_visibility(const unsigned int sym_visibility)
+{
+    switch (sym_visibility)
+    {
+        case STV_DEFAULT:
+            return "DEFAULT";
+        case STV_INTERNAL:
+            return "INTERNAL";
+        case STV_HIDDEN:
+            return "HIDDEN";
+        case STV_PROTECTED:
+            return "PROTECTED";
+        default:
+            return "<unknown>";
+    }
+}
+
+// 'xndx' is the symbol's entry in the SHT_SYMTAB_SHNDX section, which holds the section index when
+// st_shndx is SHN_XINDEX (in objects with more sections than fit in st_shndx)
+const char * efb_get_sym_sect_name(const efb_sect_table *sections, const GElf_Section shndx, const GElf_Word xndx)
+{
+    switch (shndx)
+    {
+        case SHN_UNDEF:
+            return "UND";
+        case SHN_ABS:
+            return "ABS";
+        case SHN_COMMON:
+            return "COM";
+        case SHN_XINDEX:
+            return ((xndx > 0) && (xndx < sections->count)) ? sections->name[xndx] : "XINDEX";
+        default:
+            return (shndx < sections->count) ? sections->name[shndx] : "<unknown>";
+    }
+}
+
+// Returns the SHT_SYMTAB_SHNDX data of the symbol table, or NULL if it has none
+Elf_Data * efb_get_sym_shndx_data(const efb_sect_table *sections, const size_t sym_sect_idx)
+{
+    for (size_t sect_idx = 1; sect_idx < sections->count; sect_idx++)
+    {
+        if ((sections->type[sect_idx] == SHT_SYMTAB_SHNDX) && (sections->link[sect_idx] == sym_sect_idx))
+        {
+            return efb_elf_getdata(sections->scn[sect_idx], NULL);
+        }
+    }
+
+    return NULL;
+}
+
+// Returns the symbol name, or "" if the offset is outside of the string table
+const char * efb_get_sym_name(const Elf_Data *str_data, const GElf_Word name_offset)
+{
+    if ((str_data == NULL) || (name_offset >= str_data->d_size))
+    {
+        return "";
+    }
+
+    const char *name = (const char *) str_data->d_buf + name_offset;
+
+    return (memchr(name, '\0', str_data->d_size - name_offset) != NULL) ? name : "";
+}
+
+static void get_symbol(const sym_rows_data *symbols, const size_t sym_idx, GElf_Sym *sym, GElf_Word *xndx)
+{
+    if (gelf_getsymshndx(symbols->sym_data, symbols->shndx_data, sym_idx, sym, xndx) != sym)
+    {
+        errx(EXIT_FAILURE, "gelf_getsymshndx() failed: %s.", elf_errmsg(-1));
+    }
+}
+
+static int compare_sort_keys(const void *left, const void *right)
+{
+    const sym_sort_key *left_key = left;
+    const sym_sort_key *right_key = right;
+
+    if (left_key->key != right_key->key)
+    {
+        return (left_key->key < right_key->key) ? -1 : 1;
+    }
+
+    return (left_key->sym_idx < right_key->sym_idx) ? -1 : (left_key->sym_idx > right_key->sym_idx);
+}
+
+static int compare_sort_names(const void *left, const void *right)
+{
+    const sym_sort_name *left_name = left;
+    const sym_sort_name *right_name = right;
+    int result = strcmp(left_name->name, right_name->name);
+
+    if (result != 0)
+    {
+        return result;
+    }
+
+    return (left_name->sym_idx < right_name->sym_idx) ? -1 : (left_name->sym_idx > right_name->sym_idx);
+}
+
+static uint32_t * build_order_perm(const sym_rows_data *symbols, const sym_order order)
+{
+    uint32_t *perm = malloc(symbols->sym_count * sizeof(uint32_t));
+
+    if (perm == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the symbol order for %zu symbols.", symbols->sym_count);
+    }
+
+    if (order == SYM_ORDER_NAME)
+    {
+        sym_sort_name *names = malloc(symbols->sym_count * sizeof(sym_sort_name));
+        if (names == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot sort %zu symbols.", symbols->sym_count);
+        }
+
+        for (size_t sym_idx = 0; sym_idx < symbols->sym_count; sym_idx++)
+        {
+            GElf_Sym sym;
+            GElf_Word xndx = 0;
+            get_symbol(symbols, sym_idx, &sym, &xndx);
+            names[sym_idx] = (sym_sort_name) { efb_get_sym_name(symbols->str_data, sym.st_name), sym_idx };
+        }
+
+        qsort(names, symbols->sym_count, sizeof(sym_sort_name), compare_sort_names);
+
+        for (size_t row_idx = 0; row_idx < symbols->sym_count; row_idx++)
+        {
+            perm[row_idx] = names[row_idx].sym_idx;
+        }
+
+        free(names);
+    }
+    else
+    {
+        sym_sort_key *keys = malloc(symbols->sym_count * sizeof(sym_sort_key));
+        if (keys == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot sort %zu symbols.", symbols->sym_count);
+        }
+
+        for (size_t sym_idx = 0; sym_idx < symbols->sym_count; sym_idx++)
+        {
+            GElf_Sym sym;
+            GElf_Word xndx = 0;
+            get_symbol(symbols, sym_idx, &sym, &xndx);
+            keys[sym_idx] = (sym_sort_key) { (order == SYM_ORDER_ADDRESS) ? sym.st_value : sym.st_size, sym_idx };
+        }
+
+        qsort(keys, symbols->sym_count, sizeof(sym_sort_key), compare_sort_keys);
+
+        for (size_t row_idx = 0; row_idx < symbols->sym_count; row_idx++)
+        {
+            perm[row_idx] = keys[row_idx].sym_idx;
+        }
+
+        free(keys);
+    }
+
+    return perm;
+}
+
+// Row 0 is the column heading, row N shows the (N - 1)th symbol of the current order
+static void render_sym_rows(const void *rows_data, const size_t first_row, const size_t row_count, efb_buffer * out_buffer)
+{
+    const sym_rows_data *symbols = rows_data;
+
+    for (size_t row_idx = first_row; row_idx < first_row + row_count; row_idx++)
+    {
+        if (row_idx == 0)
+        {
+            efb_buf_printf(out_buffer, "%7s  %-16s %8s %-7s %-6s %-9s %-16s %s  [sorted by %s]\n",
+                "Num:", "Value", "Size", "Type", "Bind", "Vis", "Section", "Name", sym_order_names[symbols->order]);
+            continue;
+        }
+
+        size_t sym_idx = row_idx - 1;
+        GElf_Sym sym;
+        GElf_Word xndx = 0;
+
+        if (symbols->order != SYM_ORDER_INDEX)
+        {
+            sym_idx = symbols->order_perm[symbols->order][sym_idx];
+        }
+
+        get_symbol(symbols, sym_idx, &sym, &xndx);
+
+        efb_buf_printf(out_buffer, "%6zu:  %016lx %8lu %-7s %-6s %-9s %-16.16s %s\n",
+            sym_idx, sym.st_value, sym.st_size,
+            efb_get_sym_type(GELF_ST_TYPE(sym.st_info)),
+            efb_get_sym_bind(GELF_ST_BIND(sym.st_info)),
+            efb_get_sym_visibility(GELF_ST_VISIBILITY(sym.st_other)),
+            efb_get_sym_sect_name(symbols->sections, sym.st_shndx, xndx),
+            efb_get_sym_name(symbols->str_data, sym.st_name));
+    }
+}
+
+// Switches to the next sort order; returns the size of its permutation if it has just been built
+static size_t sort_sym_rows(void *rows_data)
+{
+    sym_rows_data *symbols = rows_data;
+
+    symbols->order = (symbols->order + 1) % SYM_ORDER_COUNT;
+
+    if ((symbols->order != SYM_ORDER_INDEX) && (symbols->order_perm[symbols->order] == NULL))
+    {
+        symbols->order_perm[symbols->order] = build_order_perm(symbols, symbols->order);
+        return symbols->sym_count * sizeof(uint32_t);
+    }
+
+    return 0;
+}
+
+static bool locate_sym_row(const void *rows_data, const efb_locate_kind kind, const uint64_t value, size_t *row)
+{
+    const sym_rows_data *symbols = rows_data;
+    uint64_t sym_idx = value;
+
+    // An offset into the section locates the symbol whose entry contains it
+    if ((kind == EFB_LOCATE_OFFSET) && (symbols->sym_count > 0))
+    {
+        sym_idx = value / (symbols->sym_data->d_size / symbols->sym_count);
+    }
+    else if (kind != EFB_LOCATE_SYMBOL)
+    {
+        return false;
+    }
+
+    if (sym_idx >= symbols->sym_count)
+    {
+        return false;
+    }
+
+    if (symbols->order == SYM_ORDER_INDEX)
+    {
+        *row = sym_idx + 1;
+        return true;
+    }
+
+    const uint32_t *perm = symbols->order_perm[symbols->order];
+    for (size_t row_idx = 0; row_idx < symbols->sym_count; row_idx++)
+    {
+        if (perm[row_idx] == sym_idx)
+        {
+            *row = row_idx + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void release_sym_rows(void *rows_data)
+{
+    sym_rows_data *symbols = rows_data;
+
+    for (int order = 0; order < SYM_ORDER_COUNT; order++)
+    {
+        free(symbols->order_perm[order]);
+    }
+
+    free(symbols);
+}
+
+void efb_info_sect_symbols(const efb_file *file, Elf_Scn *sect, GElf_Shdr *sect_header, efb_view * view)
+{
+    const efb_sect_table *sections = &file->sections;
+    efb_buffer *out_buffer = &view->text;
+
+    efb_get_secthdr_struct(sect_header, out_buffer);
+
+    Elf_Data *sym_data = NULL;
+    if ((sym_data = efb_elf_getdata(sect, sym_data)) == NULL)
+    {
+        errx(EXIT_FAILURE, "elf_getdata() failed: %s.", elf_errmsg(-1));
+    }
+
+    efb_get_elf_data_struct(sym_data, out_buffer);
+
+    Elf_Data *str_data = NULL;
+    if ((sect_header->sh_link > 0) && (sect_header->sh_link < sections->count))
+    {
+        str_data = efb_elf_getdata(sections->scn[sect_header->sh_link], NULL);
+    }
+
+    sym_rows_data *symbols = calloc(1, sizeof(sym_rows_data));
+    if (symbols == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the symbol view.");
+    }
+
+    symbols->sym_data = sym_data;
+    symbols->str_data = str_data;
+    symbols->shndx_data = efb_get_sym_shndx_data(sections, elf_ndxscn(sect));
+    symbols->sections = sections;
+    symbols->sym_count = (sect_header->sh_entsize > 0) ? sym_data->d_size / sect_header->sh_entsize : 0;
+    symbols->order = SYM_ORDER_INDEX;
+
+    efb_view_add_rows(view, &(efb_row_source) {
+        .row_count = symbols->sym_count + 1,
+        .rows_data_size = sizeof(sym_rows_data),
+        .render_rows = render_sym_rows,
+        .sort_rows = sort_sym_rows,
+        .locate_row = locate_sym_row,
+        .release = release_sym_rows,
+        .rows_data = symbols,
+    });
+}
+
+// One row per symbol, written as it is read: the memory used does not depend on the number of symbols
+void efb_json_symbols(const efb_file *file, const int section_idx, efb_json_writer *writer)
+{
+    const efb_sect_table *sections = &file->sections;
+    Elf_Data *sym_data = efb_elf_getdata(sections->scn[section_idx], NULL);
+    Elf_Data *str_data = NULL;
+
+    if ((sym_data == NULL) || (sections->entsize[section_idx] == 0))
+    {
+        return;
+    }
+
+    if ((sections->link[section_idx] > 0) && (sections->link[section_idx] < sections->count))
+    {
+        str_data = efb_elf_getdata(sections->scn[sections->link[section_idx]], NULL);
+    }
+
+    Elf_Data *shndx_data = efb_get_sym_shndx_data(sections, section_idx);
+
+    efb_advise_sequential(file->sElf, sym_data->d_buf, sym_data->d_size);
+    efb_json_begin_table(writer, "symbols", "symbol", sections->name[section_idx]);
+
+    size_t sym_count = sym_data->d_size / sections->entsize[section_idx];
+    for (size_t sym_idx = 0; sym_idx < sym_count; sym_idx++)
+    {
+        GElf_Sym sym;
+        GElf_Word xndx = 0;
+        if (gelf_getsymshndx(sym_data, shndx_data, sym_idx, &sym, &xndx) != &sym)
+        {
+            errx(EXIT_FAILURE, "gelf_getsymshndx() failed: %s.", elf_errmsg(-1));
+        }
+
+        efb_json_begin_row(writer);
+        efb_json_uint(writer, "index", sym_idx);
+        efb_json_hex(writer, "value", sym.st_value);
+        efb_json_uint(writer, "size", sym.st_size);
+        efb_json_string(writer, "sym_type", efb_get_sym_type(GELF_ST_TYPE(sym.st_info)));
+        efb_json_string(writer, "bind", efb_get_sym_bind(GELF_ST_BIND(sym.st_info)));
+        efb_json_string(writer, "visibility", efb_get_sym_visibility(GELF_ST_VISIBILITY(sym.st_other)));
+        efb_json_string(writer, "ndx", efb_get_sym_sect_name(sections, sym.st_shndx, xndx));
+        efb_json_string(writer, "name", efb_get_sym_name(str_data, sym.st_name));
+        efb_json_end_row(writer);
+    }
+
+    efb_json_end_table(writer);
+}
@@ -0,0 +1,202 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define WATCH_EVENTS_SIZE 4096
+
+// The directory of the file is watched rather than the file: a linker may replace the file
+// (by unlinking it or renaming a new one over it) as well as rewrite it
+bool efb_watch_start(efb_file_watch *watch, const char *path)
+{
+    const char *name = strrchr(path, '/');
+    char *dir_path = (name == NULL) ? strdup(".") : (name == path) ? strdup("/") : strndup(path, name - path);
+
+    watch->name = strdup((name == NULL) ? path : name + 1);
+    if ((dir_path == NULL) || (watch->name == NULL))
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the file watch.");
+    }
+
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if ((watch->fd >= 0) && (inotify_add_watch(watch->fd, dir_path, IN_CLOSE_WRITE | IN_MOVED_TO) < 0))
+    {
+        close(watch->fd);
+        watch->fd = -1;
+    }
+
+    free(dir_path);
+    return watch->fd >= 0;
+}
+
+void efb_watch_stop(efb_file_watch *watch)
+{
+    if (watch->fd >= 0)
+    {
+        close(watch->fd);
+        watch->fd = -1;
+    }
+
+    free(watch->name);
+    watch->name = NULL;
+}
+
+// Reads all pending events; returns true if the file has been written or replaced since the last call.
+// Only finished writes are reported, so the file is not read while a linker is still writing it.
+bool efb_watch_changed(efb_file_watch *watch)
+{
+    char events[WATCH_EVENTS_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t length;
+
+    if (watch->fd < 0)
+    {
+        return false;
+    }
+
+    while (((length = read(watch->fd, events, sizeof(events))) > 0) || ((length < 0) && (errno == EINTR)))
+    {
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const struct inotify_event *event = (const struct inotify_event *) &events[offset];
+
+            if ((event->len > 0) && (strcmp(event->name, watch->name) == 0))
+            {
+                changed = true;
+            }
+
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return changed;
+}
+
+static void add_raw_region(const efb_file *file, const GElf_Off offset, const size_t size, efb_hash_region *region)
+{
+    *region = (efb_hash_region) { NULL, 0, NULL };
+
+    if ((file->image == NULL) || (offset > file->image_size) || (size > file->image_size - offset))
+    {
+        return;
+    }
+
+    region->data = &file->image[offset];
+    region->size = size;
+    region->block_hashes = malloc((efb_hash_block_count(size) + 1) * sizeof(uint64_t));
+    if (region->block_hashes == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the section hashes.");
+    }
+}
+
+static uint64_t get_region_hash(const efb_hash_region *region)
+{
+    return efb_hash64(region->block_hashes, (region->block_hashes != NULL) ? efb_hash_block_count(region->size) * sizeof(uint64_t) : 0,
+        region->size);
+}
+
+static void free_regions(efb_hash_region *regions, const size_t region_count)
+{
+    for (size_t region_idx = 0; region_idx < region_count; region_idx++)
+    {
+        free(regions[region_idx].block_hashes);
+    }
+
+    free(regions);
+}
+
+// Hashes the ELF and program headers and every section header: enough to open the file quickly, the
+// contents of the sections are hashed by efb_fingerprint_contents() when a reload needs them
+void efb_fingerprint_file(const efb_file *file, efb_file_fingerprint *print)
+{
+    const efb_sect_table *sections = &file->sections;
+    size_t sect_count = sections->count;
+    GElf_Ehdr elf_header;
+
+    efb_hash_region *regions = calloc(2, sizeof(efb_hash_region));
+    print->sect_header_hashes = malloc((sect_count + 1) * sizeof(uint64_t));
+    if ((regions == NULL) || (print->sect_header_hashes == NULL))
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the fingerprint of %zu sections.", sect_count);
+    }
+
+    print->sect_count = sect_count;
+    print->sect_data_hashes = NULL;
+
+    for (size_t sect_idx = 0; sect_idx < sect_count; sect_idx++)
+    {
+        uint64_t header_fields[] = {
+            efb_hash64(sections->name[sect_idx], strlen(sections->name[sect_idx]), 0), sections->type[sect_idx],
+            sections->flags[sect_idx], sections->addr[sect_idx], sections->offset[sect_idx], sections->size[sect_idx],
+            sections->link[sect_idx], sections->info[sect_idx], sections->addralign[sect_idx], sections->entsize[sect_idx]
+        };
+
+        print->sect_header_hashes[sect_idx] = efb_hash64(header_fields, sizeof(header_fields), 0);
+    }
+
+    if (gelf_getehdr(file->sElf, &elf_header) == &elf_header)
+    {
+        add_raw_region(file, 0, elf_header.e_ehsize, &regions[0]);
+        add_raw_region(file, elf_header.e_phoff, (size_t) elf_header.e_phnum * elf_header.e_phentsize, &regions[1]);
+    }
+
+    efb_hash_regions(regions, 2);
+
+    uint64_t header_hashes[] = { get_region_hash(&regions[0]), get_region_hash(&regions[1]) };
+    print->headers_hash = efb_hash64(header_hashes, sizeof(header_hashes), 0);
+
+    free_regions(regions, 2);
+}
+
+// Hashes the raw bytes of every section, once per fingerprint. The bytes are read from the mapped file,
+// not through libelf, sequentially and on all CPUs.
+void efb_fingerprint_contents(const efb_file *file, efb_file_fingerprint *print)
+{
+    const efb_sect_table *sections = &file->sections;
+    size_t sect_count = print->sect_count;
+
+    if (print->sect_data_hashes != NULL)
+    {
+        return;
+    }
+
+    efb_hash_region *regions = calloc(sect_count + 1, sizeof(efb_hash_region));
+    print->sect_data_hashes = malloc((sect_count + 1) * sizeof(uint64_t));
+    if ((regions == NULL) || (print->sect_data_hashes == NULL))
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the fingerprint of %zu sections.", sect_count);
+    }
+
+    for (size_t sect_idx = 0; sect_idx < sect_count; sect_idx++)
+    {
+        if (sections->type[sect_idx] != SHT_NOBITS)
+        {
+            add_raw_region(file, sections->offset[sect_idx], sections->size[sect_idx], &regions[sect_idx]);
+            efb_advise_sequential(file->sElf, regions[sect_idx].data, regions[sect_idx].size);
+        }
+    }
+
+    efb_hash_regions(regions, sect_count);
+
+    for (size_t sect_idx = 0; sect_idx < sect_count; sect_idx++)
+    {
+        print->sect_data_hashes[sect_idx] = get_region_hash(&regions[sect_idx]);
+    }
+
+    free_regions(regions, sect_count);
+}
+
+void efb_fingerprint_free(efb_file_fingerprint *print)
+{
+    free(print->sect_header_hashes);
+    free(print->sect_data_hashes);
+    print->sect_header_hashes = NULL;
+    print->sect_data_hashes = NULL;
+    print->sect_count = 0;
+}
@@ -0,0 +1,199 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_HASH_THREADS 16
+
+// The 64-bit xxHash (XXH64) algorithm: four independent lanes of 8 bytes, merged at the end
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl64(const uint64_t value, const int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read64(const unsigned char *data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read32(const unsigned char *data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint64_t hash_round(uint64_t acc, const uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t merge_round(uint64_t acc, const uint64_t lane)
+{
+    acc ^= hash_round(0, lane);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t efb_hash64(const void *data, const size_t size, const uint64_t seed)
+{
+    const unsigned char *ptr = data;
+    const unsigned char *end = ptr + size;
+    uint64_t hash;
+
+    if (size >= 32)
+    {
+        uint64_t lanes[4] = { seed + PRIME64_1 + PRIME64_2, seed + PRIME64_2, seed, seed - PRIME64_1 };
+
+        for (; ptr + 32 <= end; ptr += 32)
+        {
+            lanes[0] = hash_round(lanes[0], read64(ptr));
+            lanes[1] = hash_round(lanes[1], read64(ptr + 8));
+            lanes[2] = hash_round(lanes[2], read64(ptr + 16));
+            lanes[3] = hash_round(lanes[3], read64(ptr + 24));
+        }
+
+        hash = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            hash = merge_round(hash, lanes[lane]);
+        }
+    }
+    else
+    {
+        hash = seed + PRIME64_5;
+    }
+
+    hash += size;
+
+    for (; ptr + 8 <= end; ptr += 8)
+    {
+        hash ^= hash_round(0, read64(ptr));
+        hash = rotl64(hash, 27) * PRIME64_1 + PRIME64_4;
+    }
+
+    if (ptr + 4 <= end)
+    {
+        hash ^= read32(ptr) * PRIME64_1;
+        hash = rotl64(hash, 23) * PRIME64_2 + PRIME64_3;
+        ptr += 4;
+    }
+
+    for (; ptr < end; ptr++)
+    {
+        hash ^= *ptr * PRIME64_5;
+        hash = rotl64(hash, 11) * PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+typedef struct
+{
+    efb_hash_region *regions;
+    size_t *first_block;
+    size_t block_count;
+    atomic_size_t next_block;
+} hash_job;
+
+static void * hash_thread(void *arg)
+{
+    hash_job *job = arg;
+    size_t region_idx = 0;
+
+    for (;;)
+    {
+        size_t block = atomic_fetch_add(&job->next_block, 1);
+        if (block >= job->block_count)
+        {
+            break;
+        }
+
+        // The blocks are taken in increasing order, so the region only moves forward
+        while (block >= job->first_block[region_idx + 1])
+        {
+            region_idx++;
+        }
+
+        efb_hash_region *region = &job->regions[region_idx];
+        size_t region_block = block - job->first_block[region_idx];
+        size_t offset = region_block * EFB_HASH_BLOCK_SIZE;
+        size_t size = (region->size - offset < EFB_HASH_BLOCK_SIZE) ? region->size - offset : EFB_HASH_BLOCK_SIZE;
+
+        region->block_hashes[region_block] = efb_hash64(&region->data[offset], size, 0);
+    }
+
+    return NULL;
+}
+
+// Hashes every EFB_HASH_BLOCK_SIZE block of the regions into their block_hashes, which the caller
+// sizes with efb_hash_block_count(). The blocks of all regions are shared among the threads,
+// so one large section is hashed in parallel as well as many small ones.
+void efb_hash_regions(efb_hash_region *regions, const size_t region_count)
+{
+    hash_job job = { .regions = regions };
+
+    job.first_block = malloc((region_count + 1) * sizeof(size_t));
+    if (job.first_block == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the hash job.");
+    }
+
+    for (size_t region_idx = 0; region_idx < region_count; region_idx++)
+    {
+        job.first_block[region_idx] = job.block_count;
+        job.block_count += efb_hash_block_count(regions[region_idx].size);
+    }
+
+    job.first_block[region_count] = job.block_count;
+    atomic_init(&job.next_block, 0);
+
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t thread_count = (cpu_count > 0) ? (size_t) cpu_count : 1;
+    thread_count = (thread_count < MAX_HASH_THREADS) ? thread_count : MAX_HASH_THREADS;
+    thread_count = (thread_count < job.block_count) ? thread_count : 1;
+
+    pthread_t threads[MAX_HASH_THREADS];
+    size_t started_count = 0;
+    for (; started_count + 1 < thread_count; started_count++)
+    {
+        if (pthread_create(&threads[started_count], NULL, hash_thread, &job) != 0)
+        {
+            break;
+        }
+    }
+
+    hash_thread(&job);
+
+    for (size_t thread_idx = 0; thread_idx < started_count; thread_idx++)
+    {
+        pthread_join(threads[thread_idx], NULL);
+    }
+
+    free(job.first_block);
+}
+
+size_t efb_hash_block_count(const size_t size)
+{
+    return (size + EFB_HASH_BLOCK_SIZE - 1) / EFB_HASH_BLOCK_SIZE;
+}
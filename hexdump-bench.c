@@ -0,0 +1,124 @@
+// Microbenchmark of the hex dump row formatters: the scalar, SSE2 and AVX2 kernels and the sprintf
+// formatter they replaced. The kernels are static, so hexdump.c is compiled into this file.
+//
+// Usage: hexdump-bench [MB]   (default: 64 MB of pseudo-random data)
+
+#include "hexdump.c"
+
+#include <err.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_SIZE_MB 64
+#define BENCH_REPEAT_COUNT 5
+#define BENCH_ADDR_WIDTH 16
+
+// The row formatter of the section dump before the kernels, one sprintf per byte and one per row
+static void format_rows_sprintf(const unsigned char *data, const size_t row_count, const GElf_Addr addr, const int addr_width, char *out)
+{
+    char buf_hex[DUMP_HEX_WIDTH + 1];
+    char buf_char[DUMP_ROW_WIDTH + 1];
+
+    for (size_t row_idx = 0; row_idx < row_count; row_idx++)
+    {
+        size_t data_index = row_idx * DUMP_ROW_WIDTH;
+        size_t buf_hex_index = 0;
+
+        for (size_t byte_idx = 0; byte_idx < DUMP_ROW_WIDTH; byte_idx++)
+        {
+            unsigned char data_byte = data[data_index + byte_idx];
+
+            buf_hex_index += sprintf(&buf_hex[buf_hex_index], "%02x", data_byte);
+            buf_char[byte_idx] = (data_byte < ' ' || data_byte > '~') ? '.' : data_byte;
+            if (((byte_idx + 1) % DUMP_COL_WIDTH) == 0)
+            {
+                buf_hex[buf_hex_index++] = ' ';
+            }
+        }
+
+        buf_hex[buf_hex_index] = '\0';
+        buf_char[DUMP_ROW_WIDTH] = '\0';
+
+        out += sprintf(out, "  0x%0*lx %*s%s\n", addr_width, (unsigned long) (addr + data_index), -DUMP_HEX_WIDTH, buf_hex, buf_char);
+    }
+}
+
+static double get_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Prints the best of BENCH_REPEAT_COUNT runs as GB/s of input; the output is compared with 'expected'
+static void run_kernel(const char *name, const format_rows_fn format_rows, const unsigned char *data, const size_t row_count,
+    char *out, const char *expected, const size_t out_size)
+{
+    double best_time = 0;
+
+    for (int repeat_idx = 0; repeat_idx < BENCH_REPEAT_COUNT; repeat_idx++)
+    {
+        double start_time = get_seconds();
+        format_rows(data, row_count, 0x400000, BENCH_ADDR_WIDTH, out);
+        double run_time = get_seconds() - start_time;
+
+        if ((repeat_idx == 0) || (run_time < best_time))
+        {
+            best_time = run_time;
+        }
+    }
+
+    printf("%-8s %8.3f GB/s  %8.1f ms%s\n", name, row_count * DUMP_ROW_WIDTH / best_time / 1e9, best_time * 1e3,
+        ((expected == NULL) || (memcmp(out, expected, out_size) == 0)) ? "" : "  (output differs from scalar)");
+}
+
+int main(int argc, char **argv)
+{
+    size_t size_mb = (argc > 1) ? strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_SIZE_MB;
+    size_t row_count = (size_mb << 20) / DUMP_ROW_WIDTH;
+    size_t out_size = row_count * (DUMP_ADDR_PREFIX_SIZE + BENCH_ADDR_WIDTH + 1 + DUMP_ROW_BODY_SIZE);
+    unsigned char *data = malloc(row_count * DUMP_ROW_WIDTH);
+    char *expected = malloc(out_size + 1);
+    char *out = malloc(out_size + 1);
+    uint64_t state = 0x9e3779b97f4a7c15;
+
+    if ((row_count == 0) || (data == NULL) || (expected == NULL) || (out == NULL))
+    {
+        errx(EXIT_FAILURE, "Cannot allocate %zu MB of benchmark data.", size_mb);
+    }
+
+    // xorshift64: every byte value, printable or not, occurs
+    for (size_t byte_idx = 0; byte_idx < row_count * DUMP_ROW_WIDTH; byte_idx++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        data[byte_idx] = (unsigned char) state;
+    }
+
+    printf("%zu MB, %zu rows, best of %d runs\n", size_mb, row_count, BENCH_REPEAT_COUNT);
+
+    run_kernel("sprintf", format_rows_sprintf, data, row_count, out, NULL, out_size);
+    run_kernel("scalar", format_rows_scalar, data, row_count, expected, NULL, out_size);
+
+#ifdef HEX_DUMP_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2"))
+    {
+        run_kernel("sse2", format_rows_sse2, data, row_count, out, expected, out_size);
+    }
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        run_kernel("avx2", format_rows_avx2, data, row_count, out, expected, out_size);
+    }
+#endif
+
+    free(data);
+    free(expected);
+    free(out);
+    return EXIT_SUCCESS;
+}
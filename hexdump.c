@@ -0,0 +1,222 @@
+#include "elfibia.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEX_DUMP_X86
+#endif
+
+#define DUMP_ROW_WIDTH EFB_DUMP_ROW_WIDTH
+#define DUMP_COL_WIDTH 4
+#define DUMP_HEX_WIDTH (2 * DUMP_ROW_WIDTH + DUMP_ROW_WIDTH / DUMP_COL_WIDTH + 1)
+#define DUMP_ADDR_PREFIX "  0x"
+#define DUMP_ADDR_PREFIX_SIZE (sizeof(DUMP_ADDR_PREFIX) - 1)
+
+// Size of a complete row without the address: hex column, char column and '\n'
+#define DUMP_ROW_BODY_SIZE (DUMP_HEX_WIDTH + DUMP_ROW_WIDTH + 1)
+
+static const char hex_digits[] = "0123456789abcdef";
+
+typedef void (*format_rows_fn)(const unsigned char *data, const size_t row_count, const GElf_Addr addr, const int addr_width, char *out);
+
+static char * format_row_address(GElf_Addr addr, const int addr_width, char *out)
+{
+    memcpy(out, DUMP_ADDR_PREFIX, DUMP_ADDR_PREFIX_SIZE);
+    out += DUMP_ADDR_PREFIX_SIZE;
+
+    for (int digit_idx = addr_width - 1; digit_idx >= 0; digit_idx--)
+    {
+        out[digit_idx] = hex_digits[addr & 0xf];
+        addr >>= 4;
+    }
+
+    out[addr_width] = ' ';
+    return out + addr_width + 1;
+}
+
+// Formats a row of up to DUMP_ROW_WIDTH bytes, the hex column is padded for a partial row
+static char * format_row_scalar(const unsigned char *data, const size_t row_size, char *out)
+{
+    char *out_char = out + DUMP_HEX_WIDTH;
+
+    memset(out, ' ', DUMP_HEX_WIDTH);
+
+    for (size_t byte_idx = 0; byte_idx < row_size; byte_idx++)
+    {
+        unsigned char data_byte = data[byte_idx];
+
+        out[0] = hex_digits[data_byte >> 4];
+        out[1] = hex_digits[data_byte & 0xf];
+        out += ((byte_idx + 1) % DUMP_COL_WIDTH == 0) ? 3 : 2;
+        *out_char++ = (data_byte < ' ' || data_byte > '~') ? '.' : data_byte;
+    }
+
+    *out_char++ = '\n';
+    return out_char;
+}
+
+static void format_rows_scalar(const unsigned char *data, const size_t row_count, const GElf_Addr addr, const int addr_width, char *out)
+{
+    for (size_t row_idx = 0; row_idx < row_count; row_idx++)
+    {
+        out = format_row_address(addr + row_idx * DUMP_ROW_WIDTH, addr_width, out);
+        out = format_row_scalar(&data[row_idx * DUMP_ROW_WIDTH], DUMP_ROW_WIDTH, out);
+    }
+}
+
+#ifdef HEX_DUMP_X86
+
+// 'hex_lo' holds the hex digits of the first 8 bytes of the row, 'hex_hi' those of the last 8 bytes
+__attribute__((target("sse2")))
+static inline char * store_row_sse2(const __m128i hex_lo, const __m128i hex_hi, const __m128i chars, char *out)
+{
+    _mm_storel_epi64((__m128i *) &out[0], hex_lo);
+    out[8] = ' ';
+    _mm_storel_epi64((__m128i *) &out[9], _mm_srli_si128(hex_lo, 8));
+    out[17] = ' ';
+    _mm_storel_epi64((__m128i *) &out[18], hex_hi);
+    out[26] = ' ';
+    _mm_storel_epi64((__m128i *) &out[27], _mm_srli_si128(hex_hi, 8));
+    out[35] = ' ';
+    out[36] = ' ';
+    _mm_storeu_si128((__m128i *) &out[DUMP_HEX_WIDTH], chars);
+    out[DUMP_HEX_WIDTH + DUMP_ROW_WIDTH] = '\n';
+
+    return out + DUMP_ROW_BODY_SIZE;
+}
+
+__attribute__((target("sse2")))
+static inline __m128i nibbles_to_hex_sse2(const __m128i nibbles)
+{
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i printable_chars_sse2(const __m128i bytes)
+{
+    // Signed compares: bytes >= 0x80 are negative and therefore not printable
+    __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(' ' - 1)), _mm_cmplt_epi8(bytes, _mm_set1_epi8('~' + 1)));
+
+    return _mm_or_si128(_mm_and_si128(printable, bytes), _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+}
+
+__attribute__((target("sse2")))
+static void format_rows_sse2(const unsigned char *data, const size_t row_count, const GElf_Addr addr, const int addr_width, char *out)
+{
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+
+    for (size_t row_idx = 0; row_idx < row_count; row_idx++)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) &data[row_idx * DUMP_ROW_WIDTH]);
+        __m128i hi = nibbles_to_hex_sse2(_mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble));
+        __m128i lo = nibbles_to_hex_sse2(_mm_and_si128(bytes, low_nibble));
+
+        out = format_row_address(addr + row_idx * DUMP_ROW_WIDTH, addr_width, out);
+        out = store_row_sse2(_mm_unpacklo_epi8(hi, lo), _mm_unpackhi_epi8(hi, lo), printable_chars_sse2(bytes), out);
+    }
+}
+
+__attribute__((target("avx2")))
+static void format_rows_avx2(const unsigned char *data, const size_t row_count, const GElf_Addr addr, const int addr_width, char *out)
+{
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    size_t row_idx = 0;
+
+    // Two rows per iteration, one in each 128-bit lane
+    for (; row_idx + 2 <= row_count; row_idx += 2)
+    {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *) &data[row_idx * DUMP_ROW_WIDTH]);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), low_nibble);
+        __m256i lo = _mm256_and_si256(bytes, low_nibble);
+
+        hi = _mm256_add_epi8(_mm256_add_epi8(hi, _mm256_set1_epi8('0')),
+            _mm256_and_si256(_mm256_cmpgt_epi8(hi, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10)));
+        lo = _mm256_add_epi8(_mm256_add_epi8(lo, _mm256_set1_epi8('0')),
+            _mm256_and_si256(_mm256_cmpgt_epi8(lo, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10)));
+
+        __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(' ' - 1)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8('~' + 1), bytes));
+        __m256i chars = _mm256_blendv_epi8(_mm256_set1_epi8('.'), bytes, printable);
+
+        // The unpacks work per lane, so each lane holds the hex digits of its own row
+        __m256i hex_lo = _mm256_unpacklo_epi8(hi, lo);
+        __m256i hex_hi = _mm256_unpackhi_epi8(hi, lo);
+
+        out = format_row_address(addr + row_idx * DUMP_ROW_WIDTH, addr_width, out);
+        out = store_row_sse2(_mm256_castsi256_si128(hex_lo), _mm256_castsi256_si128(hex_hi), _mm256_castsi256_si128(chars), out);
+        out = format_row_address(addr + (row_idx + 1) * DUMP_ROW_WIDTH, addr_width, out);
+        out = store_row_sse2(_mm256_extracti128_si256(hex_lo, 1), _mm256_extracti128_si256(hex_hi, 1), _mm256_extracti128_si256(chars, 1), out);
+    }
+
+    if (row_idx < row_count)
+    {
+        format_rows_sse2(&data[row_idx * DUMP_ROW_WIDTH], row_count - row_idx, addr + row_idx * DUMP_ROW_WIDTH, addr_width, out);
+    }
+}
+
+#endif // HEX_DUMP_X86
+
+static format_rows_fn select_format_rows(void)
+{
+#ifdef HEX_DUMP_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return format_rows_avx2;
+    }
+
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return format_rows_sse2;
+    }
+#endif
+
+    return format_rows_scalar;
+}
+
+// Appends the rows [first_row, first_row + row_count) of the dump of 'data';
+// 'addr_width' is the number of hex digits of the addresses (8 for ELF32, 16 for ELF64)
+void efb_hex_dump_rows(const unsigned char *data, const size_t size, const GElf_Addr addr, const int addr_width,
+    const size_t first_row, const size_t row_count, efb_buffer *out_buffer)
+{
+    static format_rows_fn format_rows = NULL;
+
+    if (format_rows == NULL)
+    {
+        format_rows = select_format_rows();
+    }
+
+    size_t row_size = DUMP_ADDR_PREFIX_SIZE + addr_width + 1 + DUMP_ROW_BODY_SIZE;
+    size_t data_offset = first_row * DUMP_ROW_WIDTH;
+    size_t full_rows = 0;
+
+    if (data_offset >= size)
+    {
+        return;
+    }
+
+    full_rows = (size - data_offset) / DUMP_ROW_WIDTH;
+    if (full_rows > row_count)
+    {
+        full_rows = row_count;
+    }
+
+    efb_buf_reserve(out_buffer, (full_rows + 1) * row_size);
+
+    char *out = &out_buffer->data[out_buffer->length];
+    format_rows(&data[data_offset], full_rows, addr + data_offset, addr_width, out);
+    out += full_rows * row_size;
+    data_offset += full_rows * DUMP_ROW_WIDTH;
+
+    if ((full_rows < row_count) && (data_offset < size))
+    {
+        out = format_row_address(addr + data_offset, addr_width, out);
+        out = format_row_scalar(&data[data_offset], size - data_offset, out);
+    }
+
+    efb_buf_commit(out_buffer, out - out_buffer->data);
+}
@@ -0,0 +1,267 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The output is written out whenever this much has been formatted, so memory use does not grow with the output
+#define JSON_FLUSH_SIZE (64 * 1024)
+
+static const char hex_digits[] = "0123456789abcdef";
+
+void efb_json_init(efb_json_writer *writer, FILE *stream, const bool ndjson)
+{
+    writer->stream = stream;
+    writer->ndjson = ndjson;
+    writer->depth = 0;
+    writer->has_items[0] = false;
+    writer->record_closed = false;
+    writer->table_type = NULL;
+    writer->table_section = NULL;
+    efb_buf_init(&writer->out);
+
+    // A JSON document is an array of the records, NDJSON has one record per line
+    if (ndjson == false)
+    {
+        efb_buf_putc(&writer->out, '[');
+    }
+}
+
+static void flush_output(efb_json_writer *writer, const bool force)
+{
+    if ((force || (writer->out.length >= JSON_FLUSH_SIZE)) && (writer->out.length > 0))
+    {
+        if (fwrite(writer->out.data, 1, writer->out.length, writer->stream) != writer->out.length)
+        {
+            errx(EXIT_FAILURE, "Cannot write the output.");
+        }
+
+        efb_buf_reset(&writer->out);
+    }
+}
+
+void efb_json_finish(efb_json_writer *writer)
+{
+    if (writer->ndjson == false)
+    {
+        efb_buf_printf(&writer->out, "\n]\n");
+    }
+
+    flush_output(writer, true);
+    efb_buf_free(&writer->out);
+}
+
+static void write_string(efb_buffer *out, const char *str)
+{
+    efb_buf_putc(out, '"');
+
+    while (*str != '\0')
+    {
+        // Copies the run which needs no escaping in one go
+        size_t run = strcspn(str, "\"\\\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+            "\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f");
+        efb_buf_append(out, str, run);
+        str += run;
+
+        if (*str == '\0')
+        {
+            break;
+        }
+
+        unsigned char ch = (unsigned char) *str++;
+        if ((ch == '"') || (ch == '\\'))
+        {
+            efb_buf_putc(out, '\\');
+            efb_buf_putc(out, (char) ch);
+        }
+        else
+        {
+            efb_buf_printf(out, "\\u00%c%c", hex_digits[ch >> 4], hex_digits[ch & 0xf]);
+        }
+    }
+
+    efb_buf_putc(out, '"');
+}
+
+// Writes the separator and the key (if the value is a member of an object)
+static void write_key(efb_json_writer *writer, const char *key)
+{
+    if (writer->has_items[writer->depth])
+    {
+        efb_buf_putc(&writer->out, ',');
+    }
+
+    writer->has_items[writer->depth] = true;
+
+    if (key != NULL)
+    {
+        write_string(&writer->out, key);
+        efb_buf_putc(&writer->out, ':');
+    }
+}
+
+static void open_container(efb_json_writer *writer, const char *key, const char bracket)
+{
+    if (writer->depth + 1 >= EFB_JSON_MAX_DEPTH)
+    {
+        errx(EXIT_FAILURE, "The JSON output is nested too deep.");
+    }
+
+    write_key(writer, key);
+    efb_buf_putc(&writer->out, bracket);
+    writer->has_items[++writer->depth] = false;
+}
+
+static void close_container(efb_json_writer *writer, const char bracket)
+{
+    writer->depth--;
+    efb_buf_putc(&writer->out, bracket);
+}
+
+void efb_json_begin_object(efb_json_writer *writer, const char *key)
+{
+    open_container(writer, key, '{');
+}
+
+void efb_json_end_object(efb_json_writer *writer)
+{
+    close_container(writer, '}');
+}
+
+void efb_json_begin_array(efb_json_writer *writer, const char *key)
+{
+    open_container(writer, key, '[');
+}
+
+void efb_json_end_array(efb_json_writer *writer)
+{
+    close_container(writer, ']');
+}
+
+void efb_json_string(efb_json_writer *writer, const char *key, const char *value)
+{
+    write_key(writer, key);
+
+    if (value != NULL)
+    {
+        write_string(&writer->out, value);
+    }
+    else
+    {
+        efb_buf_append(&writer->out, "null", 4);
+    }
+}
+
+void efb_json_uint(efb_json_writer *writer, const char *key, const uint64_t value)
+{
+    write_key(writer, key);
+    efb_buf_printf(&writer->out, "%lu", value);
+}
+
+void efb_json_int(efb_json_writer *writer, const char *key, const int64_t value)
+{
+    write_key(writer, key);
+    efb_buf_printf(&writer->out, "%ld", value);
+}
+
+// Addresses are strings: JSON readers often hold numbers as doubles, which lose the low bits of 64-bit values
+void efb_json_hex(efb_json_writer *writer, const char *key, const uint64_t value)
+{
+    write_key(writer, key);
+    efb_buf_printf(&writer->out, "\"0x%lx\"", value);
+}
+
+void efb_json_bool(efb_json_writer *writer, const char *key, const bool value)
+{
+    write_key(writer, key);
+    efb_buf_printf(&writer->out, "%s", value ? "true" : "false");
+}
+
+// A record is a top level object: an element of the document array, or one NDJSON line
+void efb_json_begin_record(efb_json_writer *writer, const char *type)
+{
+    if (writer->ndjson == false)
+    {
+        efb_buf_printf(&writer->out, writer->has_items[0] ? ",\n" : "\n");
+    }
+
+    writer->has_items[0] = false;
+    writer->record_closed = false;
+    efb_json_begin_object(writer, NULL);
+    efb_json_string(writer, "type", type);
+}
+
+void efb_json_end_record(efb_json_writer *writer)
+{
+    if (writer->record_closed == false)
+    {
+        efb_json_end_object(writer);
+
+        if (writer->ndjson)
+        {
+            efb_buf_putc(&writer->out, '\n');
+        }
+    }
+
+    writer->has_items[0] = true;
+    writer->record_closed = true;
+    flush_output(writer, false);
+}
+
+// The rows of a large table (symbols, strings, dynamic entries) are an array of the record in JSON;
+// in NDJSON the record ends here and every row becomes a record of its own, tagged with the section.
+// A table is therefore the last member of its record.
+void efb_json_begin_table(efb_json_writer *writer, const char *key, const char *row_type, const char *section_name)
+{
+    writer->table_type = row_type;
+    writer->table_section = section_name;
+
+    if (writer->ndjson)
+    {
+        efb_json_end_record(writer);
+    }
+    else
+    {
+        efb_json_begin_array(writer, key);
+    }
+}
+
+void efb_json_end_table(efb_json_writer *writer)
+{
+    if (writer->ndjson == false)
+    {
+        efb_json_end_array(writer);
+    }
+
+    writer->table_type = NULL;
+    writer->table_section = NULL;
+}
+
+void efb_json_begin_row(efb_json_writer *writer)
+{
+    if (writer->ndjson)
+    {
+        efb_json_begin_record(writer, writer->table_type);
+        if (writer->table_section != NULL)
+        {
+            efb_json_string(writer, "section", writer->table_section);
+        }
+    }
+    else
+    {
+        efb_json_begin_object(writer, NULL);
+    }
+}
+
+void efb_json_end_row(efb_json_writer *writer)
+{
+    if (writer->ndjson)
+    {
+        efb_json_end_record(writer);
+    }
+    else
+    {
+        efb_json_end_object(writer);
+        flush_output(writer, false);
+    }
+}
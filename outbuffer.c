@@ -0,0 +1,187 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OUT_BUFFER_INITIAL_CAPACITY 4096
+#define OUT_BUFFER_INITIAL_LINES 256
+
+// Records the lines ended by the text written after 'from'; the text is still in the cache
+static void index_new_lines(efb_buffer *buf, size_t from)
+{
+    if (buf->line_ends == NULL)
+    {
+        return;
+    }
+
+    const char *line_end;
+    while ((line_end = memchr(&buf->data[from], '\n', buf->length - from)) != NULL)
+    {
+        if (buf->line_count == buf->line_capacity)
+        {
+            buf->line_capacity *= 2;
+            buf->line_ends = realloc(buf->line_ends, buf->line_capacity * sizeof(size_t));
+            if (buf->line_ends == NULL)
+            {
+                errx(EXIT_FAILURE, "Cannot grow the line index of the output buffer to %zu lines.", buf->line_capacity);
+            }
+        }
+
+        from = (size_t) (line_end - buf->data) + 1;
+        buf->line_ends[buf->line_count++] = from;
+    }
+}
+
+void efb_buf_init(efb_buffer *buf)
+{
+    buf->length = 0;
+    buf->capacity = OUT_BUFFER_INITIAL_CAPACITY;
+
+    if ((buf->data = malloc(buf->capacity)) == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate %zu bytes for the output buffer.", buf->capacity);
+    }
+
+    buf->data[0] = '\0';
+    buf->line_ends = NULL;
+    buf->line_count = 0;
+    buf->line_capacity = 0;
+}
+
+// Makes the buffer keep the offsets of its lines, e.g. for the rows of a view
+void efb_buf_index_lines(efb_buffer *buf)
+{
+    if (buf->line_ends != NULL)
+    {
+        return;
+    }
+
+    buf->line_capacity = OUT_BUFFER_INITIAL_LINES;
+    if ((buf->line_ends = malloc(buf->line_capacity * sizeof(size_t))) == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the line index of the output buffer.");
+    }
+
+    buf->line_count = 0;
+    index_new_lines(buf, 0);
+}
+
+void efb_buf_free(efb_buffer *buf)
+{
+    free(buf->data);
+    free(buf->line_ends);
+    buf->data = NULL;
+    buf->length = 0;
+    buf->capacity = 0;
+    buf->line_ends = NULL;
+    buf->line_count = 0;
+    buf->line_capacity = 0;
+}
+
+void efb_buf_reset(efb_buffer *buf)
+{
+    buf->length = 0;
+    buf->data[0] = '\0';
+    buf->line_count = 0;
+}
+
+// Makes room for 'extra' more characters plus the terminating '\0'.
+// The capacity grows geometrically, so a sequence of appends is linear in the output size.
+void efb_buf_reserve(efb_buffer *buf, const size_t extra)
+{
+    size_t required = buf->length + extra + 1;
+
+    if (required <= buf->capacity)
+    {
+        return;
+    }
+
+    size_t new_capacity = buf->capacity * 2;
+    if (new_capacity < required)
+    {
+        new_capacity = required;
+    }
+
+    char *new_data = realloc(buf->data, new_capacity);
+    if (new_data == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot grow the output buffer to %zu bytes.", new_capacity);
+    }
+
+    buf->data = new_data;
+    buf->capacity = new_capacity;
+}
+
+// Takes the text written directly into the reserved space, up to 'length', into the buffer
+void efb_buf_commit(efb_buffer *buf, const size_t length)
+{
+    size_t from = buf->length;
+
+    buf->length = length;
+    buf->data[buf->length] = '\0';
+    index_new_lines(buf, from);
+}
+
+// Drops the text after 'length', with the lines it ended
+void efb_buf_truncate(efb_buffer *buf, const size_t length)
+{
+    buf->length = length;
+    buf->data[buf->length] = '\0';
+
+    while ((buf->line_count > 0) && (buf->line_ends[buf->line_count - 1] > length))
+    {
+        buf->line_count--;
+    }
+}
+
+void efb_buf_append(efb_buffer *buf, const char *str, const size_t len)
+{
+    size_t from = buf->length;
+
+    efb_buf_reserve(buf, len);
+    memcpy(&buf->data[buf->length], str, len);
+    buf->length += len;
+    buf->data[buf->length] = '\0';
+    index_new_lines(buf, from);
+}
+
+void efb_buf_putc(efb_buffer *buf, const char ch)
+{
+    efb_buf_reserve(buf, 1);
+    buf->data[buf->length++] = ch;
+    buf->data[buf->length] = '\0';
+
+    if ((ch == '\n') && (buf->line_ends != NULL))
+    {
+        index_new_lines(buf, buf->length - 1);
+    }
+}
+
+void efb_buf_printf(efb_buffer *buf, const char *format, ...)
+{
+    va_list args;
+    size_t available = buf->capacity - buf->length;
+
+    va_start(args, format);
+    int written = vsnprintf(&buf->data[buf->length], available, format, args);
+    va_end(args);
+
+    if (written < 0)
+    {
+        errx(EXIT_FAILURE, "Cannot format the output for \"%s\".", format);
+    }
+
+    if ((size_t) written >= available)
+    {
+        efb_buf_reserve(buf, written);
+
+        va_start(args, format);
+        vsnprintf(&buf->data[buf->length], buf->capacity - buf->length, format, args);
+        va_end(args);
+    }
+
+    buf->length += written;
+    index_new_lines(buf, buf->length - written);
+}
@@ -0,0 +1,411 @@
+#include "elfibia.h"
+
+#include <ctype.h>
+#include <err.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PATTERN_SEARCH_X86
+#endif
+
+// Sections are scanned in chunks of this size, so a large section is split across the threads
+#define SCAN_CHUNK_SIZE ((size_t) 4 << 20)
+#define MAX_SCAN_THREADS 16
+
+typedef struct
+{
+    uint64_t *offsets;
+    size_t count;
+    size_t capacity;
+} chunk_matches;
+
+typedef struct
+{
+    uint32_t sect_idx;
+    const unsigned char *data;
+    size_t scan_size;
+    size_t data_size;
+    uint64_t offset;
+    bool complete;
+    chunk_matches matches;
+} scan_chunk;
+
+typedef struct scan_job scan_job;
+
+// Scans the positions [0, scan_size) of the chunk; false if the job has found enough matches
+typedef bool (*scan_fn)(scan_job *job, scan_chunk *chunk);
+
+struct scan_job
+{
+    scan_fn scan;
+    const unsigned char *pattern;
+    size_t pattern_len;
+    size_t max_matches;
+    scan_chunk *chunks;
+    size_t chunk_count;
+    atomic_size_t next_chunk;
+    atomic_size_t match_count;
+    atomic_size_t done_count;
+    atomic_bool cancelled;
+};
+
+static bool add_match(scan_job *job, chunk_matches *matches, const uint64_t offset)
+{
+    if (atomic_fetch_add(&job->match_count, 1) >= job->max_matches)
+    {
+        return false;
+    }
+
+    if (matches->count == matches->capacity)
+    {
+        matches->capacity = (matches->capacity > 0) ? 2 * matches->capacity : 64;
+        matches->offsets = realloc(matches->offsets, matches->capacity * sizeof(uint64_t));
+        if (matches->offsets == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot allocate the pattern search results.");
+        }
+    }
+
+    matches->offsets[matches->count++] = offset;
+    return true;
+}
+
+static bool scan_scalar(scan_job *job, scan_chunk *chunk, size_t pos)
+{
+    const unsigned char *pattern = job->pattern;
+    size_t pattern_len = job->pattern_len;
+
+    while ((pos < chunk->scan_size) && (pos + pattern_len <= chunk->data_size))
+    {
+        const unsigned char *found = memchr(&chunk->data[pos], pattern[0], chunk->scan_size - pos);
+        if (found == NULL)
+        {
+            break;
+        }
+
+        pos = found - chunk->data;
+        if ((pos + pattern_len <= chunk->data_size) && (memcmp(found, pattern, pattern_len) == 0)
+            && (add_match(job, &chunk->matches, chunk->offset + pos) == false))
+        {
+            return false;
+        }
+
+        pos++;
+    }
+
+    return true;
+}
+
+static bool scan_chunk_scalar(scan_job *job, scan_chunk *chunk)
+{
+    return scan_scalar(job, chunk, 0);
+}
+
+#ifdef PATTERN_SEARCH_X86
+
+// Compares the first and the last byte of the pattern at 16 (SSE2) or 32 (AVX2) positions at once
+// and checks the rest of the pattern only at the positions where both match
+
+static inline bool verify_candidates(scan_job *job, scan_chunk *chunk, const size_t pos, unsigned int mask)
+{
+    while (mask != 0)
+    {
+        size_t candidate = pos + __builtin_ctz(mask);
+
+        if ((candidate < chunk->scan_size)
+            && (memcmp(&chunk->data[candidate + 1], &job->pattern[1], job->pattern_len - 1) == 0)
+            && (add_match(job, &chunk->matches, chunk->offset + candidate) == false))
+        {
+            return false;
+        }
+
+        mask &= mask - 1;
+    }
+
+    return true;
+}
+
+__attribute__((target("sse2")))
+static bool scan_chunk_sse2(scan_job *job, scan_chunk *chunk)
+{
+    const __m128i first = _mm_set1_epi8((char) job->pattern[0]);
+    const __m128i last = _mm_set1_epi8((char) job->pattern[job->pattern_len - 1]);
+    size_t last_offset = job->pattern_len - 1;
+    size_t pos = 0;
+
+    for (; (pos < chunk->scan_size) && (pos + last_offset + 16 <= chunk->data_size); pos += 16)
+    {
+        __m128i block_first = _mm_loadu_si128((const __m128i *) &chunk->data[pos]);
+        __m128i block_last = _mm_loadu_si128((const __m128i *) &chunk->data[pos + last_offset]);
+        unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+
+        if ((mask != 0) && (verify_candidates(job, chunk, pos, mask) == false))
+        {
+            return false;
+        }
+    }
+
+    return scan_scalar(job, chunk, pos);
+}
+
+__attribute__((target("avx2")))
+static bool scan_chunk_avx2(scan_job *job, scan_chunk *chunk)
+{
+    const __m256i first = _mm256_set1_epi8((char) job->pattern[0]);
+    const __m256i last = _mm256_set1_epi8((char) job->pattern[job->pattern_len - 1]);
+    size_t last_offset = job->pattern_len - 1;
+    size_t pos = 0;
+
+    for (; (pos < chunk->scan_size) && (pos + last_offset + 32 <= chunk->data_size); pos += 32)
+    {
+        __m256i block_first = _mm256_loadu_si256((const __m256i *) &chunk->data[pos]);
+        __m256i block_last = _mm256_loadu_si256((const __m256i *) &chunk->data[pos + last_offset]);
+        unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+            _mm256_cmpeq_epi8(last, block_last)));
+
+        if ((mask != 0) && (verify_candidates(job, chunk, pos, mask) == false))
+        {
+            return false;
+        }
+    }
+
+    return scan_scalar(job, chunk, pos);
+}
+
+#endif // PATTERN_SEARCH_X86
+
+static scan_fn select_scan(void)
+{
+#ifdef PATTERN_SEARCH_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return scan_chunk_avx2;
+    }
+
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return scan_chunk_sse2;
+    }
+#endif
+
+    return scan_chunk_scalar;
+}
+
+// Only the calling thread reports the progress, it is the render thread which runs the search
+static void scan_chunks(scan_job *job, const bool reports_progress)
+{
+    for (;;)
+    {
+        size_t chunk_idx = atomic_fetch_add(&job->next_chunk, 1);
+
+        if ((chunk_idx >= job->chunk_count) || (atomic_load(&job->match_count) >= job->max_matches) || atomic_load(&job->cancelled))
+        {
+            break;
+        }
+
+        job->chunks[chunk_idx].complete = job->scan(job, &job->chunks[chunk_idx]);
+
+        size_t done_count = atomic_fetch_add(&job->done_count, 1) + 1;
+        if (reports_progress && (efb_render_step(done_count, job->chunk_count) == false))
+        {
+            atomic_store(&job->cancelled, true);
+        }
+    }
+}
+
+static void * scan_thread(void *arg)
+{
+    scan_chunks(arg, false);
+    return NULL;
+}
+
+// Splits the data of all sections into chunks; the bytes a match may need past its chunk are scanned along with it
+static size_t collect_chunks(const efb_file *file, const size_t pattern_len, scan_chunk *chunks)
+{
+    const efb_sect_table *sections = &file->sections;
+    size_t chunk_count = 0;
+
+    for (size_t sect_idx = 1; sect_idx < sections->count; sect_idx++)
+    {
+        if ((sections->type[sect_idx] == SHT_NOBITS) || (sections->size[sect_idx] < pattern_len))
+        {
+            continue;
+        }
+
+        Elf_Data *elf_data = efb_elf_getdata(sections->scn[sect_idx], NULL);
+        if ((elf_data == NULL) || (elf_data->d_buf == NULL) || (elf_data->d_size < pattern_len))
+        {
+            continue;
+        }
+
+        if (chunks != NULL)
+        {
+            efb_advise_sequential(file->sElf, elf_data->d_buf, elf_data->d_size);
+        }
+
+        for (size_t offset = 0; offset + pattern_len <= elf_data->d_size; offset += SCAN_CHUNK_SIZE)
+        {
+            if (chunks != NULL)
+            {
+                size_t scan_size = elf_data->d_size - offset;
+                scan_size = (scan_size < SCAN_CHUNK_SIZE) ? scan_size : SCAN_CHUNK_SIZE;
+
+                size_t data_size = elf_data->d_size - offset;
+                data_size = (data_size < scan_size + pattern_len - 1) ? data_size : scan_size + pattern_len - 1;
+
+                chunks[chunk_count] = (scan_chunk) { sect_idx, (const unsigned char *) elf_data->d_buf + offset,
+                    scan_size, data_size, offset, false, { NULL, 0, 0 } };
+            }
+
+            chunk_count++;
+        }
+    }
+
+    return chunk_count;
+}
+
+static size_t get_scan_thread_count(const size_t chunk_count)
+{
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t thread_count = (cpu_count > 0) ? (size_t) cpu_count : 1;
+
+    thread_count = (thread_count < MAX_SCAN_THREADS) ? thread_count : MAX_SCAN_THREADS;
+    return (thread_count < chunk_count) ? thread_count : chunk_count;
+}
+
+static void append_chunk_matches(efb_byte_matches *matches, const scan_chunk *chunk)
+{
+    if (matches->count + chunk->matches.count > matches->capacity)
+    {
+        matches->capacity = matches->count + chunk->matches.count;
+        matches->entries = realloc(matches->entries, matches->capacity * sizeof(efb_byte_match));
+        if (matches->entries == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot allocate the pattern search results.");
+        }
+    }
+
+    for (size_t match_idx = 0; match_idx < chunk->matches.count; match_idx++)
+    {
+        matches->entries[matches->count++] = (efb_byte_match) { chunk->sect_idx, chunk->matches.offsets[match_idx] };
+    }
+}
+
+// Finds the pattern in the data of all sections, in section and offset order. Only getting the section
+// data goes through libelf; the scan itself reads the mapped image. On a render thread the search reports
+// its progress and stops when the job is cancelled, the results are then truncated.
+void efb_pattern_search(const efb_file *file, const unsigned char *pattern, const size_t pattern_len,
+    const size_t max_matches, efb_byte_matches *matches)
+{
+    matches->count = 0;
+    matches->truncated = false;
+
+    if (pattern_len == 0)
+    {
+        return;
+    }
+
+    scan_job job = { .scan = select_scan(), .pattern = pattern, .pattern_len = pattern_len, .max_matches = max_matches };
+    job.chunk_count = collect_chunks(file, pattern_len, NULL);
+    job.chunks = calloc((job.chunk_count > 0) ? job.chunk_count : 1, sizeof(scan_chunk));
+    if (job.chunks == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the pattern search.");
+    }
+
+    collect_chunks(file, pattern_len, job.chunks);
+    atomic_init(&job.next_chunk, 0);
+    atomic_init(&job.match_count, 0);
+    atomic_init(&job.done_count, 0);
+    atomic_init(&job.cancelled, false);
+
+    pthread_t threads[MAX_SCAN_THREADS];
+    size_t thread_count = get_scan_thread_count(job.chunk_count);
+    size_t started_count = 0;
+
+    for (; started_count + 1 < thread_count; started_count++)
+    {
+        if (pthread_create(&threads[started_count], NULL, scan_thread, &job) != 0)
+        {
+            break;
+        }
+    }
+
+    // The calling thread scans too
+    scan_chunks(&job, true);
+
+    for (size_t thread_idx = 0; thread_idx < started_count; thread_idx++)
+    {
+        pthread_join(threads[thread_idx], NULL);
+    }
+
+    // The results stay in order: they end at the first chunk which was not scanned to its end
+    for (size_t chunk_idx = 0; chunk_idx < job.chunk_count; chunk_idx++)
+    {
+        if (matches->truncated == false)
+        {
+            append_chunk_matches(matches, &job.chunks[chunk_idx]);
+            matches->truncated = (job.chunks[chunk_idx].complete == false);
+        }
+
+        free(job.chunks[chunk_idx].matches.offsets);
+    }
+
+    free(job.chunks);
+}
+
+static int hex_digit_value(const char digit)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    const char *found = (digit != '\0') ? strchr(hex_digits, tolower((unsigned char) digit)) : NULL;
+
+    return (found != NULL) ? (int) (found - hex_digits) : -1;
+}
+
+// A pattern is either hex bytes ("48 8b 05", spaces are optional) or, after a leading '"', ASCII text
+bool efb_pattern_parse(const char *text, efb_buffer *pattern)
+{
+    efb_buf_reset(pattern);
+
+    if (*text == '"')
+    {
+        text++;
+        size_t text_len = strlen(text);
+        efb_buf_append(pattern, text, (text_len > 0) && (text[text_len - 1] == '"') ? text_len - 1 : text_len);
+        return pattern->length > 0;
+    }
+
+    int high_nibble = -1;
+    for (; *text != '\0'; text++)
+    {
+        if (isspace((unsigned char) *text))
+        {
+            continue;
+        }
+
+        int nibble = hex_digit_value(*text);
+        if (nibble < 0)
+        {
+            return false;
+        }
+
+        if (high_nibble < 0)
+        {
+            high_nibble = nibble;
+        }
+        else
+        {
+            efb_buf_putc(pattern, (char) ((high_nibble << 4) | nibble));
+            high_nibble = -1;
+        }
+    }
+
+    return (high_nibble < 0) && (pattern->length > 0);
+}
@@ -0,0 +1,403 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define RENDER_THREAD_COUNT 2
+
+typedef enum
+{
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE
+} job_state;
+
+typedef struct render_job
+{
+    int item_idx;
+    void *arg;
+    bool prefetch;
+    job_state state;
+    atomic_bool cancelled;
+    atomic_size_t progress_done;
+    atomic_size_t progress_total;
+    efb_view view;
+    struct render_job *next;
+} render_job;
+
+typedef struct
+{
+    efb_render_fn render;
+    pthread_t threads[RENDER_THREAD_COUNT];
+    int thread_count;
+    pthread_mutex_t jobs_lock;
+    pthread_cond_t jobs_cond;
+    render_job *jobs;
+    bool stopping;
+} render_pool;
+
+static render_pool pool =
+{
+    .jobs_lock = PTHREAD_MUTEX_INITIALIZER,
+    .jobs_cond = PTHREAD_COND_INITIALIZER,
+};
+
+// libelf loads section data, string tables and program headers lazily and is not thread-safe;
+// the calls which may load anything are serialized by this lock. The loaded data is only read,
+// so the renderers format and index it without holding the lock.
+static pthread_mutex_t elf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local render_job *current_job = NULL;
+
+Elf_Data * efb_elf_getdata(Elf_Scn *sect, Elf_Data *data)
+{
+    pthread_mutex_lock(&elf_lock);
+    Elf_Data *next_data = elf_getdata(sect, data);
+    pthread_mutex_unlock(&elf_lock);
+
+    return next_data;
+}
+
+Elf_Data * efb_elf_rawdata(Elf_Scn *sect, Elf_Data *data)
+{
+    pthread_mutex_lock(&elf_lock);
+    Elf_Data *raw_data = elf_rawdata(sect, data);
+    pthread_mutex_unlock(&elf_lock);
+
+    return raw_data;
+}
+
+char * efb_elf_strptr(Elf *sElf, const size_t sect_idx, const size_t offset)
+{
+    pthread_mutex_lock(&elf_lock);
+    char *str = elf_strptr(sElf, sect_idx, offset);
+    pthread_mutex_unlock(&elf_lock);
+
+    return str;
+}
+
+GElf_Phdr * efb_gelf_getphdr(Elf *sElf, const int seg_idx, GElf_Phdr *prg_hdr)
+{
+    pthread_mutex_lock(&elf_lock);
+    GElf_Phdr *result = gelf_getphdr(sElf, seg_idx, prg_hdr);
+    pthread_mutex_unlock(&elf_lock);
+
+    return result;
+}
+
+GElf_Chdr * efb_gelf_getchdr(Elf_Scn *sect, GElf_Chdr *chdr)
+{
+    pthread_mutex_lock(&elf_lock);
+    GElf_Chdr *result = gelf_getchdr(sect, chdr);
+    pthread_mutex_unlock(&elf_lock);
+
+    return result;
+}
+
+static void unlink_job(render_job *job)
+{
+    render_job **ptr_job = &pool.jobs;
+
+    while (*ptr_job != job)
+    {
+        ptr_job = &(*ptr_job)->next;
+    }
+
+    *ptr_job = job->next;
+}
+
+static void free_job(render_job *job)
+{
+    efb_view_free(&job->view);
+    free(job->arg);
+    free(job);
+}
+
+// Foreground jobs go first, prefetches only when nothing else is waiting
+static render_job * next_queued_job(void)
+{
+    render_job *prefetch_job = NULL;
+
+    for (render_job *job = pool.jobs; job != NULL; job = job->next)
+    {
+        if (job->state == JOB_QUEUED)
+        {
+            if (job->prefetch == false)
+            {
+                return job;
+            }
+
+            if (prefetch_job == NULL)
+            {
+                prefetch_job = job;
+            }
+        }
+    }
+
+    return prefetch_job;
+}
+
+static void * render_thread(void *arg)
+{
+    (void) arg;
+
+    pthread_mutex_lock(&pool.jobs_lock);
+
+    while (pool.stopping == false)
+    {
+        render_job *job = next_queued_job();
+
+        if (job == NULL)
+        {
+            pthread_cond_wait(&pool.jobs_cond, &pool.jobs_lock);
+            continue;
+        }
+
+        job->state = JOB_RUNNING;
+        pthread_mutex_unlock(&pool.jobs_lock);
+
+        current_job = job;
+        if (atomic_load(&job->cancelled) == false)
+        {
+            pool.render(job->item_idx, job->arg, &job->view);
+        }
+        current_job = NULL;
+
+        pthread_mutex_lock(&pool.jobs_lock);
+        if (atomic_load(&job->cancelled))
+        {
+            unlink_job(job);
+            free_job(job);
+        }
+        else
+        {
+            job->state = JOB_DONE;
+        }
+    }
+
+    pthread_mutex_unlock(&pool.jobs_lock);
+
+    return NULL;
+}
+
+void efb_render_start(efb_render_fn render)
+{
+    pool.render = render;
+    pool.stopping = false;
+
+    for (pool.thread_count = 0; pool.thread_count < RENDER_THREAD_COUNT; pool.thread_count++)
+    {
+        if (pthread_create(&pool.threads[pool.thread_count], NULL, render_thread, NULL) != 0)
+        {
+            errx(EXIT_FAILURE, "Cannot start the render threads.");
+        }
+    }
+}
+
+void efb_render_stop(void)
+{
+    pthread_mutex_lock(&pool.jobs_lock);
+    pool.stopping = true;
+    for (render_job *job = pool.jobs; job != NULL; job = job->next)
+    {
+        atomic_store(&job->cancelled, true);
+    }
+    pthread_cond_broadcast(&pool.jobs_cond);
+    pthread_mutex_unlock(&pool.jobs_lock);
+
+    for (int idx = 0; idx < pool.thread_count; idx++)
+    {
+        pthread_join(pool.threads[idx], NULL);
+    }
+
+    pool.thread_count = 0;
+
+    while (pool.jobs != NULL)
+    {
+        render_job *job = pool.jobs;
+        pool.jobs = job->next;
+        free_job(job);
+    }
+}
+
+// Called with the jobs lock held
+static void queue_job(const int item_idx, const bool prefetch, void *arg)
+{
+    render_job *job = calloc(1, sizeof(render_job));
+    if (job == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate a render job.");
+    }
+
+    job->item_idx = item_idx;
+    job->arg = arg;
+    job->prefetch = prefetch;
+    job->state = JOB_QUEUED;
+    efb_view_init(&job->view);
+    job->next = pool.jobs;
+    pool.jobs = job;
+
+    pthread_cond_signal(&pool.jobs_cond);
+}
+
+// Called with the jobs lock held. A finished job is dropped too, so its view is never taken.
+static void cancel_job(render_job **ptr_job)
+{
+    render_job *job = *ptr_job;
+
+    atomic_store(&job->cancelled, true);
+
+    // A running job is freed by its thread once the renderer returns
+    if (job->state != JOB_RUNNING)
+    {
+        *ptr_job = job->next;
+        free_job(job);
+    }
+}
+
+// Queues the item unless it is already queued or being rendered; a foreground request
+// turns a pending prefetch of the same item into a foreground job
+void efb_render_request(const int item_idx, const bool prefetch)
+{
+    pthread_mutex_lock(&pool.jobs_lock);
+
+    for (render_job *job = pool.jobs; job != NULL; job = job->next)
+    {
+        if ((job->item_idx == item_idx) && (atomic_load(&job->cancelled) == false))
+        {
+            job->prefetch = job->prefetch && prefetch;
+            pthread_mutex_unlock(&pool.jobs_lock);
+            return;
+        }
+    }
+
+    queue_job(item_idx, prefetch, NULL);
+    pthread_mutex_unlock(&pool.jobs_lock);
+}
+
+// Called with the jobs lock held
+static void cancel_item_jobs(const int item_idx)
+{
+    render_job **ptr_job = &pool.jobs;
+    while (*ptr_job != NULL)
+    {
+        render_job *job = *ptr_job;
+
+        if (job->item_idx == item_idx)
+        {
+            cancel_job(ptr_job);
+        }
+
+        if (*ptr_job == job)
+        {
+            ptr_job = &job->next;
+        }
+    }
+}
+
+// Replaces any job of 'item_idx' by a foreground job which is passed 'arg'; the job owns 'arg' and frees it.
+// Negative indexes are for jobs which are not menu items, e.g. a byte search.
+void efb_render_submit(const int item_idx, void *arg)
+{
+    pthread_mutex_lock(&pool.jobs_lock);
+    cancel_item_jobs(item_idx);
+    queue_job(item_idx, false, arg);
+    pthread_mutex_unlock(&pool.jobs_lock);
+}
+
+// Cancels the queued, running or finished job of 'item_idx'
+void efb_render_cancel(const int item_idx)
+{
+    pthread_mutex_lock(&pool.jobs_lock);
+    cancel_item_jobs(item_idx);
+    pthread_mutex_unlock(&pool.jobs_lock);
+}
+
+// Cancels every queued or running render of a menu item except the one of 'item_idx'
+void efb_render_cancel_others(const int item_idx)
+{
+    pthread_mutex_lock(&pool.jobs_lock);
+
+    render_job **ptr_job = &pool.jobs;
+    while (*ptr_job != NULL)
+    {
+        render_job *job = *ptr_job;
+
+        if ((job->item_idx != item_idx) && (job->item_idx >= 0) && (job->state != JOB_DONE))
+        {
+            cancel_job(ptr_job);
+        }
+
+        if (*ptr_job == job)
+        {
+            ptr_job = &job->next;
+        }
+    }
+
+    pthread_mutex_unlock(&pool.jobs_lock);
+}
+
+// Hands over a finished view; returns false when no render has finished
+bool efb_render_take(int *item_idx, efb_view *view)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&pool.jobs_lock);
+
+    for (render_job *job = pool.jobs; job != NULL; job = job->next)
+    {
+        if (job->state == JOB_DONE)
+        {
+            unlink_job(job);
+            *item_idx = job->item_idx;
+            *view = job->view;
+            free(job);
+            found = true;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&pool.jobs_lock);
+
+    return found;
+}
+
+// Returns the progress of the item's render in percent, or -1 when it is not known
+int efb_render_progress(const int item_idx)
+{
+    int percent = -1;
+
+    pthread_mutex_lock(&pool.jobs_lock);
+
+    for (render_job *job = pool.jobs; job != NULL; job = job->next)
+    {
+        size_t total = atomic_load(&job->progress_total);
+
+        if ((job->item_idx == item_idx) && (job->state == JOB_RUNNING) && (atomic_load(&job->cancelled) == false) && (total > 0))
+        {
+            percent = (int) (100 * atomic_load(&job->progress_done) / total);
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&pool.jobs_lock);
+
+    return percent;
+}
+
+// Reports the progress of the running render; returns false when the render has been cancelled
+// and the renderer should stop. Outside of a render thread it always returns true.
+bool efb_render_step(const size_t done, const size_t total)
+{
+    if (current_job == NULL)
+    {
+        return true;
+    }
+
+    atomic_store(&current_job->progress_done, done);
+    atomic_store(&current_job->progress_total, total);
+
+    return atomic_load(&current_job->cancelled) == false;
+}
@@ -0,0 +1,108 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+
+static void * alloc_column(const size_t count, const size_t item_size)
+{
+    void *column = calloc(count > 0 ? count : 1, item_size);
+
+    if (column == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the section table for %zu sections.", count);
+    }
+
+    return column;
+}
+
+// Reads every section header once; the header fields are kept column by column,
+// so the views access a section by its index without walking the section list.
+// Returns false, with an empty table, if the section headers cannot be read.
+bool efb_sect_table_build(Elf *sElf, efb_sect_table *table)
+{
+    *table = (efb_sect_table) { 0 };
+
+    if ((elf_getshdrnum(sElf, &table->count) != 0) || (elf_getshdrstrndx(sElf, &table->shstrndx) != 0))
+    {
+        table->count = 0;
+        return false;
+    }
+
+    table->scn = alloc_column(table->count, sizeof(Elf_Scn *));
+    table->name = alloc_column(table->count, sizeof(char *));
+    table->name_offset = alloc_column(table->count, sizeof(GElf_Word));
+    table->type = alloc_column(table->count, sizeof(GElf_Word));
+    table->flags = alloc_column(table->count, sizeof(GElf_Xword));
+    table->addr = alloc_column(table->count, sizeof(GElf_Addr));
+    table->offset = alloc_column(table->count, sizeof(GElf_Off));
+    table->size = alloc_column(table->count, sizeof(GElf_Xword));
+    table->link = alloc_column(table->count, sizeof(GElf_Word));
+    table->info = alloc_column(table->count, sizeof(GElf_Word));
+    table->addralign = alloc_column(table->count, sizeof(GElf_Xword));
+    table->entsize = alloc_column(table->count, sizeof(GElf_Xword));
+
+    Elf_Scn *sect = NULL;
+    while ((sect = elf_nextscn(sElf, sect)) != NULL)
+    {
+        size_t sect_idx = elf_ndxscn(sect);
+        GElf_Shdr sect_header;
+
+        if ((sect_idx >= table->count) || (gelf_getshdr(sect, &sect_header) != &sect_header)
+            || ((table->name[sect_idx] = elf_strptr(sElf, table->shstrndx, sect_header.sh_name)) == NULL))
+        {
+            efb_sect_table_free(table);
+            return false;
+        }
+
+        table->scn[sect_idx] = sect;
+        table->name_offset[sect_idx] = sect_header.sh_name;
+        table->type[sect_idx] = sect_header.sh_type;
+        table->flags[sect_idx] = sect_header.sh_flags;
+        table->addr[sect_idx] = sect_header.sh_addr;
+        table->offset[sect_idx] = sect_header.sh_offset;
+        table->size[sect_idx] = sect_header.sh_size;
+        table->link[sect_idx] = sect_header.sh_link;
+        table->info[sect_idx] = sect_header.sh_info;
+        table->addralign[sect_idx] = sect_header.sh_addralign;
+        table->entsize[sect_idx] = sect_header.sh_entsize;
+    }
+
+    if (table->count > 0)
+    {
+        table->scn[0] = elf_getscn(sElf, 0);
+        table->name[0] = "";
+    }
+
+    return true;
+}
+
+void efb_sect_table_free(efb_sect_table *table)
+{
+    free(table->scn);
+    free(table->name);
+    free(table->name_offset);
+    free(table->type);
+    free(table->flags);
+    free(table->addr);
+    free(table->offset);
+    free(table->size);
+    free(table->link);
+    free(table->info);
+    free(table->addralign);
+    free(table->entsize);
+    *table = (efb_sect_table) { 0 };
+}
+
+void efb_sect_table_get_shdr(const efb_sect_table *table, const size_t sect_idx, GElf_Shdr *sect_header)
+{
+    sect_header->sh_name = table->name_offset[sect_idx];
+    sect_header->sh_type = table->type[sect_idx];
+    sect_header->sh_flags = table->flags[sect_idx];
+    sect_header->sh_addr = table->addr[sect_idx];
+    sect_header->sh_offset = table->offset[sect_idx];
+    sect_header->sh_size = table->size[sect_idx];
+    sect_header->sh_link = table->link[sect_idx];
+    sect_header->sh_info = table->info[sect_idx];
+    sect_header->sh_addralign = table->addralign[sect_idx];
+    sect_header->sh_entsize = table->entsize[sect_idx];
+}
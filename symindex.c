@@ -0,0 +1,356 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIGRAM_HASH_BITS 18
+#define TRIGRAM_BUCKET_COUNT (1u << TRIGRAM_HASH_BITS)
+
+// Names are indexed by blocks of SYMBOL_BLOCK_SIZE neighbours in the name order:
+// neighbours share most of their trigrams, so block postings are far smaller than name postings
+#define SYMBOL_BLOCK_SIZE 16
+
+typedef struct
+{
+    const char *name;
+    uint32_t sect_idx;
+    uint32_t sym_idx;
+    GElf_Addr value;
+} index_entry;
+
+static void * alloc_index_array(const size_t count, const size_t item_size)
+{
+    void *array = malloc((count > 0 ? count : 1) * item_size);
+
+    if (array == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the symbol index for %zu items.", count);
+    }
+
+    return array;
+}
+
+static inline uint32_t get_trigram_bucket(const char *str)
+{
+    uint32_t trigram = ((uint32_t) (unsigned char) str[0] << 16) | ((uint32_t) (unsigned char) str[1] << 8) | (unsigned char) str[2];
+
+    return (trigram * 2654435761u) >> (32 - TRIGRAM_HASH_BITS);
+}
+
+static int compare_entries(const void *left, const void *right)
+{
+    const index_entry *left_entry = left;
+    const index_entry *right_entry = right;
+    int result = strcmp(left_entry->name, right_entry->name);
+
+    if (result != 0)
+    {
+        return result;
+    }
+
+    if (left_entry->sect_idx != right_entry->sect_idx)
+    {
+        return (left_entry->sect_idx < right_entry->sect_idx) ? -1 : 1;
+    }
+
+    return (left_entry->sym_idx < right_entry->sym_idx) ? -1 : (left_entry->sym_idx > right_entry->sym_idx);
+}
+
+static size_t collect_entries(const efb_file *file, index_entry *entries)
+{
+    const efb_sect_table *sections = &file->sections;
+    size_t entry_count = 0;
+
+    for (size_t sect_idx = 1; sect_idx < sections->count; sect_idx++)
+    {
+        if (((sections->type[sect_idx] != SHT_SYMTAB) && (sections->type[sect_idx] != SHT_DYNSYM))
+            || (sections->entsize[sect_idx] == 0))
+        {
+            continue;
+        }
+
+        Elf_Data *sym_data = efb_elf_getdata(sections->scn[sect_idx], NULL);
+        Elf_Data *str_data = NULL;
+
+        if (sections->link[sect_idx] < sections->count)
+        {
+            str_data = efb_elf_getdata(sections->scn[sections->link[sect_idx]], NULL);
+        }
+
+        if (sym_data == NULL)
+        {
+            continue;
+        }
+
+        size_t sym_count = sym_data->d_size / sections->entsize[sect_idx];
+        for (size_t sym_idx = 1; sym_idx < sym_count; sym_idx++)
+        {
+            GElf_Sym sym;
+            if (gelf_getsym(sym_data, sym_idx, &sym) != &sym)
+            {
+                continue;
+            }
+
+            const char *name = efb_get_sym_name(str_data, sym.st_name);
+            if ((entries != NULL) && (*name != '\0'))
+            {
+                entries[entry_count] = (index_entry) { name, sect_idx, sym_idx, sym.st_value };
+            }
+
+            entry_count += (*name != '\0') ? 1 : 0;
+        }
+    }
+
+    return entry_count;
+}
+
+// Collects the named symbols of all SYMTAB and DYNSYM sections, sorts them by name
+// and indexes the trigrams of the names
+void efb_sym_index_build(const efb_file *file, efb_sym_index *index)
+{
+    size_t entry_count = collect_entries(file, NULL);
+    index_entry *entries = alloc_index_array(entry_count, sizeof(index_entry));
+
+    collect_entries(file, entries);
+    qsort(entries, entry_count, sizeof(index_entry), compare_entries);
+
+    index->count = entry_count;
+    index->names = alloc_index_array(entry_count, sizeof(char *));
+    index->sect_idx = alloc_index_array(entry_count, sizeof(uint32_t));
+    index->sym_idx = alloc_index_array(entry_count, sizeof(uint32_t));
+    index->value = alloc_index_array(entry_count, sizeof(GElf_Addr));
+
+    for (size_t entry_idx = 0; entry_idx < entry_count; entry_idx++)
+    {
+        index->names[entry_idx] = entries[entry_idx].name;
+        index->sect_idx[entry_idx] = entries[entry_idx].sect_idx;
+        index->sym_idx[entry_idx] = entries[entry_idx].sym_idx;
+        index->value[entry_idx] = entries[entry_idx].value;
+    }
+
+    free(entries);
+
+    // Two passes over the blocks: count the postings of each trigram bucket, then fill them in
+    size_t block_count = (entry_count + SYMBOL_BLOCK_SIZE - 1) / SYMBOL_BLOCK_SIZE;
+    uint32_t *last_block = alloc_index_array(TRIGRAM_BUCKET_COUNT, sizeof(uint32_t));
+    index->trigram_start = calloc(TRIGRAM_BUCKET_COUNT + 1, sizeof(uint32_t));
+    if (index->trigram_start == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the symbol index.");
+    }
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        memset(last_block, 0xff, TRIGRAM_BUCKET_COUNT * sizeof(uint32_t));
+
+        if (pass == 1)
+        {
+            for (size_t bucket = 0; bucket < TRIGRAM_BUCKET_COUNT; bucket++)
+            {
+                index->trigram_start[bucket + 1] += index->trigram_start[bucket];
+            }
+
+            index->trigram_blocks = alloc_index_array(index->trigram_start[TRIGRAM_BUCKET_COUNT], sizeof(uint32_t));
+        }
+
+        uint32_t *fill_pos = (pass == 1) ? alloc_index_array(TRIGRAM_BUCKET_COUNT, sizeof(uint32_t)) : NULL;
+        if (fill_pos != NULL)
+        {
+            memcpy(fill_pos, index->trigram_start, TRIGRAM_BUCKET_COUNT * sizeof(uint32_t));
+        }
+
+        for (size_t block_idx = 0; block_idx < block_count; block_idx++)
+        {
+            size_t last_entry = (block_idx + 1) * SYMBOL_BLOCK_SIZE;
+            if (last_entry > entry_count)
+            {
+                last_entry = entry_count;
+            }
+
+            for (size_t entry_idx = block_idx * SYMBOL_BLOCK_SIZE; entry_idx < last_entry; entry_idx++)
+            {
+                const char *name = index->names[entry_idx];
+
+                for (size_t char_idx = 0; (name[char_idx] != '\0') && (name[char_idx + 1] != '\0') && (name[char_idx + 2] != '\0'); char_idx++)
+                {
+                    uint32_t bucket = get_trigram_bucket(&name[char_idx]);
+                    if (last_block[bucket] == block_idx)
+                    {
+                        continue;
+                    }
+
+                    last_block[bucket] = block_idx;
+                    if (pass == 0)
+                    {
+                        index->trigram_start[bucket + 1]++;
+                    }
+                    else
+                    {
+                        index->trigram_blocks[fill_pos[bucket]++] = block_idx;
+                    }
+                }
+            }
+        }
+
+        free(fill_pos);
+    }
+
+    free(last_block);
+}
+
+void efb_sym_index_free(efb_sym_index *index)
+{
+    free(index->names);
+    free(index->sect_idx);
+    free(index->sym_idx);
+    free(index->value);
+    free(index->trigram_start);
+    free(index->trigram_blocks);
+    memset(index, 0, sizeof(efb_sym_index));
+}
+
+static void add_result(efb_sym_matches *matches, const size_t entry_idx)
+{
+    if (matches->count == matches->capacity)
+    {
+        matches->capacity = (matches->capacity == 0) ? 256 : matches->capacity * 2;
+        matches->entries = realloc(matches->entries, matches->capacity * sizeof(uint32_t));
+        if (matches->entries == NULL)
+        {
+            errx(EXIT_FAILURE, "Cannot allocate %zu symbol search results.", matches->capacity);
+        }
+    }
+
+    matches->entries[matches->count++] = entry_idx;
+}
+
+static bool contains_block(const efb_sym_index *index, const uint32_t bucket, const uint32_t block_idx)
+{
+    const uint32_t *blocks = &index->trigram_blocks[index->trigram_start[bucket]];
+    size_t low = 0;
+    size_t high = index->trigram_start[bucket + 1] - index->trigram_start[bucket];
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (blocks[mid] < block_idx)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return (low < index->trigram_start[bucket + 1] - index->trigram_start[bucket]) && (blocks[low] == block_idx);
+}
+
+static void search_prefix(const efb_sym_index *index, const char *prefix, efb_sym_matches *matches)
+{
+    size_t prefix_len = strlen(prefix);
+    size_t low = 0;
+    size_t high = index->count;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (strncmp(index->names[mid], prefix, prefix_len) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    for (size_t entry_idx = low; (entry_idx < index->count) && (strncmp(index->names[entry_idx], prefix, prefix_len) == 0); entry_idx++)
+    {
+        add_result(matches, entry_idx);
+    }
+}
+
+static void search_substring(const efb_sym_index *index, const char *query, efb_sym_matches *matches)
+{
+    size_t query_len = strlen(query);
+
+    if (query_len < 3)
+    {
+        for (size_t entry_idx = 0; entry_idx < index->count; entry_idx++)
+        {
+            if (strstr(index->names[entry_idx], query) != NULL)
+            {
+                add_result(matches, entry_idx);
+            }
+        }
+
+        return;
+    }
+
+    // Candidate blocks come from the rarest trigram of the query, the others filter them
+    size_t trigram_count = query_len - 2;
+    uint32_t *buckets = alloc_index_array(trigram_count, sizeof(uint32_t));
+    size_t rarest = 0;
+
+    for (size_t char_idx = 0; char_idx < trigram_count; char_idx++)
+    {
+        buckets[char_idx] = get_trigram_bucket(&query[char_idx]);
+
+        uint32_t bucket_size = index->trigram_start[buckets[char_idx] + 1] - index->trigram_start[buckets[char_idx]];
+        uint32_t rarest_size = index->trigram_start[buckets[rarest] + 1] - index->trigram_start[buckets[rarest]];
+        if (bucket_size < rarest_size)
+        {
+            rarest = char_idx;
+        }
+    }
+
+    for (uint32_t posting = index->trigram_start[buckets[rarest]]; posting < index->trigram_start[buckets[rarest] + 1]; posting++)
+    {
+        uint32_t block_idx = index->trigram_blocks[posting];
+        bool candidate = true;
+
+        for (size_t char_idx = 0; (char_idx < trigram_count) && candidate; char_idx++)
+        {
+            candidate = (char_idx == rarest) || contains_block(index, buckets[char_idx], block_idx);
+        }
+
+        size_t last_entry = ((size_t) block_idx + 1) * SYMBOL_BLOCK_SIZE;
+        if (last_entry > index->count)
+        {
+            last_entry = index->count;
+        }
+
+        for (size_t entry_idx = (size_t) block_idx * SYMBOL_BLOCK_SIZE; candidate && (entry_idx < last_entry); entry_idx++)
+        {
+            if (strstr(index->names[entry_idx], query) != NULL)
+            {
+                add_result(matches, entry_idx);
+            }
+        }
+    }
+
+    free(buckets);
+}
+
+// A query starting with '^' matches the name prefix, otherwise any part of the name;
+// the matches are in the name order
+void efb_sym_index_search(const efb_sym_index *index, const char *query, efb_sym_matches *matches)
+{
+    matches->count = 0;
+
+    if (*query == '\0')
+    {
+        return;
+    }
+
+    if (*query == '^')
+    {
+        search_prefix(index, query + 1, matches);
+    }
+    else
+    {
+        search_substring(index, query, matches);
+    }
+}
@@ -0,0 +1,190 @@
+#include "elfibia.h"
+
+#include <err.h>
+#include <stdlib.h>
+
+struct efb_cache_entry
+{
+    efb_view view;
+    int item_idx;
+    size_t size;
+    efb_cache_entry *prev;
+    efb_cache_entry *next;
+};
+
+static size_t get_view_size(const efb_view *view)
+{
+    return sizeof(efb_cache_entry) + view->text.capacity
+        + view->text.line_capacity * sizeof(size_t)
+        + view->block_capacity * sizeof(efb_view_block)
+        + view->rows_data_size;
+}
+
+static void unlink_entry(efb_view_cache *cache, efb_cache_entry *entry)
+{
+    if (entry->prev != NULL)
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        cache->most_recent = entry->next;
+    }
+
+    if (entry->next != NULL)
+    {
+        entry->next->prev = entry->prev;
+    }
+    else
+    {
+        cache->least_recent = entry->prev;
+    }
+
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+static void link_most_recent(efb_view_cache *cache, efb_cache_entry *entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->most_recent;
+
+    if (cache->most_recent != NULL)
+    {
+        cache->most_recent->prev = entry;
+    }
+    else
+    {
+        cache->least_recent = entry;
+    }
+
+    cache->most_recent = entry;
+}
+
+static void remove_entry(efb_view_cache *cache, efb_cache_entry *entry)
+{
+    unlink_entry(cache, entry);
+    cache->entries[entry->item_idx] = NULL;
+    cache->used_size -= entry->size;
+    efb_view_free(&entry->view);
+    free(entry);
+}
+
+void efb_cache_init(efb_view_cache *cache, const size_t item_count, const size_t max_size)
+{
+    cache->item_count = item_count;
+    cache->max_size = max_size;
+    cache->used_size = 0;
+    cache->most_recent = NULL;
+    cache->least_recent = NULL;
+    cache->pinned_item = -1;
+
+    if ((cache->entries = calloc(item_count, sizeof(efb_cache_entry *))) == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate the view cache for %zu items.", item_count);
+    }
+}
+
+void efb_cache_free(efb_view_cache *cache)
+{
+    while (cache->most_recent != NULL)
+    {
+        remove_entry(cache, cache->most_recent);
+    }
+
+    free(cache->entries);
+    cache->entries = NULL;
+}
+
+// Keeps the item's view (the displayed one) from being evicted
+void efb_cache_pin(efb_view_cache *cache, const int item_idx)
+{
+    cache->pinned_item = item_idx;
+}
+
+bool efb_cache_contains(const efb_view_cache *cache, const int item_idx)
+{
+    return cache->entries[item_idx] != NULL;
+}
+
+// Returns the cached view of the item and marks it as the most recently used one
+efb_view * efb_cache_get(efb_view_cache *cache, const int item_idx)
+{
+    efb_cache_entry *entry = cache->entries[item_idx];
+
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    unlink_entry(cache, entry);
+    link_most_recent(cache, entry);
+
+    return &entry->view;
+}
+
+// Adds an empty view for the item; it is accounted in the cache size once efb_cache_commit() is called
+efb_view * efb_cache_add(efb_view_cache *cache, const int item_idx)
+{
+    efb_cache_entry *entry = cache->entries[item_idx];
+
+    if (entry != NULL)
+    {
+        remove_entry(cache, entry);
+    }
+
+    if ((entry = malloc(sizeof(efb_cache_entry))) == NULL)
+    {
+        errx(EXIT_FAILURE, "Cannot allocate a view cache entry.");
+    }
+
+    efb_view_init(&entry->view);
+    entry->item_idx = item_idx;
+    entry->size = 0;
+    cache->entries[item_idx] = entry;
+    link_most_recent(cache, entry);
+
+    return &entry->view;
+}
+
+// Accounts the rendered view of the item and evicts the least recently used views
+// above the size limit; the item's own view and the pinned one are always kept
+void efb_cache_commit(efb_view_cache *cache, const int item_idx)
+{
+    efb_cache_entry *entry = cache->entries[item_idx];
+    efb_cache_entry *evicted_entry = cache->least_recent;
+
+    cache->used_size -= entry->size;
+    entry->size = get_view_size(&entry->view);
+    cache->used_size += entry->size;
+
+    while ((cache->used_size > cache->max_size) && (evicted_entry != NULL))
+    {
+        efb_cache_entry *prev_entry = evicted_entry->prev;
+
+        if ((evicted_entry != entry) && (evicted_entry->item_idx != cache->pinned_item))
+        {
+            remove_entry(cache, evicted_entry);
+        }
+
+        evicted_entry = prev_entry;
+    }
+}
+
+// Moves a view rendered outside of the cache into it
+void efb_cache_put(efb_view_cache *cache, const int item_idx, efb_view *view)
+{
+    efb_view *cached_view = efb_cache_add(cache, item_idx);
+
+    efb_view_free(cached_view);
+    *cached_view = *view;
+    efb_cache_commit(cache, item_idx);
+}
+
+void efb_cache_invalidate(efb_view_cache *cache, const int item_idx)
+{
+    if (cache->entries[item_idx] != NULL)
+    {
+        remove_entry(cache, cache->entries[item_idx]);
+    }
+}